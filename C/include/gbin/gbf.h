@@ -44,6 +44,43 @@ typedef struct gbf_write_options {
     int zlib_level; /* -1 = zlib default */
 } gbf_write_options_t;
 
+/* Defaults: AUTO compression with zlib, CRC32 on, library-default level. */
+gbf_write_options_t gbf_write_options_default(void);
+
+/* Codec choice for gbf_write_file_ex(). */
+typedef struct gbf_codec_options {
+    const char* codec; /* registry name used when compressing; NULL => "zlib" */
+    int level;         /* level for non-zlib codecs; 0 = codec default (zlib uses zlib_level) */
+} gbf_codec_options_t;
+
+/* ===== Compression codecs ===== */
+
+/*
+ * Field payloads are compressed by a named codec. The name is stored in the
+ * header ("compression") and looked up again when reading.
+ *
+ * Built-in: "zlib" always; "zstd" / "lz4" when the library was built with them.
+ * "none" is implicit and cannot be registered.
+ */
+typedef struct gbf_codec {
+    const char* name; /* must outlive the registry (use a string literal) */
+    /* Worst-case compressed size for src_len input bytes (0 => input too large). */
+    size_t (*bound)(size_t src_len);
+    /* Returns 1 on success and stores the compressed size in *out_len. */
+    int (*compress)(const uint8_t* src, size_t src_len,
+                    uint8_t* dst, size_t dst_cap, size_t* out_len, int level);
+    /* Returns 1 only if exactly dst_len bytes were produced. */
+    int (*decompress)(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_len);
+} gbf_codec_t;
+
+/* Add a codec. Thread-safe. Returns 0 if the name is invalid ("none", "extents") or already
+ * registered: codecs are never replaced, so pointers from gbf_find_codec() stay valid. */
+int gbf_register_codec(const gbf_codec_t* codec);
+/* NULL if the codec is unknown. */
+const gbf_codec_t* gbf_find_codec(const char* name);
+size_t gbf_codec_count(void);
+const gbf_codec_t* gbf_codec_at(size_t idx);
+
 /* ===== Header model ===== */
 
 typedef struct gbf_field_meta {
@@ -54,7 +91,7 @@ typedef struct gbf_field_meta {
     size_t shape_len;
     int complex;
     char* encoding;    /* optional (e.g. utf-16-codeunits) */
-    char* compression; /* "none" or "zlib" */
+    char* compression; /* "none" or a codec name ("zlib", "zstd", ...) */
 
     uint64_t offset; /* relative to payload_start */
     uint64_t csize;
@@ -280,6 +317,14 @@ int gbf_write_file(
     gbf_write_options_t opt,
     gbf_error_t* err);
 
+/* gbf_write_file compressing with the codec in `codec` (NULL => zlib, as gbf_write_file). */
+int gbf_write_file_ex(
+    const char* path,
+    const gbf_value_t* root, /* must be struct */
+    gbf_write_options_t opt,
+    const gbf_codec_options_t* codec,
+    gbf_error_t* err);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
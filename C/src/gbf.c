@@ -1282,18 +1282,21 @@ static int maybe_decompress(
         return 1;
     }
 
-    if (strcmp(meta->compression, "zlib") == 0) {
+    if (meta->compression && *meta->compression && strcmp(meta->compression, "none") != 0) {
+        const gbf_codec_t* codec = gbf_find_codec(meta->compression);
+        if (!codec) {
+            gbf_set_err(err, "unsupported compression codec '%s'", meta->compression);
+            return 0;
+        }
         if (meta->usize > (uint64_t)SIZE_MAX) {
             gbf_set_err(err, "usize too large");
             return 0;
         }
         size_t usize = (size_t)meta->usize;
         uint8_t* ubuf = (uint8_t*)gbf_xmalloc(usize);
-        uLongf dst_len = (uLongf)usize;
-        int rc = uncompress((Bytef*)ubuf, &dst_len, (const Bytef*)cbuf, (uLong)cbuf_len);
-        if (rc != Z_OK || (size_t)dst_len != usize) {
+        if (!codec->decompress(cbuf, cbuf_len, ubuf, usize)) {
             free(ubuf);
-            gbf_set_err(err, "zlib uncompress failed (rc=%d)", rc);
+            gbf_set_err(err, "%s decompress failed", codec->name);
             return 0;
         }
         *out_ubuf = ubuf;
@@ -1372,11 +1375,11 @@ int gbf_read_file(
         if (opt.validate && ubuf_len > 0) {
             uint32_t got = (uint32_t)crc32(0u, (const Bytef*)ubuf, (uInt)ubuf_len);
             if (got != meta->crc32) {
+                gbf_set_err(err, "field CRC mismatch for '%s': expected=%08X got=%08X", meta->name, meta->crc32, got);
                 free(ubuf);
                 fclose(f);
                 gbf_header_free(hdr);
                 gbf_value_free(root);
-                gbf_set_err(err, "field CRC mismatch for '%s': expected=%08X got=%08X", meta->name, meta->crc32, got);
                 return 0;
             }
         }
@@ -1898,6 +1901,7 @@ static void crc_hex8(uint32_t crc, char out[9]) {
 static int compress_maybe(
     const uint8_t* src, size_t src_len,
     gbf_write_options_t opt,
+    const gbf_codec_options_t* copt,
     char** out_comp_name,
     uint8_t** out_buf,
     size_t* out_len,
@@ -1912,8 +1916,6 @@ static int compress_maybe(
         return 1;
     }
 
-    int level = (opt.zlib_level < 0) ? Z_DEFAULT_COMPRESSION : opt.zlib_level;
-
     if (opt.compression == GBF_COMP_NEVER) {
         *out_comp_name = gbf_strdup("none");
         uint8_t* b = (uint8_t*)gbf_xmalloc(src_len);
@@ -1923,30 +1925,40 @@ static int compress_maybe(
         return 1;
     }
 
-    /* try zlib */
-    uLongf bound = compressBound((uLong)src_len);
-    uint8_t* comp = (uint8_t*)gbf_xmalloc((size_t)bound);
-    uLongf comp_len = bound;
+    const char* codec_name = (copt && copt->codec) ? copt->codec : "zlib";
+    const gbf_codec_t* codec = gbf_find_codec(codec_name);
+    if (!codec) {
+        gbf_set_err(err, "unsupported compression codec '%s'", codec_name);
+        return 0;
+    }
+    int level = (strcmp(codec->name, "zlib") == 0) ? opt.zlib_level : (copt ? copt->level : 0);
+
+    size_t bound = codec->bound(src_len);
+    if (bound == 0) {
+        gbf_set_err(err, "%s: input too large (%zu bytes)", codec->name, src_len);
+        return 0;
+    }
+    uint8_t* comp = (uint8_t*)gbf_xmalloc(bound);
+    size_t comp_len = 0;
 
-    int rc = compress2((Bytef*)comp, &comp_len, (const Bytef*)src, (uLong)src_len, level);
-    if (rc != Z_OK) {
+    if (!codec->compress(src, src_len, comp, bound, &comp_len, level)) {
         free(comp);
-        gbf_set_err(err, "zlib compress failed (rc=%d)", rc);
+        gbf_set_err(err, "%s compress failed", codec->name);
         return 0;
     }
 
-    int use_zlib = 0;
+    int use_codec = 0;
     if (opt.compression == GBF_COMP_ALWAYS) {
-        use_zlib = 1;
+        use_codec = 1;
     } else {
         /* auto */
-        use_zlib = (comp_len < src_len) ? 1 : 0;
+        use_codec = (comp_len < src_len) ? 1 : 0;
     }
 
-    if (use_zlib) {
-        *out_comp_name = gbf_strdup("zlib");
+    if (use_codec) {
+        *out_comp_name = gbf_strdup(codec->name);
         *out_buf = comp;
-        *out_len = (size_t)comp_len;
+        *out_len = comp_len;
         return 1;
     }
 
@@ -1967,6 +1979,7 @@ static int flatten_fields_rec(
     size_t* out_len,
     size_t* out_cap,
     gbf_write_options_t opt,
+    const gbf_codec_options_t* copt,
     gbf_error_t* err)
 {
     if (!v) return 1;
@@ -2011,7 +2024,7 @@ static int flatten_fields_rec(
             }
             if (!gbf_sb_append_byte(&p, 0)) { gbf_sb_free(&p); return 0; }
 
-            int ok = flatten_fields_rec(child, p.data, out_fields, out_len, out_cap, opt, err);
+            int ok = flatten_fields_rec(child, p.data, out_fields, out_len, out_cap, opt, copt, err);
             gbf_sb_free(&p);
             if (!ok) return 0;
         }
@@ -2135,7 +2148,7 @@ static int flatten_fields_rec(
     size_t payload_len = 0;
     char* comp_name = NULL;
 
-    if (!compress_maybe((const uint8_t*)raw.data, raw.len, opt, &comp_name, &payload, &payload_len, err)) {
+    if (!compress_maybe((const uint8_t*)raw.data, raw.len, opt, copt, &comp_name, &payload, &payload_len, err)) {
         gbf_sb_free(&raw);
         writer_field_free(&f);
         return 0;
@@ -2150,11 +2163,30 @@ static int flatten_fields_rec(
     return push_writer_field(out_fields, out_len, out_cap, &f);
 }
 
+gbf_write_options_t gbf_write_options_default(void) {
+    gbf_write_options_t opt;
+    memset(&opt, 0, sizeof(opt));
+    opt.compression = GBF_COMP_AUTO;
+    opt.include_crc32 = 1;
+    opt.zlib_level = -1;
+    return opt;
+}
+
 int gbf_write_file(
     const char* path,
     const gbf_value_t* root,
     gbf_write_options_t opt,
     gbf_error_t* err)
+{
+    return gbf_write_file_ex(path, root, opt, NULL, err);
+}
+
+int gbf_write_file_ex(
+    const char* path,
+    const gbf_value_t* root,
+    gbf_write_options_t opt,
+    const gbf_codec_options_t* copt,
+    gbf_error_t* err)
 {
     if (!path || !*path) {
         gbf_set_err(err, "write: path is empty");
@@ -2172,7 +2204,7 @@ int gbf_write_file(
     size_t fields_len = 0;
     size_t fields_cap = 0;
 
-    if (!flatten_fields_rec(root, "", &fields, &fields_len, &fields_cap, opt, err)) {
+    if (!flatten_fields_rec(root, "", &fields, &fields_len, &fields_cap, opt, copt, err)) {
         if (fields) {
             for (size_t i = 0; i < fields_len; i++) writer_field_free(&fields[i]);
         }
@@ -0,0 +1,193 @@
+
+#include "gbin/gbf.h"
+
+#include <limits.h>
+#include <string.h>
+
+#include <zlib.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#if defined(GBIN_HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+#if defined(GBIN_HAVE_LZ4)
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
+/* ===== built-in codecs ===== */
+
+static size_t zlib_bound(size_t src_len) {
+    return (size_t)compressBound((uLong)src_len);
+}
+
+static int zlib_compress(const uint8_t* src, size_t src_len,
+                         uint8_t* dst, size_t dst_cap, size_t* out_len, int level) {
+    uLongf dst_len = (uLongf)dst_cap;
+    if (level < -1 || level > 9) level = Z_DEFAULT_COMPRESSION;
+    int rc = compress2((Bytef*)dst, &dst_len, (const Bytef*)src, (uLong)src_len, level);
+    if (rc != Z_OK) return 0;
+    *out_len = (size_t)dst_len;
+    return 1;
+}
+
+static int zlib_decompress(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_len) {
+    uLongf got = (uLongf)dst_len;
+    int rc = uncompress((Bytef*)dst, &got, (const Bytef*)src, (uLong)src_len);
+    return (rc == Z_OK && (size_t)got == dst_len) ? 1 : 0;
+}
+
+#if defined(GBIN_HAVE_ZSTD)
+static size_t zstd_bound(size_t src_len) {
+    return ZSTD_compressBound(src_len);
+}
+
+static int zstd_compress(const uint8_t* src, size_t src_len,
+                         uint8_t* dst, size_t dst_cap, size_t* out_len, int level) {
+    /* -1 follows the zlib convention of "library default" */
+    size_t rc = ZSTD_compress(dst, dst_cap, src, src_len, level < 0 ? 0 : level);
+    if (ZSTD_isError(rc)) return 0;
+    *out_len = rc;
+    return 1;
+}
+
+static int zstd_decompress(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_len) {
+    size_t rc = ZSTD_decompress(dst, dst_len, src, src_len);
+    return (!ZSTD_isError(rc) && rc == dst_len) ? 1 : 0;
+}
+#endif
+
+#if defined(GBIN_HAVE_LZ4)
+static size_t lz4_bound(size_t src_len) {
+    if (src_len > (size_t)LZ4_MAX_INPUT_SIZE) return 0;
+    return (size_t)LZ4_compressBound((int)src_len);
+}
+
+static int lz4_compress(const uint8_t* src, size_t src_len,
+                        uint8_t* dst, size_t dst_cap, size_t* out_len, int level) {
+    if (src_len > (size_t)LZ4_MAX_INPUT_SIZE) return 0;
+    int cap = dst_cap > (size_t)INT_MAX ? INT_MAX : (int)dst_cap;
+    int n = (level > 0)
+        ? LZ4_compress_HC((const char*)src, (char*)dst, (int)src_len, cap, level)
+        : LZ4_compress_default((const char*)src, (char*)dst, (int)src_len, cap);
+    if (n <= 0) return 0;
+    *out_len = (size_t)n;
+    return 1;
+}
+
+static int lz4_decompress(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_len) {
+    if (src_len > (size_t)INT_MAX || dst_len > (size_t)INT_MAX) return 0;
+    int n = LZ4_decompress_safe((const char*)src, (char*)dst, (int)src_len, (int)dst_len);
+    return (n >= 0 && (size_t)n == dst_len) ? 1 : 0;
+}
+#endif
+
+/* ===== registry =====
+ *
+ * Entries are only ever appended and never overwritten, so pointers handed out by
+ * gbf_find_codec()/gbf_codec_at() stay valid while other threads register codecs. The built-ins
+ * are added exactly once; every access to the table holds the lock. */
+
+#define GBF_MAX_CODECS 16
+
+static gbf_codec_t g_codecs[GBF_MAX_CODECS];
+static size_t g_codecs_len = 0;
+
+static void add_builtin_codecs(void);
+
+#if defined(_WIN32)
+static INIT_ONCE g_codecs_once = INIT_ONCE_STATIC_INIT;
+static SRWLOCK g_codecs_lock = SRWLOCK_INIT;
+
+static BOOL CALLBACK builtin_codecs_once(PINIT_ONCE once, PVOID param, PVOID* ctx) {
+    (void)once; (void)param; (void)ctx;
+    add_builtin_codecs();
+    return TRUE;
+}
+
+static void lock_codecs(void) {
+    InitOnceExecuteOnce(&g_codecs_once, builtin_codecs_once, NULL, NULL);
+    AcquireSRWLockExclusive(&g_codecs_lock);
+}
+
+static void unlock_codecs(void) { ReleaseSRWLockExclusive(&g_codecs_lock); }
+#else
+static pthread_once_t g_codecs_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t g_codecs_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void lock_codecs(void) {
+    pthread_once(&g_codecs_once, add_builtin_codecs);
+    pthread_mutex_lock(&g_codecs_lock);
+}
+
+static void unlock_codecs(void) { pthread_mutex_unlock(&g_codecs_lock); }
+#endif
+
+/* Caller holds the lock (or is the one-time init). Returns 0 if the name is taken or the
+ * table is full. */
+static int put_codec(const gbf_codec_t* c) {
+    for (size_t i = 0; i < g_codecs_len; i++) {
+        if (strcmp(g_codecs[i].name, c->name) == 0) return 0;
+    }
+    if (g_codecs_len >= GBF_MAX_CODECS) return 0;
+    g_codecs[g_codecs_len++] = *c;
+    return 1;
+}
+
+static void add_builtin_codecs(void) {
+    gbf_codec_t z = { "zlib", zlib_bound, zlib_compress, zlib_decompress };
+    put_codec(&z);
+#if defined(GBIN_HAVE_ZSTD)
+    gbf_codec_t zs = { "zstd", zstd_bound, zstd_compress, zstd_decompress };
+    put_codec(&zs);
+#endif
+#if defined(GBIN_HAVE_LZ4)
+    gbf_codec_t l = { "lz4", lz4_bound, lz4_compress, lz4_decompress };
+    put_codec(&l);
+#endif
+}
+
+int gbf_register_codec(const gbf_codec_t* codec) {
+    if (!codec || !codec->name || !*codec->name) return 0;
+    if (!codec->bound || !codec->compress || !codec->decompress) return 0;
+    if (strcmp(codec->name, "none") == 0 || strcmp(codec->name, "extents") == 0) return 0;
+
+    lock_codecs();
+    int ok = put_codec(codec);
+    unlock_codecs();
+    return ok;
+}
+
+const gbf_codec_t* gbf_find_codec(const char* name) {
+    if (!name) return NULL;
+    const gbf_codec_t* found = NULL;
+    lock_codecs();
+    for (size_t i = 0; i < g_codecs_len; i++) {
+        if (strcmp(g_codecs[i].name, name) == 0) {
+            found = &g_codecs[i];
+            break;
+        }
+    }
+    unlock_codecs();
+    return found;
+}
+
+size_t gbf_codec_count(void) {
+    lock_codecs();
+    size_t n = g_codecs_len;
+    unlock_codecs();
+    return n;
+}
+
+const gbf_codec_t* gbf_codec_at(size_t idx) {
+    lock_codecs();
+    const gbf_codec_t* c = (idx < g_codecs_len) ? &g_codecs[idx] : NULL;
+    unlock_codecs();
+    return c;
+}
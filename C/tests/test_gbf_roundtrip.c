@@ -200,9 +200,65 @@ static void test_crc_detection(void) {
     remove(path);
 }
 
+static void test_codecs(void) {
+    const char* path = "test_codecs.gbf";
+    gbf_error_t err = {0};
+    gbf_read_options_t ropt = {1};
+
+    /* every registered codec must round-trip */
+    ASSERT_TRUE(gbf_find_codec("zlib") != NULL);
+    for (size_t i = 0; i < gbf_codec_count(); i++) {
+        const gbf_codec_t* c = gbf_codec_at(i);
+        remove_if_exists(path);
+
+        gbf_value_t* root = NULL;
+        build_sample(&root);
+        gbf_write_options_t wopt = gbf_write_options_default();
+        wopt.compression = GBF_COMP_ALWAYS;
+        gbf_codec_options_t copt = { c->name, 0 };
+        ASSERT_TRUE(gbf_write_file_ex(path, root, wopt, &copt, &err));
+        assert_err_ok(&err);
+        gbf_value_free(root);
+
+        gbf_value_t* back = NULL;
+        gbf_header_t* h = NULL;
+        ASSERT_TRUE(gbf_read_file(path, ropt, &back, &h, &err));
+        assert_err_ok(&err);
+        ASSERT_TRUE(strcmp(h->fields[0].compression, c->name) == 0);
+        gbf_header_free(h);
+        gbf_value_free(back);
+    }
+
+    /* registered codecs are never replaced; reserved names are rejected */
+    {
+        const gbf_codec_t* zlib = gbf_find_codec("zlib");
+        gbf_codec_t dup = *zlib;
+        ASSERT_TRUE(gbf_register_codec(&dup) == 0);
+        ASSERT_TRUE(gbf_find_codec("zlib") == zlib);
+        dup.name = "extents";
+        ASSERT_TRUE(gbf_register_codec(&dup) == 0);
+        dup.name = "zlib-copy";
+        ASSERT_TRUE(gbf_register_codec(&dup) == 1);
+        ASSERT_TRUE(gbf_find_codec("zlib-copy") != NULL && gbf_find_codec("zlib") == zlib);
+    }
+
+    /* unknown codec is rejected on write */
+    gbf_value_t* root = NULL;
+    build_sample(&root);
+    gbf_write_options_t wopt = gbf_write_options_default();
+    gbf_codec_options_t copt = { "no-such-codec", 0 };
+    ASSERT_TRUE(gbf_write_file_ex(path, root, wopt, &copt, &err) == 0);
+    ASSERT_TRUE(err.message != NULL);
+    gbf_free_error(&err);
+    gbf_value_free(root);
+
+    remove(path);
+}
+
 int main(void) {
     test_roundtrip();
     test_crc_detection();
+    test_codecs();
     printf("OK\n");
     return 0;
 }
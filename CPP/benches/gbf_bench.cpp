@@ -1,14 +1,47 @@
 
 #include "gbin/gbf.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdlib>
 #include <cstring>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <new>
 #include <random>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Counts heap allocations made through operator new, for the allocation benchmarks.
+static std::atomic<std::size_t> g_allocs{0};
+
+void* operator new(std::size_t n) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t n, std::align_val_t al) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t a = static_cast<std::size_t>(al);
+    if (void* p = std::aligned_alloc(a, (std::max<std::size_t>(n, 1) + a - 1) / a * a)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
 static std::vector<std::uint8_t> as_bytes(const std::vector<double>& v) {
     std::vector<std::uint8_t> out(v.size() * sizeof(double));
     std::memcpy(out.data(), v.data(), out.size());
@@ -60,7 +93,7 @@ static gbin::GbfValue make_payload(std::size_t rows, std::size_t cols) {
     return gbin::GbfValue::make_struct(root);
 }
 
-static void bench_one(const std::filesystem::path& file, gbin::CompressionMode comp) {
+static void bench_one(const std::filesystem::path& file, gbin::CompressionMode comp, const std::string& codec = "zlib") {
     std::size_t rows = 1200;
     std::size_t cols = 1200;
     gbin::GbfValue root = make_payload(rows, cols);
@@ -69,9 +102,10 @@ static void bench_one(const std::filesystem::path& file, gbin::CompressionMode c
     wo.compression = comp;
     wo.include_crc32 = true;
     wo.zlib_level = 6;
+    wo.codec = codec;
 
     std::cout << "=== " << (comp == gbin::CompressionMode::Never ? "compression=none" :
-                             comp == gbin::CompressionMode::Always ? "compression=zlib" : "compression=auto")
+                             comp == gbin::CompressionMode::Always ? "compression=" + codec : "compression=auto")
               << " ===\n";
 
     auto t0 = std::chrono::high_resolution_clock::now();
@@ -89,12 +123,505 @@ static void bench_one(const std::filesystem::path& file, gbin::CompressionMode c
     std::cout << "read : " << r_ms << " ms, throughput=" << (mb / (r_ms / 1000.0)) << " MiB/s\n";
 }
 
+// Many 1 MiB fields written with an adaptive level against a deadline; prints the levels chosen.
+static void bench_adaptive(const std::filesystem::path& file, double deadline_s) {
+    gbin::GbfValue::Struct root;
+    std::mt19937_64 rng(789);
+    std::uniform_int_distribution<int> dist(0, 255);
+    for (int i = 0; i < 48; ++i) {
+        gbin::NumericArray a;
+        a.class_id = gbin::NumericClass::Double;
+        a.shape = {128, 1024};
+        std::vector<double> v(128 * 1024);
+        for (auto& x : v) x = static_cast<double>(dist(rng)); // compressible, but not trivially
+        a.real_le = as_bytes(v);
+        root["chunk" + std::to_string(i)] = gbin::GbfValue::make_numeric(a);
+    }
+
+    gbin::WriteOptions wo;
+    wo.zlib_level = 6;
+    wo.adaptive.enabled = true;
+    wo.adaptive.deadline_s = deadline_s;
+
+    std::cout << "=== compression=zlib adaptive, deadline=" << deadline_s * 1000.0 << " ms ===\n";
+    auto t0 = std::chrono::high_resolution_clock::now();
+    gbin::write_file(file, gbin::GbfValue::make_struct(root), wo);
+    double w_ms = ms_since(t0);
+
+    double mb = static_cast<double>(std::filesystem::file_size(file)) / (1024.0 * 1024.0);
+    auto [hdr, hlen, raw] = gbin::read_header_only(file);
+    std::map<int, int> levels;
+    for (const auto& f : hdr.fields) levels[f.level]++;
+    std::cout << "write: " << w_ms << " ms, file=" << mb << " MiB, levels:";
+    for (const auto& kv : levels) std::cout << " " << kv.first << "x" << kv.second;
+    std::cout << "\n";
+}
+
+// Fraction of the file currently in the page cache (-1 if unknown on this platform).
+static double page_cache_fraction(const std::filesystem::path& file) {
+#if defined(__linux__)
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0) return -1.0;
+    const std::size_t size = static_cast<std::size_t>(std::filesystem::file_size(file));
+    void* m = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) return -1.0;
+    const long page = ::sysconf(_SC_PAGESIZE);
+    std::vector<unsigned char> vec((size + page - 1) / page);
+    double frac = -1.0;
+    if (::mincore(m, size, vec.data()) == 0) {
+        std::size_t resident = 0;
+        for (unsigned char c : vec) resident += (c & 1u);
+        frac = vec.empty() ? 0.0 : static_cast<double>(resident) / static_cast<double>(vec.size());
+    }
+    ::munmap(m, size);
+    return frac;
+#else
+    (void)file;
+    return -1.0;
+#endif
+}
+
+// Buffered vs direct I/O on one large uncompressed field.
+static void bench_direct(const std::filesystem::path& file, bool direct) {
+    gbin::GbfValue::Struct root;
+    {
+        gbin::NumericArray a;
+        a.class_id = gbin::NumericClass::Double;
+        a.shape = {4096, 4096}; // 128 MiB
+        std::vector<double> v(4096u * 4096u);
+        for (std::size_t i = 0; i < v.size(); ++i) v[i] = static_cast<double>(i);
+        a.real_le = as_bytes(v);
+        root["big"] = gbin::GbfValue::make_numeric(a);
+    }
+
+    gbin::DirectIoOptions dio;
+    dio.enabled = direct;
+
+    gbin::WriteOptions wo;
+    wo.compression = gbin::CompressionMode::Never;
+    wo.alignment = 4096;
+    wo.direct_io = dio;
+
+    std::filesystem::remove(file);
+    std::cout << "=== " << (direct ? "direct" : "buffered") << " I/O, 128 MiB field ===\n";
+    auto t0 = std::chrono::high_resolution_clock::now();
+    gbin::write_file(file, gbin::GbfValue::make_struct(root), wo);
+    double w_ms = ms_since(t0);
+    double mb = static_cast<double>(std::filesystem::file_size(file)) / (1024.0 * 1024.0);
+    std::cout << "write: " << w_ms << " ms, throughput=" << (mb / (w_ms / 1000.0)) << " MiB/s"
+              << ", page cache=" << 100.0 * page_cache_fraction(file) << "%\n";
+
+    gbin::ReadOptions ro{true};
+    ro.direct_io = dio;
+    t0 = std::chrono::high_resolution_clock::now();
+    gbin::GbfValue read = gbin::read_file(file, ro);
+    double r_ms = ms_since(t0);
+    std::cout << "read : " << r_ms << " ms, throughput=" << (mb / (r_ms / 1000.0)) << " MiB/s"
+              << ", page cache=" << 100.0 * page_cache_fraction(file) << "%\n";
+}
+
+static void bench_parallel(const std::filesystem::path& file, unsigned threads) {
+    // 8 fields x 32 MiB, compressible so that encoding is part of the cost.
+    gbin::GbfValue::Struct root;
+    for (int f = 0; f < 8; ++f) {
+        gbin::NumericArray a;
+        a.class_id = gbin::NumericClass::Double;
+        a.shape = {2048, 2048};
+        std::vector<double> v(2048u * 2048u);
+        for (std::size_t i = 0; i < v.size(); ++i) v[i] = static_cast<double>((i / 64) % 1000 + f);
+        a.real_le = as_bytes(v);
+        root["f" + std::to_string(f)] = gbin::GbfValue::make_numeric(a);
+    }
+
+    gbin::WriteOptions wo;
+    wo.compression = gbin::CompressionMode::Always;
+    wo.zlib_level = 1;
+    wo.alignment = 4096;
+    wo.write_threads = threads;
+
+    std::filesystem::remove(file);
+    std::cout << "=== write, 8 x 32 MiB fields, write_threads=" << threads << " ===\n";
+    auto t0 = std::chrono::high_resolution_clock::now();
+    gbin::write_file(file, gbin::GbfValue::make_struct(root), wo);
+    double w_ms = ms_since(t0);
+    std::cout << "write: " << w_ms << " ms, raw throughput=" << (256.0 / (w_ms / 1000.0)) << " MiB/s\n";
+}
+
+static void bench_large_header(
+    const std::filesystem::path& file,
+    std::size_t nfields,
+    bool field_index,
+    const std::string& header_codec = ""
+) {
+    gbin::GbfValue::Struct group;
+    gbin::LogicalArray l;
+    l.shape = {1, 1};
+    l.data = {1};
+    for (std::size_t i = 0; i < nfields; ++i) {
+        group["sensor_channel_" + std::to_string(i)] = gbin::GbfValue::make_logical(l);
+    }
+    gbin::WriteOptions wo;
+    wo.compression = gbin::CompressionMode::Never;
+    wo.field_index = field_index;
+    wo.header_codec = header_codec;
+    std::filesystem::remove(file);
+    gbin::write_file(file, gbin::GbfValue::make_struct({{"acquisition", gbin::GbfValue::make_struct(group)}}), wo);
+
+    // Validation adds the header CRC (over the text in place) to the parse. Best of several
+    // interleaved runs, to keep the parse noise out.
+    double plain = 1e300;
+    double validated = 1e300;
+    for (int rep = 0; rep < 5; ++rep) {
+        for (bool validate : {false, true}) {
+            auto t0 = std::chrono::high_resolution_clock::now();
+            auto [hdr, hlen, raw] = gbin::read_header_only(file, gbin::ReadOptions{validate});
+            double& best = validate ? validated : plain;
+            best = std::min(best, ms_since(t0));
+            if (hdr.fields.size() != nfields) throw std::runtime_error("bad field count");
+        }
+    }
+    auto [hdr, hlen, raw] = gbin::read_header_only(file, gbin::ReadOptions{false});
+    const double mib = static_cast<double>(hlen) / (1024.0 * 1024.0);
+    std::cout << "=== header open, " << nfields << " fields, " << mib << " MiB header"
+              << (field_index ? ", field index" : "")
+              << (header_codec.empty() ? "" : ", header codec=" + header_codec) << " ===\n";
+    std::cout << "read_header_only: " << plain << " ms, validated: " << validated << " ms\n";
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    gbin::GbfValue one = gbin::read_var(file, "acquisition.sensor_channel_" + std::to_string(nfields / 2));
+    std::cout << "read_var (one leaf): " << ms_since(t0) << " ms\n";
+}
+
+// read_file on a catalog of many tiny numeric leaves, as a tree and as a flat dataset.
+static void bench_many_small_fields(const std::filesystem::path& file, std::size_t nfields) {
+    {
+        gbin::GbfValue::Struct root;
+        for (std::size_t g = 0; g * 1000 < nfields; ++g) {
+            gbin::GbfValue::Struct group;
+            for (std::size_t i = g * 1000; i < std::min(nfields, (g + 1) * 1000); ++i) {
+                gbin::NumericArray a;
+                a.class_id = gbin::NumericClass::Double;
+                a.shape = {1, 4};
+                a.real_le = as_bytes({1.0, 2.0, 3.0, static_cast<double>(i)});
+                group["ch_" + std::to_string(i)] = gbin::GbfValue::make_numeric(std::move(a));
+            }
+            root["run_" + std::to_string(g)] = gbin::GbfValue::make_struct(std::move(group));
+        }
+        gbin::WriteOptions wo;
+        wo.compression = gbin::CompressionMode::Never;
+        wo.field_index = true; // keeps JSON parsing out of the numbers
+        std::filesystem::remove(file);
+        gbin::write_file(file, gbin::GbfValue::make_struct(std::move(root)), wo);
+    }
+
+    std::cout << "=== read_file, " << nfields << " small numeric fields ===\n";
+    std::size_t allocs0 = g_allocs.load();
+    auto t0 = std::chrono::high_resolution_clock::now();
+    {
+        gbin::GbfValue v = gbin::read_file(file);
+        if (v.as_struct().empty()) throw std::runtime_error("empty read");
+    }
+    std::cout << "tree : " << ms_since(t0) << " ms (incl. free), " << (g_allocs.load() - allocs0)
+              << " heap allocations\n";
+    allocs0 = g_allocs.load();
+    t0 = std::chrono::high_resolution_clock::now();
+    {
+        gbin::Dataset d = gbin::read_file_flat(file);
+        if (d.size() != nfields) throw std::runtime_error("bad leaf count");
+    }
+    std::cout << "flat : " << ms_since(t0) << " ms (incl. free), " << (g_allocs.load() - allocs0)
+              << " heap allocations\n";
+}
+
+// A large string column read as StringArray (one allocation per element) and as StringColumn.
+static void bench_string_column(const std::filesystem::path& file, std::size_t n) {
+    {
+        gbin::StringColumn c;
+        c.shape = {n, 1};
+        for (std::size_t i = 0; i < n; ++i) {
+            if (i % 97 == 0) c.push_missing();
+            else c.push_back("sample_label_" + std::to_string(i % 100000));
+        }
+        gbin::WriteOptions wo;
+        wo.compression = gbin::CompressionMode::Never;
+        std::filesystem::remove(file);
+        gbin::write_file(file, gbin::GbfValue::make_struct({{"labels", gbin::GbfValue::make_string_column(std::move(c))}}), wo);
+    }
+
+    std::cout << "=== read string column, " << n << " elements ===\n";
+    for (bool columnar : {false, true}) {
+        gbin::ReadOptions ro;
+        ro.columnar_strings = columnar;
+        const std::size_t allocs0 = g_allocs.load();
+        auto t0 = std::chrono::high_resolution_clock::now();
+        {
+            gbin::GbfValue v = gbin::read_var(file, "labels", ro);
+        }
+        std::cout << (columnar ? "StringColumn: " : "StringArray : ") << ms_since(t0) << " ms (incl. free), "
+                  << (g_allocs.load() - allocs0) << " heap allocations\n";
+    }
+}
+
+// One large value of each non-numeric kind, n elements each.
+static std::vector<std::pair<std::string, gbin::GbfValue>> kind_samples(std::size_t n) {
+    std::vector<std::pair<std::string, gbin::GbfValue>> out;
+    {
+        gbin::StringArray a;
+        a.shape = {n, 1};
+        a.data.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            if (i % 97 == 0) a.data.emplace_back(std::nullopt);
+            else a.data.emplace_back("sample_label_" + std::to_string(i % 100000));
+        }
+        out.emplace_back("string", gbin::GbfValue::make_string(std::move(a)));
+    }
+    {
+        gbin::CharArray a;
+        a.shape = {1, n};
+        a.utf16.resize(n);
+        for (std::size_t i = 0; i < n; ++i) a.utf16[i] = static_cast<std::uint16_t>(0x20 + i % 0x3000);
+        out.emplace_back("char", gbin::GbfValue::make_char(std::move(a)));
+    }
+    {
+        gbin::DateTimeArray a;
+        a.shape = {n, 1};
+        a.timezone = "UTC";
+        a.nat_mask.resize(n);
+        a.unix_ms.resize(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            a.nat_mask[i] = (i % 101 == 0) ? 1 : 0;
+            a.unix_ms[i] = 1700000000000LL + static_cast<std::int64_t>(i) * 1000;
+        }
+        out.emplace_back("datetime", gbin::GbfValue::make_datetime(std::move(a)));
+    }
+    {
+        gbin::DurationArray a;
+        a.shape = {n, 1};
+        a.nan_mask.resize(n);
+        a.ms.resize(n);
+        for (std::size_t i = 0; i < n; ++i) a.ms[i] = static_cast<std::int64_t>(i) * 250;
+        out.emplace_back("duration", gbin::GbfValue::make_duration(std::move(a)));
+    }
+    {
+        gbin::CalendarDurationArray a;
+        a.shape = {n, 1};
+        a.mask.resize(n);
+        a.months.resize(n);
+        a.days.resize(n);
+        a.time_ms.resize(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            a.months[i] = static_cast<std::int32_t>(i % 12);
+            a.days[i] = static_cast<std::int32_t>(i % 31);
+            a.time_ms[i] = static_cast<std::int64_t>(i % 86400000);
+        }
+        out.emplace_back("calendarduration", gbin::GbfValue::make_calendarduration(std::move(a)));
+    }
+    {
+        gbin::CategoricalArray a;
+        a.shape = {n, 1};
+        a.categories = {"red", "green", "blue", "cyan", "magenta"};
+        a.codes.resize(n);
+        for (std::size_t i = 0; i < n; ++i) a.codes[i] = static_cast<std::uint32_t>(i % 6);
+        out.emplace_back("categorical", gbin::GbfValue::make_categorical(std::move(a)));
+    }
+    return out;
+}
+
+// Uncompressed write time for each non-numeric kind; dominated by payload encoding.
+static void bench_encode_kinds(const std::filesystem::path& file, std::size_t n) {
+    std::cout << "=== encode by kind, " << n << " elements, uncompressed ===\n";
+    gbin::WriteOptions wo;
+    wo.compression = gbin::CompressionMode::Never;
+    for (auto& [kind, value] : kind_samples(n)) {
+        const gbin::GbfValue root = gbin::GbfValue::make_struct({{"x", std::move(value)}});
+        std::filesystem::remove(file);
+        auto t0 = std::chrono::high_resolution_clock::now();
+        gbin::write_file(file, root, wo);
+        const double w_ms = ms_since(t0);
+        const double mib = static_cast<double>(std::filesystem::file_size(file)) / (1024.0 * 1024.0);
+        std::cout << kind << ": " << w_ms << " ms, " << mib / (w_ms / 1000.0) << " MiB/s\n";
+    }
+}
+
+// Uncompressed read time for each non-numeric kind, as payload GB/s.
+static void bench_decode_kinds(const std::filesystem::path& file, std::size_t n) {
+    std::cout << "=== decode by kind, " << n << " elements, uncompressed ===\n";
+    gbin::WriteOptions wo;
+    wo.compression = gbin::CompressionMode::Never;
+    for (auto& [kind, value] : kind_samples(n)) {
+        std::filesystem::remove(file);
+        gbin::write_file(file, gbin::GbfValue::make_struct({{"x", std::move(value)}}), wo);
+        auto [hdr, hlen, raw] = gbin::read_header_only(file, gbin::ReadOptions{true});
+        const double gb = static_cast<double>(hdr.fields.at(0).usize) / 1e9;
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        gbin::GbfValue v = gbin::read_var(file, "x", gbin::ReadOptions{true});
+        const double r_ms = ms_since(t0);
+        std::cout << kind << ": " << r_ms << " ms, " << gb / (r_ms / 1000.0) << " GB/s\n";
+    }
+}
+
+// Byte-swap throughput per element size: the dispatched kernels against a byte-at-a-time
+// reversal. This is the extra work big-endian hosts do in pack_le and the fixed-width codecs.
+static void bench_byteswap(std::size_t mib) {
+    std::vector<std::uint8_t> buf(mib * 1024 * 1024);
+    for (std::size_t i = 0; i < buf.size(); ++i) buf[i] = static_cast<std::uint8_t>(i * 131);
+    const double gb = static_cast<double>(buf.size()) / 1e9;
+
+    std::cout << "=== byte swap, " << mib << " MiB ===\n";
+    for (std::size_t elem : {2u, 4u, 8u}) {
+        const std::size_t n = buf.size() / elem;
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (std::size_t i = 0; i < n; ++i) std::reverse(buf.data() + i * elem, buf.data() + (i + 1) * elem);
+        const double byte_ms = ms_since(t0);
+
+        t0 = std::chrono::high_resolution_clock::now();
+        gbin::byteswap_inplace(buf.data(), elem, n);
+        const double kernel_ms = ms_since(t0);
+        std::cout << elem << "-byte: bytewise " << gb / (byte_ms / 1000.0) << " GB/s, kernel "
+                  << gb / (kernel_ms / 1000.0) << " GB/s\n";
+    }
+}
+
+// CharArray transcoding throughput on ASCII labels and on mixed-script text.
+static void bench_char_utf8(std::size_t mib) {
+    const std::size_t target = mib * 1024 * 1024;
+    std::cout << "=== char UTF-8 <-> UTF-16, " << mib << " MiB of text ===\n";
+    for (const char* piece : {"sensor_label_0042 ", "Gr\xC3\xB6\xC3\x9F" "e \xE6\xB8\xA9\xE5\xBA\xA6 \xF0\x9F\x8C\xA1 "}) {
+        std::string text;
+        text.reserve(target + 64);
+        while (text.size() < target) text += piece;
+        const double gb = static_cast<double>(text.size()) / 1e9;
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        gbin::CharArray c = gbin::CharArray::from_utf8(text);
+        const double from_ms = ms_since(t0);
+        t0 = std::chrono::high_resolution_clock::now();
+        const std::string back = c.to_utf8();
+        const double to_ms = ms_since(t0);
+        if (back != text) throw std::runtime_error("char round trip mismatch");
+        std::cout << (piece[0] == 's' ? "ascii: " : "mixed: ") << "from_utf8 " << gb / (from_ms / 1000.0)
+                  << " GB/s, to_utf8 " << gb / (to_ms / 1000.0) << " GB/s\n";
+    }
+}
+
+// Resets the peak-RSS watermark; returns false when the platform cannot.
+static bool reset_peak_rss() {
+#if defined(__linux__)
+    std::ofstream f("/proc/self/clear_refs");
+    f << "5";
+    return static_cast<bool>(f.flush());
+#else
+    return false;
+#endif
+}
+
+// Reads a "VmHWM:"/"VmRSS:"-style line from /proc/self/status, in MiB (-1 if unknown).
+static double proc_status_mib(const std::string& key) {
+    std::ifstream f("/proc/self/status");
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.compare(0, key.size(), key) == 0) return std::stod(line.substr(key.size())) / 1024.0;
+    }
+    return -1.0;
+}
+
+// Peak RSS while reading one large field, relative to the field size.
+static void bench_read_peak_rss(const std::filesystem::path& file, gbin::CompressionMode comp) {
+    const std::size_t n = 32u * 1024u * 1024u; // 256 MiB of doubles
+    {
+        gbin::NumericArray a;
+        a.class_id = gbin::NumericClass::Double;
+        a.shape = {n, 1};
+        a.real_le.resize(n * sizeof(double));
+        for (std::size_t i = 0; i < n; ++i) {
+            const double x = static_cast<double>(i % 4096);
+            std::memcpy(a.real_le.data() + i * sizeof(double), &x, sizeof(double));
+        }
+        gbin::WriteOptions wo;
+        wo.compression = comp;
+        wo.zlib_level = 1;
+        std::filesystem::remove(file);
+        gbin::write_file(file, gbin::GbfValue::make_struct({{"big", gbin::GbfValue::make_numeric(std::move(a))}}), wo);
+    }
+
+    const double field_mib = static_cast<double>(n * sizeof(double)) / (1024.0 * 1024.0);
+    std::cout << "=== read peak RSS, " << field_mib << " MiB field, "
+              << (comp == gbin::CompressionMode::Never ? "uncompressed" : "zlib") << " ===\n";
+    if (!reset_peak_rss()) {
+        std::cout << "peak RSS: unavailable on this platform\n";
+        return;
+    }
+    const double base = proc_status_mib("VmRSS:");
+    auto t0 = std::chrono::high_resolution_clock::now();
+    gbin::GbfValue read = gbin::read_file(file, gbin::ReadOptions{true});
+    const double r_ms = ms_since(t0);
+    const double peak = proc_status_mib("VmHWM:") - base;
+    std::cout << "read : " << r_ms << " ms, peak RSS +" << peak << " MiB (" << peak / field_mib << "x field)\n";
+}
+
+// Repeated reads of one large numeric field (warm page cache): best and median wall time.
+static void bench_large_field_read(const std::filesystem::path& file, gbin::CompressionMode comp, int reps) {
+    const std::size_t n = 32u * 1024u * 1024u; // 256 MiB of doubles
+    {
+        gbin::NumericArray a;
+        a.class_id = gbin::NumericClass::Double;
+        a.shape = {n, 1};
+        a.real_le.resize(n * sizeof(double));
+        for (std::size_t i = 0; i < n; ++i) {
+            const double x = static_cast<double>(i % 4096);
+            std::memcpy(a.real_le.data() + i * sizeof(double), &x, sizeof(double));
+        }
+        gbin::WriteOptions wo;
+        wo.compression = comp;
+        wo.zlib_level = 1;
+        std::filesystem::remove(file);
+        gbin::write_file(file, gbin::GbfValue::make_struct({{"big", gbin::GbfValue::make_numeric(std::move(a))}}), wo);
+    }
+
+    const double field_mib = static_cast<double>(n * sizeof(double)) / (1024.0 * 1024.0);
+    std::vector<double> ms;
+    for (int r = 0; r < reps; ++r) {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        gbin::GbfValue v = gbin::read_var(file, "big", gbin::ReadOptions{true});
+        ms.push_back(ms_since(t0));
+    }
+    std::sort(ms.begin(), ms.end());
+    std::cout << "=== large field read, " << field_mib << " MiB, "
+              << (comp == gbin::CompressionMode::Never ? "uncompressed" : "zlib") << ", " << reps << " reps ===\n";
+    std::cout << "read : best " << ms.front() << " ms (" << field_mib * 1000.0 / ms.front() << " MiB/s), median "
+              << ms[ms.size() / 2] << " ms\n";
+}
+
 int main(int argc, char** argv) {
     std::filesystem::path file = (argc >= 2) ? argv[1] : (std::filesystem::temp_directory_path() / "gbin_cpp_bench.gbf");
     try {
         bench_one(file, gbin::CompressionMode::Never);
         bench_one(file, gbin::CompressionMode::Always);
         bench_one(file, gbin::CompressionMode::Auto);
+        for (const auto& codec : gbin::codec_names()) {
+            if (codec != "zlib") bench_one(file, gbin::CompressionMode::Always, codec);
+        }
+        bench_adaptive(file, 2.0);
+        bench_adaptive(file, 0.25);
+        bench_direct(file, false);
+        bench_direct(file, true);
+        bench_large_header(file, 100000, false);
+        bench_large_header(file, 100000, true);
+        for (const auto& codec : gbin::codec_names()) bench_large_header(file, 100000, false, codec);
+        bench_many_small_fields(file, 200000);
+        bench_string_column(file, 10000000);
+        bench_encode_kinds(file, 10000000);
+        bench_decode_kinds(file, 10000000);
+        bench_byteswap(256);
+        bench_char_utf8(256);
+        bench_read_peak_rss(file, gbin::CompressionMode::Never);
+        bench_read_peak_rss(file, gbin::CompressionMode::Always);
+        bench_large_field_read(file, gbin::CompressionMode::Never, 7);
+        bench_large_field_read(file, gbin::CompressionMode::Always, 5);
+        bench_parallel(file, 1);
+        bench_parallel(file, std::max(2u, std::thread::hardware_concurrency()));
     } catch (const std::exception& e) {
         std::cerr << "bench error: " << e.what() << "\n";
         return 1;
@@ -4,10 +4,19 @@
 #include <cstddef>
 #include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <initializer_list>
+#include <iosfwd>
+#include <iterator>
 #include <map>
 #include <optional>
 #include <stdexcept>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -28,6 +37,7 @@ enum class ErrorKind {
     NotFound,
     Unsupported,
     InvalidData,
+    CodecError,
 };
 
 class GbfError : public std::runtime_error {
@@ -43,6 +53,127 @@ private:
 // Public data model
 // ------------------------------
 
+/// Non-owning view of `size()` contiguous elements (a C++17 stand-in for std::span).
+template <class T>
+class Span {
+public:
+    Span() = default;
+    Span(T* data, std::size_t size) : data_(data), size_(size) {}
+
+    T* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T& operator[](std::size_t i) const { return data_[i]; }
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+
+private:
+    T* data_{nullptr};
+    std::size_t size_{0};
+};
+
+/// Owning byte storage for payloads, allocated on ByteBuffer::alignment (64-byte) boundaries so
+/// the elements can go straight to SIMD loads. Supports the std::vector<std::uint8_t>
+/// operations the data model uses, and converts from one by copying. adopt() takes over a
+/// std::vector<T> instead, without copying; that storage keeps the vector's own alignment.
+/// Buffers of huge_bytes or more are mapped directly (with MADV_HUGEPAGE where available).
+/// uninitialized()/resize_uninitialized() skip the zero fill for bytes about to be overwritten.
+class ByteBuffer {
+public:
+    static constexpr std::size_t alignment = 64;
+    static constexpr std::size_t huge_bytes = std::size_t{4} << 20;
+
+    using value_type = std::uint8_t;
+    using size_type = std::size_t;
+    using iterator = std::uint8_t*;
+    using const_iterator = const std::uint8_t*;
+
+    ByteBuffer() noexcept = default;
+    explicit ByteBuffer(std::size_t n, std::uint8_t value = 0);
+    ByteBuffer(std::initializer_list<std::uint8_t> bytes) : ByteBuffer(bytes.begin(), bytes.end()) {}
+    template <class It, class = std::enable_if_t<!std::is_integral_v<It>>>
+    ByteBuffer(It first, It last) { assign(first, last); }
+    ByteBuffer(const std::vector<std::uint8_t>& v) : ByteBuffer(v.begin(), v.end()) {}
+    ByteBuffer(const ByteBuffer& o) : ByteBuffer(o.begin(), o.end()) {}
+    ByteBuffer(ByteBuffer&& o) noexcept;
+    ByteBuffer& operator=(const ByteBuffer& o);
+    ByteBuffer& operator=(ByteBuffer&& o) noexcept;
+    ~ByteBuffer();
+
+    /// `n` bytes with unspecified contents.
+    static ByteBuffer uninitialized(std::size_t n) {
+        ByteBuffer b;
+        b.resize_uninitialized(n);
+        return b;
+    }
+
+    /// Take over `v`'s storage as `v.size() * sizeof(T)` bytes in host byte order.
+    template <class T>
+    static ByteBuffer adopt(std::vector<T>&& v) {
+        static_assert(std::is_trivially_copyable_v<T>, "adopt requires trivially copyable types");
+        ByteBuffer b;
+        auto* owner = new std::vector<T>(std::move(v));
+        b.data_ = reinterpret_cast<std::uint8_t*>(owner->data());
+        b.size_ = b.capacity_ = owner->size() * sizeof(T);
+        b.owner_ = owner;
+        b.release_ = [](void* o, std::size_t) { delete static_cast<std::vector<T>*>(o); };
+        return b;
+    }
+
+    std::uint8_t* data() noexcept { return data_; }
+    const std::uint8_t* data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+    std::size_t capacity() const noexcept { return capacity_; }
+    bool empty() const noexcept { return size_ == 0; }
+    std::uint8_t& operator[](std::size_t i) noexcept { return data_[i]; }
+    const std::uint8_t& operator[](std::size_t i) const noexcept { return data_[i]; }
+    iterator begin() noexcept { return data_; }
+    iterator end() noexcept { return data_ + size_; }
+    const_iterator begin() const noexcept { return data_; }
+    const_iterator end() const noexcept { return data_ + size_; }
+
+    void reserve(std::size_t n);
+    void shrink_to_fit(); // mapped buffers unmap their unused tail pages in place
+    void resize(std::size_t n, std::uint8_t value = 0);
+    void resize_uninitialized(std::size_t n); // new bytes are left unspecified
+    void clear() noexcept { size_ = 0; }
+    void push_back(std::uint8_t b);
+
+    template <class It, class = std::enable_if_t<!std::is_integral_v<It>>>
+    void assign(It first, It last) {
+        clear();
+        insert(end(), first, last);
+    }
+    void assign(std::size_t n, std::uint8_t value) {
+        clear();
+        resize(n, value);
+    }
+
+    template <class It>
+    iterator insert(const_iterator pos, It first, It last) {
+        const std::size_t at = static_cast<std::size_t>(pos - data_);
+        const auto n = static_cast<std::size_t>(std::distance(first, last));
+        std::uint8_t* p = open_gap(at, n);
+        for (; first != last; ++first) *p++ = static_cast<std::uint8_t>(*first);
+        return data_ + at;
+    }
+
+    friend bool operator==(const ByteBuffer& a, const ByteBuffer& b) noexcept { return equal(a, b); }
+    friend bool operator!=(const ByteBuffer& a, const ByteBuffer& b) noexcept { return !equal(a, b); }
+
+private:
+    static bool equal(const ByteBuffer& a, const ByteBuffer& b) noexcept;
+    std::uint8_t* open_gap(std::size_t at, std::size_t n); // returns where the n new bytes go
+    void reallocate(std::size_t cap);
+    void release() noexcept;
+
+    std::uint8_t* data_{nullptr};
+    std::size_t size_{0};
+    std::size_t capacity_{0};
+    void* owner_{nullptr};                // adopted container or mapping; nullptr for heap storage
+    void (*release_)(void* owner, std::size_t capacity) {nullptr};
+};
+
 enum class NumericClass {
     Double,
     Single,
@@ -60,21 +191,60 @@ enum class NumericClass {
 std::string to_string(NumericClass c);
 NumericClass numeric_class_from_string(const std::string& s);
 
+/// The class whose elements are a T (double -> Double, std::int16_t -> Int16, ...); Unknown otherwise.
+template <class T>
+constexpr NumericClass numeric_class_of() {
+    using U = std::remove_cv_t<T>;
+    if constexpr (std::is_same_v<U, double>) return NumericClass::Double;
+    else if constexpr (std::is_same_v<U, float>) return NumericClass::Single;
+    else if constexpr (std::is_same_v<U, std::int8_t>) return NumericClass::Int8;
+    else if constexpr (std::is_same_v<U, std::uint8_t>) return NumericClass::UInt8;
+    else if constexpr (std::is_same_v<U, std::int16_t>) return NumericClass::Int16;
+    else if constexpr (std::is_same_v<U, std::uint16_t>) return NumericClass::UInt16;
+    else if constexpr (std::is_same_v<U, std::int32_t>) return NumericClass::Int32;
+    else if constexpr (std::is_same_v<U, std::uint32_t>) return NumericClass::UInt32;
+    else if constexpr (std::is_same_v<U, std::int64_t>) return NumericClass::Int64;
+    else if constexpr (std::is_same_v<U, std::uint64_t>) return NumericClass::UInt64;
+    else return NumericClass::Unknown;
+}
+
 struct NumericArray {
     NumericClass class_id{NumericClass::Unknown};
     std::vector<std::size_t> shape{};
     bool complex{false};
 
     // Little-endian element bytes in MATLAB column-major order.
-    std::vector<std::uint8_t> real_le{};
+    ByteBuffer real_le{};
     // If complex=true, imag bytes are appended on disk after real bytes.
-    std::optional<std::vector<std::uint8_t>> imag_le{};
+    std::optional<ByteBuffer> imag_le{};
+
+    /// Typed view of real_le / imag_le. T must match class_id (e.g. double for Double); throws
+    /// InvalidData otherwise, or when the array is not complex (imag_span), and Unsupported on
+    /// big-endian hosts, where the stored bytes are not in host order.
+    template <class T>
+    Span<T> span() { return typed_span<T>(real_le); }
+    template <class T>
+    Span<const T> span() const { return typed_span<const T>(real_le); }
+    template <class T>
+    Span<T> imag_span() { return typed_span<T>(imag_part()); }
+    template <class T>
+    Span<const T> imag_span() const { return typed_span<const T>(imag_part()); }
+
+private:
+    template <class T>
+    Span<T> typed_span(const ByteBuffer& b) const {
+        static_assert(numeric_class_of<T>() != NumericClass::Unknown, "span needs a numeric element type");
+        check_view(b, numeric_class_of<T>(), alignof(T));
+        return Span<T>(reinterpret_cast<T*>(const_cast<std::uint8_t*>(b.data())), b.size() / sizeof(T));
+    }
+    void check_view(const ByteBuffer& b, NumericClass want, std::size_t align) const;
+    const ByteBuffer& imag_part() const;
 };
 
 struct LogicalArray {
     std::vector<std::size_t> shape{};
     // 0/1 bytes, length = numel(shape).
-    std::vector<std::uint8_t> data{};
+    ByteBuffer data{};
 };
 
 struct StringArray {
@@ -83,10 +253,59 @@ struct StringArray {
     std::vector<std::optional<std::string>> data{};
 };
 
+/// Columnar alternative to StringArray for very large string columns: a validity bitmap, an
+/// offsets array and one UTF-8 blob, so a column costs three allocations instead of one per
+/// element. Element i is blob[offsets[i], offsets[i + 1]); bit i of `valid` (LSB first) is
+/// clear for a missing element. Stored like a StringArray; ReadOptions::columnar_strings reads
+/// string fields into this form.
+struct StringColumn {
+    std::vector<std::size_t> shape{};
+    std::vector<std::uint8_t> valid{};     // (numel + 7) / 8 bytes
+    std::vector<std::uint64_t> offsets{0}; // numel + 1 entries
+    std::string blob{};
+
+    std::size_t size() const noexcept { return offsets.size() - 1; }
+    bool is_missing(std::size_t i) const noexcept { return ((valid[i >> 3] >> (i & 7)) & 1u) == 0; }
+    std::string_view view(std::size_t i) const noexcept {
+        return std::string_view(blob).substr(static_cast<std::size_t>(offsets[i]),
+                                             static_cast<std::size_t>(offsets[i + 1] - offsets[i]));
+    }
+    std::optional<std::string_view> get(std::size_t i) const {
+        if (is_missing(i)) return std::nullopt;
+        return view(i);
+    }
+
+    void push_back(std::string_view s) {
+        set_valid(size());
+        blob.append(s);
+        offsets.push_back(blob.size());
+    }
+    void push_missing() {
+        if (valid.size() <= (size() >> 3)) valid.push_back(0);
+        offsets.push_back(blob.size());
+    }
+
+    static StringColumn from_array(const StringArray& a);
+    StringArray to_array() const;
+
+private:
+    void set_valid(std::size_t i) {
+        if (valid.size() <= (i >> 3)) valid.push_back(0);
+        valid[i >> 3] |= static_cast<std::uint8_t>(1u << (i & 7));
+    }
+};
+
 struct CharArray {
     std::vector<std::size_t> shape{};
     // UTF-16 code units, little-endian on disk. Length = numel(shape).
     std::vector<std::uint16_t> utf16{};
+
+    /// 1xN char array holding `s` (empty shape when `s` is empty). Throws GbfError
+    /// (InvalidData) on malformed UTF-8: bad or truncated sequences, overlong forms, encoded
+    /// surrogates and code points past U+10FFFF.
+    static CharArray from_utf8(std::string_view s);
+    /// The code units (in storage order) as UTF-8; unpaired surrogates become U+FFFD.
+    std::string to_utf8() const;
 };
 
 struct DateTimeArray {
@@ -126,11 +345,11 @@ struct OpaqueValue {
     bool complex{false};
     std::string encoding{};
     // Uncompressed payload bytes (after decompression if any).
-    std::vector<std::uint8_t> bytes{};
+    ByteBuffer bytes{};
 };
 
 struct GbfValue {
-    using Struct = std::map<std::string, GbfValue>;
+    using Struct = std::map<std::string, GbfValue, std::less<>>; // transparent: find(string_view)
 
     std::variant<
         Struct,
@@ -142,44 +361,201 @@ struct GbfValue {
         DurationArray,
         CalendarDurationArray,
         CategoricalArray,
-        OpaqueValue
+        OpaqueValue,
+        StringColumn
     > v;
 
-    // Convenience constructors
+    // Convenience constructors; the rvalue overloads adopt the argument's buffers.
     static GbfValue make_struct();
     static GbfValue make_struct(const Struct& m);
+    static GbfValue make_struct(Struct&& m);
 
     static GbfValue make_numeric(const NumericArray& a);
+    static GbfValue make_numeric(NumericArray&& a);
     static GbfValue make_logical(const LogicalArray& a);
+    static GbfValue make_logical(LogicalArray&& a);
     static GbfValue make_string(const StringArray& a);
+    static GbfValue make_string(StringArray&& a);
+    static GbfValue make_string_column(const StringColumn& a);
+    static GbfValue make_string_column(StringColumn&& a);
     static GbfValue make_char(const CharArray& a);
+    static GbfValue make_char(CharArray&& a);
     static GbfValue make_datetime(const DateTimeArray& a);
+    static GbfValue make_datetime(DateTimeArray&& a);
     static GbfValue make_duration(const DurationArray& a);
+    static GbfValue make_duration(DurationArray&& a);
     static GbfValue make_calendarduration(const CalendarDurationArray& a);
+    static GbfValue make_calendarduration(CalendarDurationArray&& a);
     static GbfValue make_categorical(const CategoricalArray& a);
+    static GbfValue make_categorical(CategoricalArray&& a);
     static GbfValue make_opaque(const OpaqueValue& a);
+    static GbfValue make_opaque(OpaqueValue&& a);
 
     bool is_struct() const noexcept;
     const Struct& as_struct() const;
     Struct& as_struct();
 };
 
+/// Flat alternative to a GbfValue tree: the leaves keyed by full dotted path ("a.b.c"), in
+/// insertion order, with a hash index for lookups. read_file_flat() and write_file(Dataset)
+/// go straight between this and the file, without building or flattening a tree. A path may
+/// not also be a prefix of another leaf's path; write_file() and to_value() reject that.
+class Dataset {
+public:
+    using Leaf = std::pair<std::string, GbfValue>;
+
+    Dataset() = default;
+    /// The leaves of `root` (a struct; any other value becomes the single leaf "<root>").
+    explicit Dataset(const GbfValue& root);
+    explicit Dataset(GbfValue&& root);
+
+    /// The equivalent tree, as read_file() would return it.
+    GbfValue to_value() const&;
+    GbfValue to_value() &&;
+
+    std::size_t size() const noexcept { return leaves_.size(); }
+    bool empty() const noexcept { return leaves_.empty(); }
+    void reserve(std::size_t n);
+    const std::vector<Leaf>& leaves() const noexcept { return leaves_; }
+    std::vector<Leaf>::const_iterator begin() const noexcept { return leaves_.begin(); }
+    std::vector<Leaf>::const_iterator end() const noexcept { return leaves_.end(); }
+
+    /// Add a new leaf; throws InvalidData if `path` is already present or has an empty segment
+    /// ("", "a..b", ".a", "a."), or if `value` is a non-empty struct (add its fields instead).
+    GbfValue& add(std::string path, GbfValue value);
+    /// Add or replace the leaf at `path`; same checks as add().
+    GbfValue& set(std::string path, GbfValue value);
+
+    const GbfValue* find(std::string_view path) const;
+    GbfValue* find(std::string_view path);
+    bool contains(std::string_view path) const { return find(path) != nullptr; }
+    /// Throws NotFound if there is no leaf at `path`.
+    const GbfValue& at(std::string_view path) const;
+    GbfValue& at(std::string_view path);
+
+    /// Leaves equal to `prefix` or under "prefix.", in insertion order; all leaves for "".
+    std::vector<const Leaf*> with_prefix(std::string_view prefix) const;
+
+private:
+    std::size_t index_of(std::string_view path) const; // size() if absent
+
+    std::vector<Leaf> leaves_;
+    std::unordered_multimap<std::size_t, std::size_t> index_; // hash(path) -> leaf
+};
+
 // ------------------------------
 // Header model
 // ------------------------------
 
+/// Kind of a stored field (the header's "kind").
+enum class FieldKind : std::uint8_t {
+    Unknown,
+    Struct,
+    Numeric,
+    Logical,
+    String,
+    Char,
+    DateTime,
+    Duration,
+    CalendarDuration,
+    Categorical,
+};
+
+/// Header spelling ("numeric", "calendarduration", ...); "unknown" for FieldKind::Unknown.
+const std::string& to_string(FieldKind k);
+FieldKind field_kind_from_string(std::string_view s);
+
+/// An immutable metadata string (class, encoding, compression). Strings from the format's
+/// own vocabulary (kind, class and encoding names, "none", "extents", registered codec names)
+/// are shared process-wide, so copying one copies a pointer and equal ones compare by pointer.
+/// Any other value, such as an unexpected string read from a file, is owned by the
+/// InternedString and its copies and freed with the last of them, so reading arbitrary files
+/// does not grow process memory.
+class InternedString {
+public:
+    InternedString() noexcept : s_(empty_string()) {}
+    InternedString(std::string_view s);
+    InternedString(const std::string& s) : InternedString(std::string_view(s)) {}
+    InternedString(const char* s) : InternedString(std::string_view(s)) {}
+    InternedString(const InternedString&) = default;
+    InternedString& operator=(const InternedString&) = default;
+    InternedString(InternedString&& o) noexcept : s_(o.s_), owned_(std::move(o.owned_)) { o.s_ = empty_string(); }
+    InternedString& operator=(InternedString&& o) noexcept {
+        if (this != &o) {
+            s_ = o.s_;
+            owned_ = std::move(o.owned_);
+            o.s_ = empty_string();
+        }
+        return *this;
+    }
+
+    const std::string& str() const noexcept { return *s_; }
+    operator const std::string&() const noexcept { return *s_; }
+    const char* c_str() const noexcept { return s_->c_str(); }
+    bool empty() const noexcept { return s_->empty(); }
+    std::size_t size() const noexcept { return s_->size(); }
+
+    friend bool operator==(const InternedString& a, const InternedString& b) noexcept {
+        return a.s_ == b.s_ || ((a.owned_ || b.owned_) && *a.s_ == *b.s_);
+    }
+    friend bool operator!=(const InternedString& a, const InternedString& b) noexcept { return !(a == b); }
+    friend bool operator==(const InternedString& a, const std::string& b) { return *a.s_ == b; }
+    friend bool operator!=(const InternedString& a, const std::string& b) { return *a.s_ != b; }
+    friend bool operator==(const std::string& a, const InternedString& b) { return a == *b.s_; }
+    friend bool operator!=(const std::string& a, const InternedString& b) { return a != *b.s_; }
+    friend bool operator==(const InternedString& a, const char* b) { return *a.s_ == b; }
+    friend bool operator!=(const InternedString& a, const char* b) { return *a.s_ != b; }
+    friend bool operator==(const char* a, const InternedString& b) { return a == *b.s_; }
+    friend bool operator!=(const char* a, const InternedString& b) { return a != *b.s_; }
+
+private:
+    static const std::string* empty_string() noexcept;
+
+    const std::string* s_;
+    std::shared_ptr<const std::string> owned_; // set for strings outside the shared vocabulary
+};
+
+std::ostream& operator<<(std::ostream& os, const InternedString& s);
+
+/// One stored piece of an extended field (see extend_var): `count` entries of the last dimension.
+struct FieldExtent {
+    InternedString compression{"none"};
+    std::uint64_t offset{0}; // relative to payload_start
+    std::uint64_t csize{0};
+    std::uint64_t usize{0};
+    std::uint32_t crc32{0};
+    std::uint64_t count{0};
+};
+
 struct FieldMeta {
     std::string name{};
-    std::string kind{};
-    std::string class_name{};
+    FieldKind kind{FieldKind::Unknown};
+    InternedString kind_name{}; // the header's "kind" when `kind` is Unknown; empty otherwise
+    InternedString class_name{};
+    NumericClass class_id{NumericClass::Unknown}; // parsed from class_name for numeric fields
     std::vector<std::uint64_t> shape{};
     bool complex{false};
-    std::string encoding{};
-    std::string compression{"none"}; // "none" | "zlib"
+    InternedString encoding{};
+    InternedString compression{"none"}; // "none" | codec name ("zlib", "zstd", "lz4", ...)
     std::uint64_t offset{0}; // relative to payload_start
     std::uint64_t csize{0};
     std::uint64_t usize{0};
     std::uint32_t crc32{0};
+    int level{-1}; // codec level chosen by adaptive compression (diagnostic); -1 => not recorded
+    // Non-empty for extended fields, whose `compression` is then "extents" (so readers without
+    // extent support reject them as an unknown codec) and csize/usize are the extent totals.
+    std::vector<FieldExtent> extents{};
+
+    /// The header's "kind" string: to_string(kind), or kind_name for unknown kinds.
+    const std::string& kind_str() const { return kind == FieldKind::Unknown ? kind_name.str() : to_string(kind); }
+};
+
+/// Location of the optional binary field index (WriteOptions::field_index): a section after
+/// the last payload, listed in the header JSON as "index". Readers without support ignore it.
+struct FieldIndexRef {
+    std::uint64_t offset{0}; // relative to payload_start
+    std::uint64_t size{0};
+    std::uint32_t crc32{0};
 };
 
 struct Header {
@@ -192,14 +568,93 @@ struct Header {
     std::string created_utc{};
     std::string matlab_version{};
     std::vector<FieldMeta> fields{};
+    std::optional<FieldIndexRef> field_index{};
 
     std::uint64_t payload_start{0};
     std::uint64_t file_size{0};
     std::string header_crc32_hex{};
+
+    // From the framing rather than the JSON: codec of a compressed header
+    // (WriteOptions::header_codec), empty for a plain JSON header.
+    std::string header_codec{};
+};
+
+/// Columnar form of a field list, for catalogs with very many fields. Names share one
+/// character arena, shapes and extents one flat array each, and offset/csize/usize/crc32 are
+/// parallel columns, so scans over them touch nothing else. meta(i) rebuilds a FieldMeta for
+/// code written against Header::fields.
+class FieldTable {
+public:
+    FieldTable() = default;
+    explicit FieldTable(const std::vector<FieldMeta>& fields);
+
+    void reserve(std::size_t fields, std::size_t name_bytes = 0);
+    void push_back(const FieldMeta& f);
+
+    std::size_t size() const noexcept { return kinds_.size(); }
+    bool empty() const noexcept { return kinds_.empty(); }
+
+    std::string_view name(std::size_t i) const;
+    FieldKind kind(std::size_t i) const { return kinds_[i]; }
+    const std::string& kind_str(std::size_t i) const;
+    const InternedString& class_name(std::size_t i) const { return class_names_[i]; }
+    NumericClass class_id(std::size_t i) const { return class_ids_[i]; }
+    Span<const std::uint64_t> shape(std::size_t i) const;
+    bool complex(std::size_t i) const { return complex_[i] != 0; }
+    const InternedString& encoding(std::size_t i) const { return encodings_[i]; }
+    const InternedString& compression(std::size_t i) const { return compressions_[i]; }
+    int level(std::size_t i) const { return levels_[i]; }
+    Span<const FieldExtent> extents(std::size_t i) const;
+
+    // Whole columns, indexed like the fields.
+    const std::vector<std::uint64_t>& offsets() const noexcept { return offsets_; }
+    const std::vector<std::uint64_t>& csizes() const noexcept { return csizes_; }
+    const std::vector<std::uint64_t>& usizes() const noexcept { return usizes_; }
+    const std::vector<std::uint32_t>& crc32s() const noexcept { return crc32s_; }
+
+    FieldMeta meta(std::size_t i) const;
+    std::vector<FieldMeta> to_fields() const;
+
+private:
+    std::string names_;
+    std::vector<std::size_t> name_ends_;   // field i: names_[name_ends_[i - 1], name_ends_[i])
+    std::vector<FieldKind> kinds_;
+    std::vector<std::pair<std::size_t, InternedString>> unknown_kinds_; // (field, kind), by field
+    std::vector<InternedString> class_names_;
+    std::vector<NumericClass> class_ids_;
+    std::vector<std::uint8_t> complex_;
+    std::vector<std::uint64_t> dims_;      // all shapes back to back
+    std::vector<std::size_t> dim_ends_;
+    std::vector<InternedString> encodings_;
+    std::vector<InternedString> compressions_;
+    std::vector<int> levels_;
+    std::vector<FieldExtent> extents_;     // all extents back to back
+    std::vector<std::size_t> extent_ends_;
+    std::vector<std::uint64_t> offsets_;
+    std::vector<std::uint64_t> csizes_;
+    std::vector<std::uint64_t> usizes_;
+    std::vector<std::uint32_t> crc32s_;
+};
+
+/// Opt-in direct I/O (O_DIRECT on Linux) for large transfers. Bypasses the page cache so
+/// streaming multi-GB files does not evict the caller's working set. Data moves through
+/// block-aligned bounce buffers of `block_bytes`, with up to `queue_depth` requests in flight.
+/// Silently falls back to buffered I/O where the platform or filesystem rejects it.
+struct DirectIoOptions {
+    bool enabled{false};
+    std::uint64_t min_bytes{std::uint64_t{64} << 20}; // smaller files (write) / fields (read) stay buffered
+    std::size_t block_bytes{std::size_t{8} << 20};
+    unsigned queue_depth{4};
 };
 
 struct ReadOptions {
     bool validate{false}; // validate header CRC + per-field CRC (when present)
+    DirectIoOptions direct_io{}; // applied per field (csize >= min_bytes)
+    // Take field metadata from the binary field index when the file has one, skipping the
+    // "fields" array of the JSON; read_var then looks names up by binary search.
+    bool use_field_index{true};
+    // Decode string fields as StringColumn instead of StringArray.
+    bool columnar_strings{false};
 };
 
 enum class CompressionMode {
@@ -208,12 +663,76 @@ enum class CompressionMode {
     Auto,
 };
 
+/// Adaptive codec level: the writer streams fields to disk, times compression and I/O,
+/// and moves the level between fields to sustain `target_mib_s` and/or finish by `deadline_s`.
+/// It lowers the level when compression is the bottleneck, raises it when the disk is (smaller
+/// output) or when there is headroom. The level used is recorded per field ("level").
+struct AdaptiveCompression {
+    bool enabled{false};
+    double target_mib_s{0.0}; // uncompressed MiB/s to sustain; 0 => no throughput target
+    double deadline_s{0.0};   // wall-clock budget for the whole write; 0 => no deadline
+    int min_level{1};
+    int max_level{9};
+};
+
 struct WriteOptions {
     CompressionMode compression{CompressionMode::Auto};
     bool include_crc32{true};
     int zlib_level{6}; // 0..9
+    std::string codec{"zlib"}; // registry name used when compressing
+    int codec_level{0};        // level for non-zlib codecs; 0 => codec default
+    AdaptiveCompression adaptive{}; // starts from the static level above, clamped to [min, max]
+    // Power of two (e.g. 64 or 4096) for payload_start and every field start; 0 => packed.
+    // The header is padded with trailing spaces and fields with zero bytes; readers skip both.
+    std::size_t alignment{0};
+    // Extra trailing spaces kept in the header so update_var/append_vars can usually rewrite
+    // it in place instead of relocating payload.
+    std::size_t header_reserve{0};
+    DirectIoOptions direct_io{}; // applied to the whole file (size >= min_bytes); not to adaptive writes
+    // > 1: encode fields on this many threads, preallocate the file and pwrite each field to its
+    // offset concurrently, header last. Not combined with adaptive or direct_io writes.
+    unsigned write_threads{0};
+    // Append a binary field index (fixed-stride records + sorted names) after the payload so
+    // readers can skip JSON field parsing; for catalogs of 10^5+ leaves. Not written by
+    // adaptive writes or gbin::Writer, and dropped by update_var/append_vars/extend_var.
+    bool field_index{false};
+    // Registry codec (e.g. "zlib") for the header JSON itself; empty => plain JSON header.
+    // Such files start with the magic "GREDBIZ\0", which readers without support reject.
+    // Uses zlib_level/codec_level like the payload. update_var/append_vars/extend_var keep
+    // the file's framing; compact_file and write_file follow this option. Not used by
+    // adaptive writes or gbin::Writer.
+    std::string header_codec{};
+};
+
+// ------------------------------
+// Compression codecs
+// ------------------------------
+
+/// A named payload codec. The name is stored per field in the header ("compression")
+/// and looked up again when reading. "none" is implicit and never registered.
+struct Codec {
+    std::string name{};
+    // Worst-case compressed size for `n` input bytes.
+    std::function<std::size_t(std::size_t n)> bound{};
+    // Compress into `out` (capacity `cap` >= bound(n)); returns the compressed size.
+    std::function<std::size_t(const std::uint8_t* in, std::size_t n,
+                              std::uint8_t* out, std::size_t cap, int level)> compress{};
+    // Decompress exactly `usize` bytes into `out`; throws GbfError on failure.
+    std::function<void(const std::uint8_t* in, std::size_t n,
+                       std::uint8_t* out, std::size_t usize)> decompress{};
 };
 
+/// Add a codec; throws Unsupported if the name is taken, since codecs handed out by
+/// find_codec() stay valid for the life of the process. Built-ins: "zlib" always;
+/// "zstd"/"lz4" when found at build time.
+void register_codec(Codec codec);
+
+/// nullptr if the codec is unknown.
+const Codec* find_codec(const std::string& name);
+
+/// Names of all registered codecs.
+std::vector<std::string> codec_names();
+
 // ------------------------------
 // API
 // ------------------------------
@@ -224,12 +743,25 @@ std::tuple<Header, std::uint32_t, std::string> read_header_only(
     const ReadOptions& opts = ReadOptions{}
 );
 
+/// Like read_header_only, for catalogs with very many fields: the fields come back as a
+/// FieldTable and the returned Header's `fields` is empty.
+std::pair<Header, FieldTable> read_header_table(
+    const std::filesystem::path& file,
+    const ReadOptions& opts = ReadOptions{}
+);
+
 /// Read full file and reconstruct the root value (typically a struct).
 GbfValue read_file(
     const std::filesystem::path& file,
     const ReadOptions& opts = ReadOptions{}
 );
 
+/// Read all leaves into a Dataset, without building the tree.
+Dataset read_file_flat(
+    const std::filesystem::path& file,
+    const ReadOptions& opts = ReadOptions{}
+);
+
 /// Read a variable path (leaf or subtree prefix). `var` may be "<root>" or empty to read the root.
 GbfValue read_var(
     const std::filesystem::path& file,
@@ -244,6 +776,115 @@ void write_file(
     const WriteOptions& opts = WriteOptions{}
 );
 
+/// Write a GBF file from flat leaves, one field per leaf in the Dataset's order.
+void write_file(
+    const std::filesystem::path& file,
+    const Dataset& data,
+    const WriteOptions& opts = WriteOptions{}
+);
+
+/// Replace the variable at `var` (a leaf, or a subtree prefix) without rewriting the file.
+/// A new payload that fits in the old slot is written in place; otherwise it goes after the
+/// end of file. The header is rewritten in place, using its trailing slack
+/// (WriteOptions::header_reserve), or grown, moving the fields it overlaps to the end.
+/// Crash-safe: an undo journal "<file>.gbfj" is synced before the file is touched and
+/// removed once the update is durable. Throws NotFound if `var` does not exist.
+void update_var(
+    const std::filesystem::path& file,
+    const std::string& var,
+    const GbfValue& value,
+    const WriteOptions& opts = WriteOptions{}
+);
+
+/// Add the leaves of `values` (a struct) as new variables. Their payloads are written after
+/// the current end of file and the header is rewritten as in update_var, so the cost is the
+/// appended bytes plus the header (keep WriteOptions::header_reserve > 0 to avoid relocation).
+/// Throws InvalidData if a new path collides with an existing variable.
+void append_vars(
+    const std::filesystem::path& file,
+    const GbfValue& values,
+    const WriteOptions& opts = WriteOptions{}
+);
+
+/// Grow the numeric/logical/datetime/duration variable `var` along its last dimension by
+/// `slice`, which must match its type and all other dimensions (and, for datetimes, the
+/// timezone, locale and format). Only the slice is encoded and
+/// written (after the end of file, as a new extent) and the header rewritten as in update_var;
+/// readers concatenate the extents. compact_file merges them back into a single payload.
+void extend_var(
+    const std::filesystem::path& file,
+    const std::string& var,
+    const GbfValue& slice,
+    const WriteOptions& opts = WriteOptions{}
+);
+
+/// Roll back an interrupted update if "<file>.gbfj" is present. Returns true if the file was
+/// restored. update_var/compact_file call this first; readers do not.
+bool recover_file(const std::filesystem::path& file);
+
+/// Rewrite `file` packed (dead space from updates reclaimed), honoring `alignment` and
+/// `header_reserve`. Payloads are copied as stored, without recompressing, except extended
+/// fields, which are merged and encoded with `opts` one at a time (each is encoded twice: once
+/// to size the layout, once to write it). The new file is written beside the old one and
+/// renamed over it.
+void compact_file(
+    const std::filesystem::path& file,
+    const WriteOptions& opts = WriteOptions{}
+);
+
+// ------------------------------
+// Write-in-place
+// ------------------------------
+
+/// Builds a GBF file field by field without staging payloads in memory.
+///
+/// reserve_numeric() allocates the field's region in the output file (fallocate + mmap on
+/// POSIX) and returns it as a writable span, so a producer can compute straight into the file.
+/// put() encodes an ordinary value with the writer's options. commit() converts the reserved
+/// fields to little-endian (a no-op on little-endian hosts), computes their CRCs, writes the
+/// header and closes the file; spans are invalid afterwards.
+/// Reserved fields are stored uncompressed. A Writer destroyed without commit() removes the
+/// partial file.
+///
+/// The header goes in front of the payload, so its region is sized up front (at least
+/// WriteOptions::header_reserve, 4 KiB by default); if the final header is larger, commit()
+/// shifts the payload once to make room.
+class Writer {
+public:
+    explicit Writer(const std::filesystem::path& file, const WriteOptions& opts = WriteOptions{});
+    ~Writer();
+    Writer(Writer&&) noexcept;
+    Writer& operator=(Writer&&) noexcept;
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    /// Reserve a real numeric field of `shape`; T must be `class_id`'s element type (e.g.
+    /// double for Double), otherwise InvalidData. The span holds numel(shape)
+    /// zero-initialized elements.
+    template <class T>
+    Span<T> reserve_numeric(const std::string& name, NumericClass class_id, const std::vector<std::size_t>& shape) {
+        static_assert(numeric_class_of<T>() != NumericClass::Unknown, "reserve_numeric needs a numeric element type");
+        std::size_t count = 0;
+        void* p = reserve_raw(name, class_id, numeric_class_of<T>(), shape, count);
+        return Span<T>(static_cast<T*>(p), count);
+    }
+
+    void put(const std::string& name, const GbfValue& value);
+    void commit();
+
+private:
+    void* reserve_raw(
+        const std::string& name,
+        NumericClass class_id,
+        NumericClass elem_class,
+        const std::vector<std::size_t>& shape,
+        std::size_t& count
+    );
+
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
 // ------------------------------
 // Utilities
 // ------------------------------
@@ -251,4 +892,13 @@ void write_file(
 std::size_t numel(const std::vector<std::size_t>& shape);
 std::size_t numel_u64(const std::vector<std::uint64_t>& shape);
 
+/// Whether the library was built for a little-endian host. GBF payloads are little-endian, so
+/// on big-endian hosts pack_le and the codecs swap fixed-width elements with byteswap_inplace.
+bool host_is_little_endian() noexcept;
+
+/// Reverses the bytes of each of the n elements of elem_size bytes at data. 2-, 4- and 8-byte
+/// elements use SIMD shuffles where the CPU has them (SSSE3, NEON) and compiler byte-swap
+/// builtins otherwise; other sizes are reversed byte by byte.
+void byteswap_inplace(void* data, std::size_t elem_size, std::size_t n) noexcept;
+
 } // namespace gbin
@@ -13,38 +13,46 @@ namespace gbin::easy {
 
 // Pack a typed vector into little-endian element bytes.
 // The GBF on-disk representation is always little-endian.
-namespace detail {
-inline bool is_little_endian() {
-    const std::uint16_t x = 1;
-    return *reinterpret_cast<const std::uint8_t*>(&x) == 1;
-}
-
-inline void bswap_inplace(std::uint8_t* buf, std::size_t elem_size, std::size_t n_elems) {
-    if (!buf || elem_size <= 1 || n_elems == 0) return;
-    for (std::size_t i = 0; i < n_elems; ++i) {
-        std::uint8_t* p = buf + i * elem_size;
-        for (std::size_t a = 0, b = elem_size - 1; a < b; ++a, --b) {
-            std::uint8_t t = p[a];
-            p[a] = p[b];
-            p[b] = t;
-        }
-    }
-}
-} // namespace detail
-
 template <typename T>
-inline std::vector<std::uint8_t> pack_le(const std::vector<T>& v) {
+inline ByteBuffer pack_le(const std::vector<T>& v) {
     static_assert(std::is_trivially_copyable_v<T>, "pack_le requires trivially copyable types");
-    std::vector<std::uint8_t> out(sizeof(T) * v.size());
+    ByteBuffer out = ByteBuffer::uninitialized(sizeof(T) * v.size());
     if (!out.empty()) {
         std::memcpy(out.data(), v.data(), out.size());
-        if (!detail::is_little_endian()) {
-            detail::bswap_inplace(out.data(), sizeof(T), v.size());
-        }
+        if (!host_is_little_endian()) byteswap_inplace(out.data(), sizeof(T), v.size());
     }
     return out;
 }
 
+// Like pack_le, but takes over `v`'s buffer on little-endian hosts instead of copying it.
+template <typename T>
+inline ByteBuffer adopt_le(std::vector<T>&& v) {
+    if (host_is_little_endian()) return ByteBuffer::adopt(std::move(v));
+    return pack_le(v);
+}
+
+// Real numeric array of `shape` whose class follows T (double -> Double, ...). The rvalue
+// overload adopts `data_colmajor` without copying on little-endian hosts.
+template <typename T>
+inline NumericArray make_numeric(std::vector<std::size_t> shape, const std::vector<T>& data_colmajor) {
+    static_assert(numeric_class_of<T>() != NumericClass::Unknown, "make_numeric needs a numeric element type");
+    NumericArray a;
+    a.class_id = numeric_class_of<T>();
+    a.shape = std::move(shape);
+    a.real_le = pack_le(data_colmajor);
+    return a;
+}
+
+template <typename T>
+inline NumericArray make_numeric(std::vector<std::size_t> shape, std::vector<T>&& data_colmajor) {
+    static_assert(numeric_class_of<T>() != NumericClass::Unknown, "make_numeric needs a numeric element type");
+    NumericArray a;
+    a.class_id = numeric_class_of<T>();
+    a.shape = std::move(shape);
+    a.real_le = adopt_le(std::move(data_colmajor));
+    return a;
+}
+
 inline NumericArray make_numeric_doubles(std::vector<std::size_t> shape,
                                         const std::vector<double>& data_colmajor) {
     NumericArray a;
@@ -55,6 +63,10 @@ inline NumericArray make_numeric_doubles(std::vector<std::size_t> shape,
     return a;
 }
 
+inline NumericArray make_numeric_doubles(std::vector<std::size_t> shape, std::vector<double>&& data_colmajor) {
+    return make_numeric(std::move(shape), std::move(data_colmajor));
+}
+
 inline NumericArray make_numeric_floats(std::vector<std::size_t> shape,
                                        const std::vector<float>& data_colmajor) {
     NumericArray a;
@@ -65,6 +77,10 @@ inline NumericArray make_numeric_floats(std::vector<std::size_t> shape,
     return a;
 }
 
+inline NumericArray make_numeric_floats(std::vector<std::size_t> shape, std::vector<float>&& data_colmajor) {
+    return make_numeric(std::move(shape), std::move(data_colmajor));
+}
+
 inline NumericArray make_numeric_i32(std::vector<std::size_t> shape,
                                     const std::vector<std::int32_t>& data_colmajor) {
     NumericArray a;
@@ -75,16 +91,13 @@ inline NumericArray make_numeric_i32(std::vector<std::size_t> shape,
     return a;
 }
 
-// Convenience: store ASCII/UTF-8 bytes as UTF-16 code units.
-// This is fine for typical labels. For full UTF-8 → UTF-16 correctness, add a converter.
-inline CharArray make_char_utf8(std::string s) {
-    CharArray c;
-    c.shape = {1, s.size()};
-    c.utf16.reserve(s.size());
-    for (unsigned char ch : s) {
-        c.utf16.push_back(static_cast<std::uint16_t>(ch));
-    }
-    return c;
+inline NumericArray make_numeric_i32(std::vector<std::size_t> shape, std::vector<std::int32_t>&& data_colmajor) {
+    return make_numeric(std::move(shape), std::move(data_colmajor));
+}
+
+// Convenience: 1xN char array from UTF-8 text (see CharArray::from_utf8).
+inline CharArray make_char_utf8(std::string_view s) {
+    return CharArray::from_utf8(s);
 }
 
 inline void set(GbfValue::Struct& root, std::string key, GbfValue v) {
@@ -1,21 +1,48 @@
 
 #include "gbin/gbf.hpp"
 
+#include "gbf_direct_io.hpp"
+
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <charconv>
 #include <cmath>
 #include <cctype>
 #include <cerrno>
 #include <chrono>
 #include <cstring>
+#include <exception>
 #include <fstream>
 #include <iomanip>
 #include <limits>
+#include <mutex>
 #include <sstream>
 #include <string_view>
+#include <thread>
+#include <unordered_map>
 
 #include <zlib.h>
 
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define GBIN_SIMD_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define GBIN_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
 namespace gbin {
 
 GbfError::GbfError(ErrorKind k, const std::string& msg)
@@ -57,6 +84,9 @@ class JsonParser {
 public:
     explicit JsonParser(std::string_view s) : s_(s) {}
 
+    // The value of `key` in the top-level object is stepped over and parsed as null.
+    JsonParser(std::string_view s, std::string_view skip_top_level_key) : s_(s), skip_key_(skip_top_level_key) {}
+
     Json parse() {
         skip_ws();
         Json out = parse_value();
@@ -69,7 +99,9 @@ public:
 
 private:
     std::string_view s_;
+    std::string_view skip_key_{};
     std::size_t pos_{0};
+    int depth_{0};
 
     void skip_ws() {
         while (pos_ < s_.size()) {
@@ -236,7 +268,12 @@ private:
             skip_ws();
             if (get() != ':') throw GbfError(ErrorKind::HeaderJsonParse, "expected ':' in object");
             skip_ws();
-            obj.emplace(std::move(key), parse_value());
+            if (depth_ == 1 && !skip_key_.empty() && key == skip_key_) {
+                skip_value();
+                obj.emplace(std::move(key), Json{nullptr});
+            } else {
+                obj.emplace(std::move(key), parse_value());
+            }
             skip_ws();
             char c = get();
             if (c == '}') break;
@@ -245,12 +282,47 @@ private:
         return Json{obj};
     }
 
+    // Step over one value without building it; brackets and strings are matched, the rest
+    // is only scanned.
+    void skip_value() {
+        int depth = 0;
+        do {
+            skip_ws();
+            const char c = get();
+            if (c == '"') {
+                while (true) {
+                    const char d = get();
+                    if (d == '"') break;
+                    if (d == '\\') get();
+                }
+            } else if (c == '[' || c == '{') {
+                ++depth;
+            } else if (c == ']' || c == '}') {
+                if (--depth < 0) throw GbfError(ErrorKind::HeaderJsonParse, "unbalanced JSON");
+            } else if (depth == 0) {
+                while (pos_ < s_.size() && std::strchr(",]} \t\r\n", s_[pos_]) == nullptr) ++pos_;
+            }
+        } while (depth > 0);
+    }
+
     Json parse_value() {
         skip_ws();
         char c = peek();
         if (c == '"') { get(); return parse_string(); }
-        if (c == '{') { get(); return parse_object(); }
-        if (c == '[') { get(); return parse_array(); }
+        if (c == '{') {
+            get();
+            ++depth_;
+            Json obj = parse_object();
+            --depth_;
+            return obj;
+        }
+        if (c == '[') {
+            get();
+            ++depth_;
+            Json arr = parse_array();
+            --depth_;
+            return arr;
+        }
         if (c == 't') { expect("true"); return Json{true}; }
         if (c == 'f') { expect("false"); return Json{false}; }
         if (c == 'n') { expect("null"); return Json{nullptr}; }
@@ -267,100 +339,6 @@ private:
     }
 };
 
-static void json_escape_string(std::ostream& os, const std::string& s) {
-    os << '"';
-    for (unsigned char c : s) {
-        switch (c) {
-            case '"': os << "\\\""; break;
-            case '\\': os << "\\\\"; break;
-            case '\b': os << "\\b"; break;
-            case '\f': os << "\\f"; break;
-            case '\n': os << "\\n"; break;
-            case '\r': os << "\\r"; break;
-            case '\t': os << "\\t"; break;
-            default:
-                if (c < 0x20) {
-                    os << "\\u" << std::hex << std::setw(4) << std::setfill('0')
-                       << static_cast<int>(c) << std::dec << std::setw(0);
-                } else {
-                    os << static_cast<char>(c);
-                }
-        }
-    }
-    os << '"';
-}
-
-static void json_serialize(std::ostream& os, const Json& j);
-
-static void json_serialize_object(std::ostream& os, const Json::Object& obj) {
-    os << '{';
-    bool first = true;
-    for (const auto& kv : obj) {
-        if (!first) os << ',';
-        first = false;
-        json_escape_string(os, kv.first);
-        os << ':';
-        json_serialize(os, kv.second);
-    }
-    os << '}';
-}
-
-static void json_serialize_array(std::ostream& os, const Json::Array& arr) {
-    os << '[';
-    for (std::size_t i = 0; i < arr.size(); ++i) {
-        if (i) os << ',';
-        json_serialize(os, arr[i]);
-    }
-    os << ']';
-}
-
-static void json_serialize(std::ostream& os, const Json& j) {
-    if (std::holds_alternative<std::nullptr_t>(j.v)) {
-        os << "null";
-    } else if (std::holds_alternative<bool>(j.v)) {
-        os << (std::get<bool>(j.v) ? "true" : "false");
-    } else if (std::holds_alternative<JsonNumber>(j.v)) {
-        const auto& n = std::get<JsonNumber>(j.v);
-        // Preserve the original raw representation if available; for writer we will construct numbers as integers,
-        // so raw will already be stable.
-        os << n.raw;
-    } else if (std::holds_alternative<std::string>(j.v)) {
-        json_escape_string(os, std::get<std::string>(j.v));
-    } else if (std::holds_alternative<Json::Array>(j.v)) {
-        json_serialize_array(os, std::get<Json::Array>(j.v));
-    } else {
-        json_serialize_object(os, std::get<Json::Object>(j.v));
-    }
-}
-
-static std::string json_dump_compact(const Json& j) {
-    std::ostringstream oss;
-    oss.imbue(std::locale::classic());
-    json_serialize(oss, j);
-    return oss.str();
-}
-
-// Helpers to build numbers with stable raw string.
-static Json json_u64(std::uint64_t v) {
-    JsonNumber n;
-    n.is_int = true;
-    n.value = static_cast<double>(v);
-    n.raw = std::to_string(v);
-    return Json{n};
-}
-
-static Json json_i64(std::int64_t v) {
-    JsonNumber n;
-    n.is_int = true;
-    n.value = static_cast<double>(v);
-    n.raw = std::to_string(v);
-    return Json{n};
-}
-
-static Json json_bool(bool b) { return Json{b}; }
-static Json json_str(const std::string& s) { return Json{s}; }
-static Json json_null() { return Json{nullptr}; }
-
 } // namespace internal
 
 // ------------------------------
@@ -368,6 +346,7 @@ static Json json_null() { return Json{nullptr}; }
 // ------------------------------
 
 static constexpr std::uint32_t kMaxHeaderLen   = 64u * 1024u * 1024u; // 64MB
+static constexpr std::uint64_t kMaxHeaderJsonLen = 1ull << 30; // decompressed header JSON, 1 GiB
 static constexpr std::uint64_t kMaxFieldUsize  = 16ull * 1024ull * 1024ull * 1024ull; // 16 GiB
 static constexpr std::uint64_t kMaxFieldCsize  = 16ull * 1024ull * 1024ull * 1024ull; // 16 GiB
 
@@ -394,16 +373,6 @@ static std::uint32_t read_u32_le(std::istream& is) {
            (static_cast<std::uint32_t>(b[3]) << 24);
 }
 
-static void write_u32_le(std::ostream& os, std::uint32_t v) {
-    unsigned char b[4] = {
-        static_cast<unsigned char>(v & 0xFFu),
-        static_cast<unsigned char>((v >> 8) & 0xFFu),
-        static_cast<unsigned char>((v >> 16) & 0xFFu),
-        static_cast<unsigned char>((v >> 24) & 0xFFu),
-    };
-    os.write(reinterpret_cast<const char*>(b), 4);
-}
-
 static std::uint64_t u64_from_json(const internal::Json& j) {
     using internal::JsonNumber;
     if (std::holds_alternative<JsonNumber>(j.v)) {
@@ -506,31 +475,111 @@ std::size_t numel_u64(const std::vector<std::uint64_t>& shape) {
     return n;
 }
 
-static std::vector<std::string> split_path(const std::string& s) {
-    std::vector<std::string> parts;
-    std::size_t start = 0;
-    while (start <= s.size()) {
-        auto dot = s.find('.', start);
-        if (dot == std::string::npos) dot = s.size();
-        parts.push_back(s.substr(start, dot - start));
-        start = dot + 1;
-        if (dot == s.size()) break;
+// ------------------------------
+// Byte order
+// ------------------------------
+//
+// GBF payloads are little-endian. The host byte order is fixed when the library is built, from
+// __BYTE_ORDER__ (compilers without it, i.e. MSVC, only target little-endian hosts). Building
+// with GBIN_HOST_LITTLE_ENDIAN=0 on a little-endian host compiles the big-endian paths; that is
+// only useful for timing them, since the files it writes are not valid there.
+#ifndef GBIN_HOST_LITTLE_ENDIAN
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define GBIN_HOST_LITTLE_ENDIAN 0
+#else
+#define GBIN_HOST_LITTLE_ENDIAN 1
+#endif
+#endif
+
+static constexpr bool kHostLittleEndian = GBIN_HOST_LITTLE_ENDIAN != 0;
+
+bool host_is_little_endian() noexcept { return kHostLittleEndian; }
+
+namespace {
+
+template <class U>
+U bswap_scalar(U v) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    if constexpr (sizeof(U) == 2) return __builtin_bswap16(v);
+    else if constexpr (sizeof(U) == 4) return __builtin_bswap32(v);
+    else return __builtin_bswap64(v);
+#else
+    U r = 0;
+    for (std::size_t i = 0; i < sizeof(U); ++i) r = static_cast<U>((r << 8) | ((v >> (8 * i)) & 0xFFu));
+    return r;
+#endif
+}
+
+// Compilers turn this loop into vector permutes where they can (e.g. vperm on POWER, the
+// z/Architecture vector facility on s390x); it also handles the tails of the SIMD kernels.
+template <class U>
+void bswap_scalar_run(std::uint8_t* p, std::size_t n) noexcept {
+    for (std::size_t i = 0; i < n; ++i, p += sizeof(U)) {
+        U v;
+        std::memcpy(&v, p, sizeof(U));
+        v = bswap_scalar(v);
+        std::memcpy(p, &v, sizeof(U));
     }
-    // remove empty segments
-    for (const auto& p : parts) {
-        if (p.empty()) {
-            throw GbfError(ErrorKind::InvalidData, "invalid path: empty segment");
-        }
+}
+
+// The SIMD kernels swap whole 16-byte vectors and return how many elements they handled.
+#if defined(GBIN_SIMD_X86)
+template <std::size_t Size>
+__attribute__((target("ssse3"))) std::size_t bswap_ssse3(std::uint8_t* p, std::size_t n) noexcept {
+    const __m128i mask = Size == 2 ? _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+                       : Size == 4 ? _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+                                   : _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    const std::size_t per = 16 / Size;
+    std::size_t i = 0;
+    for (; i + per <= n; i += per) {
+        auto* v = reinterpret_cast<__m128i*>(p + i * Size);
+        _mm_storeu_si128(v, _mm_shuffle_epi8(_mm_loadu_si128(v), mask));
     }
-    return parts;}
+    return i;
+}
 
-static std::string join_path(const std::vector<std::string>& parts, std::size_t upto) {
-    std::string out;
-    for (std::size_t i = 0; i < upto; ++i) {
-        if (i) out.push_back('.');
-        out += parts[i];
+bool have_ssse3() noexcept {
+    static const bool yes = __builtin_cpu_supports("ssse3");
+    return yes;
+}
+#elif defined(GBIN_SIMD_NEON)
+template <std::size_t Size>
+std::size_t bswap_neon(std::uint8_t* p, std::size_t n) noexcept {
+    const std::size_t per = 16 / Size;
+    std::size_t i = 0;
+    for (; i + per <= n; i += per) {
+        const uint8x16_t v = vld1q_u8(p + i * Size);
+        if constexpr (Size == 2) vst1q_u8(p + i * Size, vrev16q_u8(v));
+        else if constexpr (Size == 4) vst1q_u8(p + i * Size, vrev32q_u8(v));
+        else vst1q_u8(p + i * Size, vrev64q_u8(v));
+    }
+    return i;
+}
+#endif
+
+template <class U>
+void bswap_run(std::uint8_t* p, std::size_t n) noexcept {
+    std::size_t done = 0;
+#if defined(GBIN_SIMD_X86)
+    if (have_ssse3()) done = bswap_ssse3<sizeof(U)>(p, n);
+#elif defined(GBIN_SIMD_NEON)
+    done = bswap_neon<sizeof(U)>(p, n);
+#endif
+    bswap_scalar_run<U>(p + done * sizeof(U), n - done);
+}
+
+} // namespace
+
+void byteswap_inplace(void* data, std::size_t elem_size, std::size_t n) noexcept {
+    auto* p = static_cast<std::uint8_t*>(data);
+    switch (elem_size) {
+        case 2: bswap_run<std::uint16_t>(p, n); return;
+        case 4: bswap_run<std::uint32_t>(p, n); return;
+        case 8: bswap_run<std::uint64_t>(p, n); return;
+        default:
+            if (elem_size < 2) return;
+            for (std::size_t i = 0; i < n; ++i) std::reverse(p + i * elem_size, p + (i + 1) * elem_size);
     }
-    return out;
 }
 
 static std::string upper_hex8(std::uint32_t v) {
@@ -554,67 +603,89 @@ static std::uint32_t parse_hex_u32(const std::string& s) {
     return v;
 }
 
-// Replace the value of "header_crc32_hex" in-place with all '0's (keeping length).
-static void zero_out_header_crc_value(std::string& json) {
-    const std::string key = "\"header_crc32_hex\"";
+// Locate the characters of the "header_crc32_hex" value, [begin, end). False if absent.
+static bool find_header_crc_value(std::string_view json, std::size_t& begin, std::size_t& end) {
+    constexpr std::string_view key = "\"header_crc32_hex\"";
     auto kpos = json.find(key);
-    if (kpos == std::string::npos) return;
+    if (kpos == std::string_view::npos) return false;
 
     auto colon = json.find(':', kpos + key.size());
-    if (colon == std::string::npos) return;
+    if (colon == std::string_view::npos) return false;
 
     auto q1 = json.find('"', colon);
-    if (q1 == std::string::npos) return;
+    if (q1 == std::string_view::npos) return false;
     auto q2 = json.find('"', q1 + 1);
-    if (q2 == std::string::npos) return;
+    if (q2 == std::string_view::npos) return false;
+
+    begin = q1 + 1;
+    end = q2;
+    return true;
+}
 
-    for (std::size_t i = q1 + 1; i < q2; ++i) {
-        json[i] = '0';
+// zlib's crc32 takes a uInt length; larger buffers are fed in pieces.
+static uLong crc32_update(uLong crc, const std::uint8_t* data, std::size_t len) {
+    constexpr std::size_t kMaxChunk = std::size_t{1} << 30;
+    while (len > 0) {
+        const std::size_t n = std::min(len, kMaxChunk);
+        crc = ::crc32(crc, reinterpret_cast<const Bytef*>(data), static_cast<uInt>(n));
+        data += n;
+        len -= n;
     }
+    return crc;
 }
 
 static std::uint32_t crc32_bytes(const std::uint8_t* data, std::size_t len) {
-    uLong crc = ::crc32(0L, Z_NULL, 0);
-    crc = ::crc32(crc, reinterpret_cast<const Bytef*>(data), static_cast<uInt>(len));
+    return static_cast<std::uint32_t>(crc32_update(::crc32(0L, Z_NULL, 0), data, len));
+}
+
+// CRC32 of the header text with its "header_crc32_hex" value read as all '0's (the stored
+// CRC covers that form). Chained over prefix, zeros and suffix, so the header is not copied.
+static std::uint32_t crc32_str_zeroed_header(std::string_view json) {
+    static const std::array<std::uint8_t, 16> kZeros = {
+        '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0'};
+    const auto* bytes = reinterpret_cast<const std::uint8_t*>(json.data());
+
+    std::size_t begin = json.size();
+    std::size_t end = json.size();
+    if (!find_header_crc_value(json, begin, end)) begin = end = json.size();
+
+    uLong crc = crc32_update(::crc32(0L, Z_NULL, 0), bytes, begin);
+    for (std::size_t left = end - begin; left > 0;) {
+        const std::size_t n = std::min(left, kZeros.size());
+        crc = crc32_update(crc, kZeros.data(), n);
+        left -= n;
+    }
+    crc = crc32_update(crc, bytes + end, json.size() - end);
     return static_cast<std::uint32_t>(crc);
 }
 
-static std::uint32_t crc32_str_zeroed_header(const std::string& header_json_raw) {
-    std::string tmp = header_json_raw;
-    zero_out_header_crc_value(tmp);
-    return crc32_bytes(reinterpret_cast<const std::uint8_t*>(tmp.data()), tmp.size());
+static bool is_uncompressed(const std::string& compression) {
+    return compression.empty() || compression == "none";
+}
+
+static const Codec& require_codec(const std::string& name) {
+    const Codec* c = find_codec(name);
+    if (!c) {
+        throw GbfError(ErrorKind::Unsupported, "unsupported compression codec: '" + name + "'");
+    }
+    return *c;
 }
 
-static std::vector<std::uint8_t> zlib_compress(const std::vector<std::uint8_t>& in, int level) {
+static ByteBuffer codec_compress(const Codec& c, const ByteBuffer& in, int level) {
     if (in.empty()) return {};
-    uLongf bound = ::compressBound(static_cast<uLong>(in.size()));
-    std::vector<std::uint8_t> out(bound);
-
-    uLongf out_len = bound;
-    int rc = ::compress2(reinterpret_cast<Bytef*>(out.data()), &out_len,
-                         reinterpret_cast<const Bytef*>(in.data()),
-                         static_cast<uLong>(in.size()),
-                         level);
-    if (rc != Z_OK) {
-        throw GbfError(ErrorKind::ZlibError, "zlib compress2 failed");
-    }
-    out.resize(static_cast<std::size_t>(out_len));
+    ByteBuffer out = ByteBuffer::uninitialized(c.bound(in.size()));
+    std::size_t n = c.compress(in.data(), in.size(), out.data(), out.size(), level);
+    out.resize(n);
     return out;
 }
 
-static std::vector<std::uint8_t> zlib_decompress(const std::vector<std::uint8_t>& in, std::size_t usize) {
+static ByteBuffer codec_decompress(const Codec& c, const ByteBuffer& in, std::size_t usize) {
     if (usize == 0) return {};
     if (usize > static_cast<std::size_t>(kMaxFieldUsize)) {
         throw GbfError(ErrorKind::InvalidData, "field usize exceeds configured limit");
     }
-    std::vector<std::uint8_t> out(usize);
-    uLongf out_len = static_cast<uLongf>(usize);
-    int rc = ::uncompress(reinterpret_cast<Bytef*>(out.data()), &out_len,
-                          reinterpret_cast<const Bytef*>(in.data()),
-                          static_cast<uLong>(in.size()));
-    if (rc != Z_OK || static_cast<std::size_t>(out_len) != usize) {
-        throw GbfError(ErrorKind::ZlibError, "zlib uncompress failed");
-    }
+    ByteBuffer out = ByteBuffer::uninitialized(usize);
+    c.decompress(in.data(), in.size(), out.data(), usize);
     return out;
 }
 
@@ -655,6 +726,207 @@ NumericClass numeric_class_from_string(const std::string& s) {
     return NumericClass::Unknown;
 }
 
+// ------------------------------
+// Field kinds and interned strings
+// ------------------------------
+
+namespace {
+
+// Indexed by FieldKind.
+const std::string kKindNames[] = {
+    "unknown", "struct", "numeric", "logical", "string", "char",
+    "datetime", "duration", "calendarduration", "categorical",
+};
+
+// The metadata strings InternedString shares: fixed at first use and never changed, so
+// lookups take no lock. Anything else is owned by the InternedString holding it.
+class Vocabulary {
+public:
+    static const Vocabulary& instance() {
+        static const Vocabulary* v = new Vocabulary(); // never destroyed: static metadata may outlive it
+        return *v;
+    }
+
+    const std::string* find(std::string_view s) const {
+        auto it = words_.find(s);
+        return it == words_.end() ? nullptr : it->second;
+    }
+
+private:
+    Vocabulary() {
+        static const std::string kWords[] = {
+            // classes
+            "double", "single", "int8", "uint8", "int16", "uint16", "int32", "uint32", "int64", "uint64",
+            "logical", "string", "char", "datetime", "duration", "calendarDuration", "categorical",
+            // encodings
+            "empty-scalar-struct", "utf-8", "utf-16-codeunits", "dt:naive-unixms+nat-mask+tz+locale+format",
+            "dt:tz-unixms+nat-mask+tz+locale+format", "ms-i64+nan-mask", "mask+months-i32+days-i32+time-ms-i64",
+            "cats-utf8+codes-u32",
+            // compression
+            "none", "extents",
+        };
+        for (const auto& w : kKindNames) add(w);
+        for (const auto& w : kWords) add(w);
+    }
+
+    void add(const std::string& w) { words_.emplace(std::string_view(w), &w); }
+
+    std::unordered_map<std::string_view, const std::string*> words_;
+};
+
+} // namespace
+
+const std::string& to_string(FieldKind k) {
+    const auto i = static_cast<std::size_t>(k);
+    return i < std::size(kKindNames) ? kKindNames[i] : kKindNames[0];
+}
+
+FieldKind field_kind_from_string(std::string_view s) {
+    for (std::size_t i = 1; i < std::size(kKindNames); ++i) {
+        if (kKindNames[i] == s) return static_cast<FieldKind>(i);
+    }
+    return FieldKind::Unknown;
+}
+
+const std::string* InternedString::empty_string() noexcept {
+    static const std::string kEmpty;
+    return &kEmpty;
+}
+
+InternedString::InternedString(std::string_view s) : s_(empty_string()) {
+    if (s.empty()) return;
+    if (const std::string* w = Vocabulary::instance().find(s)) {
+        s_ = w;
+    } else if (const Codec* c = find_codec(std::string(s))) {
+        s_ = &c->name; // registered codecs are never replaced or freed
+    } else {
+        owned_ = std::make_shared<const std::string>(s);
+        s_ = owned_.get();
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const InternedString& s) {
+    return os << s.str();
+}
+
+static void set_meta_kind(FieldMeta& meta, FieldKind kind) {
+    meta.kind = kind;
+    meta.kind_name = InternedString();
+}
+
+static void set_meta_kind(FieldMeta& meta, const std::string& kind) {
+    meta.kind = field_kind_from_string(kind);
+    meta.kind_name = meta.kind == FieldKind::Unknown ? InternedString(kind) : InternedString();
+}
+
+// Set after the kind: only numeric fields get a class_id.
+static void set_meta_class(FieldMeta& meta, const InternedString& class_name) {
+    meta.class_name = class_name;
+    meta.class_id = meta.kind == FieldKind::Numeric ? numeric_class_from_string(class_name) : NumericClass::Unknown;
+}
+
+// ------------------------------
+// Columnar field table
+// ------------------------------
+
+FieldTable::FieldTable(const std::vector<FieldMeta>& fields) {
+    std::size_t name_bytes = 0;
+    for (const auto& f : fields) name_bytes += f.name.size();
+    reserve(fields.size(), name_bytes);
+    for (const auto& f : fields) push_back(f);
+}
+
+void FieldTable::reserve(std::size_t fields, std::size_t name_bytes) {
+    names_.reserve(name_bytes);
+    name_ends_.reserve(fields);
+    kinds_.reserve(fields);
+    class_names_.reserve(fields);
+    class_ids_.reserve(fields);
+    complex_.reserve(fields);
+    dims_.reserve(fields * 2);
+    dim_ends_.reserve(fields);
+    encodings_.reserve(fields);
+    compressions_.reserve(fields);
+    levels_.reserve(fields);
+    extent_ends_.reserve(fields);
+    offsets_.reserve(fields);
+    csizes_.reserve(fields);
+    usizes_.reserve(fields);
+    crc32s_.reserve(fields);
+}
+
+void FieldTable::push_back(const FieldMeta& f) {
+    names_ += f.name;
+    name_ends_.push_back(names_.size());
+    kinds_.push_back(f.kind);
+    if (f.kind == FieldKind::Unknown) unknown_kinds_.emplace_back(size() - 1, f.kind_name);
+    class_names_.push_back(f.class_name);
+    class_ids_.push_back(f.class_id);
+    complex_.push_back(f.complex ? 1 : 0);
+    dims_.insert(dims_.end(), f.shape.begin(), f.shape.end());
+    dim_ends_.push_back(dims_.size());
+    encodings_.push_back(f.encoding);
+    compressions_.push_back(f.compression);
+    levels_.push_back(f.level);
+    extents_.insert(extents_.end(), f.extents.begin(), f.extents.end());
+    extent_ends_.push_back(extents_.size());
+    offsets_.push_back(f.offset);
+    csizes_.push_back(f.csize);
+    usizes_.push_back(f.usize);
+    crc32s_.push_back(f.crc32);
+}
+
+std::string_view FieldTable::name(std::size_t i) const {
+    const std::size_t begin = i == 0 ? 0 : name_ends_[i - 1];
+    return std::string_view(names_.data() + begin, name_ends_[i] - begin);
+}
+
+const std::string& FieldTable::kind_str(std::size_t i) const {
+    if (kinds_[i] != FieldKind::Unknown) return to_string(kinds_[i]);
+    auto it = std::lower_bound(unknown_kinds_.begin(), unknown_kinds_.end(), i,
+                               [](const auto& e, std::size_t k) { return e.first < k; });
+    return it->second.str();
+}
+
+Span<const std::uint64_t> FieldTable::shape(std::size_t i) const {
+    const std::size_t begin = i == 0 ? 0 : dim_ends_[i - 1];
+    return Span<const std::uint64_t>(dims_.data() + begin, dim_ends_[i] - begin);
+}
+
+Span<const FieldExtent> FieldTable::extents(std::size_t i) const {
+    const std::size_t begin = i == 0 ? 0 : extent_ends_[i - 1];
+    return Span<const FieldExtent>(extents_.data() + begin, extent_ends_[i] - begin);
+}
+
+FieldMeta FieldTable::meta(std::size_t i) const {
+    FieldMeta f;
+    f.name = std::string(name(i));
+    f.kind = kinds_[i];
+    if (f.kind == FieldKind::Unknown) f.kind_name = kind_str(i);
+    f.class_name = class_names_[i];
+    f.class_id = class_ids_[i];
+    const Span<const std::uint64_t> dims = shape(i);
+    f.shape.assign(dims.begin(), dims.end());
+    f.complex = complex_[i] != 0;
+    f.encoding = encodings_[i];
+    f.compression = compressions_[i];
+    f.offset = offsets_[i];
+    f.csize = csizes_[i];
+    f.usize = usizes_[i];
+    f.crc32 = crc32s_[i];
+    f.level = levels_[i];
+    const Span<const FieldExtent> ext = extents(i);
+    f.extents.assign(ext.begin(), ext.end());
+    return f;
+}
+
+std::vector<FieldMeta> FieldTable::to_fields() const {
+    std::vector<FieldMeta> out;
+    out.reserve(size());
+    for (std::size_t i = 0; i < size(); ++i) out.push_back(meta(i));
+    return out;
+}
+
 static std::size_t bytes_per_elem(NumericClass c) {
     switch (c) {
         case NumericClass::Double: return 8;
@@ -671,6 +943,369 @@ static std::size_t bytes_per_elem(NumericClass c) {
     }
 }
 
+// ------------------------------
+// Byte buffers and typed numeric views
+// ------------------------------
+
+ByteBuffer::ByteBuffer(std::size_t n, std::uint8_t value) { resize(n, value); }
+
+ByteBuffer::ByteBuffer(ByteBuffer&& o) noexcept
+    : data_(o.data_), size_(o.size_), capacity_(o.capacity_), owner_(o.owner_), release_(o.release_) {
+    o.data_ = nullptr;
+    o.size_ = o.capacity_ = 0;
+    o.owner_ = nullptr;
+    o.release_ = nullptr;
+}
+
+ByteBuffer& ByteBuffer::operator=(const ByteBuffer& o) {
+    if (this != &o) assign(o.begin(), o.end());
+    return *this;
+}
+
+ByteBuffer& ByteBuffer::operator=(ByteBuffer&& o) noexcept {
+    if (this != &o) {
+        release();
+        std::swap(data_, o.data_);
+        std::swap(size_, o.size_);
+        std::swap(capacity_, o.capacity_);
+        std::swap(owner_, o.owner_);
+        std::swap(release_, o.release_);
+    }
+    return *this;
+}
+
+ByteBuffer::~ByteBuffer() { release(); }
+
+void ByteBuffer::release() noexcept {
+    if (release_) release_(owner_, capacity_);
+    else if (data_) ::operator delete(data_, std::align_val_t{alignment});
+    data_ = nullptr;
+    size_ = capacity_ = 0;
+    owner_ = nullptr;
+    release_ = nullptr;
+}
+
+#if !defined(_WIN32)
+static void unmap_buffer(void* owner, std::size_t len) { ::munmap(owner, len); }
+#endif
+
+// Moves the contents to fresh aligned storage of `cap` bytes (adopted storage included).
+// Huge buffers are mapped rather than taken from the heap: the pages arrive zeroed and
+// untouched, and can be backed by transparent huge pages.
+void ByteBuffer::reallocate(std::size_t cap) {
+    std::uint8_t* p = nullptr;
+    void* owner = nullptr;
+    void (*release)(void*, std::size_t) = nullptr;
+#if !defined(_WIN32)
+    if (cap >= huge_bytes) {
+        static const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        cap = (cap + page - 1) & ~(page - 1);
+        void* m = ::mmap(nullptr, cap, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (m == MAP_FAILED) throw std::bad_alloc();
+#if defined(MADV_HUGEPAGE)
+        ::madvise(m, cap, MADV_HUGEPAGE); // advisory; ignored where THP is off
+#endif
+        p = static_cast<std::uint8_t*>(m);
+        owner = m;
+        release = unmap_buffer;
+    }
+#endif
+    if (!p) p = static_cast<std::uint8_t*>(::operator new(cap, std::align_val_t{alignment}));
+    const std::size_t n = size_;
+    if (n > 0) std::memcpy(p, data_, n);
+    this->release();
+    data_ = p;
+    size_ = n;
+    capacity_ = cap;
+    owner_ = owner;
+    release_ = release;
+}
+
+std::uint8_t* ByteBuffer::open_gap(std::size_t at, std::size_t n) {
+    if (n == 0) return data_ + at;
+    if (n > std::numeric_limits<std::size_t>::max() - size_) throw std::length_error("ByteBuffer too large");
+    const std::size_t need = size_ + n;
+    if (need > capacity_) reallocate(std::max(need, capacity_ + capacity_ / 2));
+    if (at < size_) std::memmove(data_ + at + n, data_ + at, size_ - at);
+    size_ = need;
+    return data_ + at;
+}
+
+void ByteBuffer::reserve(std::size_t n) {
+    if (n > capacity_) reallocate(n);
+}
+
+void ByteBuffer::shrink_to_fit() {
+    if (size_ == capacity_) return;
+#if !defined(_WIN32)
+    if (release_ == unmap_buffer && size_ > 0) {
+        static const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        const std::size_t keep = (size_ + page - 1) & ~(page - 1);
+        if (keep < capacity_) ::munmap(data_ + keep, capacity_ - keep);
+        capacity_ = keep;
+        return;
+    }
+#endif
+    if (size_ == 0) release();
+    else reallocate(size_);
+}
+
+void ByteBuffer::resize(std::size_t n, std::uint8_t value) {
+    if (n <= size_) {
+        size_ = n;
+        return;
+    }
+    const std::size_t grow = n - size_;
+    std::memset(open_gap(size_, grow), value, grow);
+}
+
+void ByteBuffer::resize_uninitialized(std::size_t n) {
+    if (n <= size_) size_ = n;
+    else open_gap(size_, n - size_);
+}
+
+void ByteBuffer::push_back(std::uint8_t b) { *open_gap(size_, 1) = b; }
+
+bool ByteBuffer::equal(const ByteBuffer& a, const ByteBuffer& b) noexcept {
+    return a.size_ == b.size_ && (a.size_ == 0 || std::memcmp(a.data_, b.data_, a.size_) == 0);
+}
+
+void NumericArray::check_view(const ByteBuffer& b, NumericClass want, std::size_t align) const {
+    if (want != class_id) {
+        throw GbfError(ErrorKind::InvalidData, "element type does not match class " + to_string(class_id));
+    }
+    if (!kHostLittleEndian) {
+        throw GbfError(ErrorKind::Unsupported, "typed numeric spans need a little-endian host");
+    }
+    if (b.size() % bytes_per_elem(want) != 0 || reinterpret_cast<std::uintptr_t>(b.data()) % align != 0) {
+        throw GbfError(ErrorKind::InvalidData, "numeric storage is not a whole number of aligned elements");
+    }
+}
+
+const ByteBuffer& NumericArray::imag_part() const {
+    if (!complex || !imag_le) throw GbfError(ErrorKind::InvalidData, "numeric array is not complex");
+    return *imag_le;
+}
+
+// ------------------------------
+// Columnar strings
+// ------------------------------
+
+StringColumn StringColumn::from_array(const StringArray& a) {
+    StringColumn c;
+    c.shape = a.shape;
+    std::size_t total = 0;
+    for (const auto& el : a.data) total += el ? el->size() : 0;
+    c.blob.reserve(total);
+    c.valid.reserve((a.data.size() + 7) / 8);
+    c.offsets.reserve(a.data.size() + 1);
+    for (const auto& el : a.data) {
+        if (el) c.push_back(*el);
+        else c.push_missing();
+    }
+    return c;
+}
+
+StringArray StringColumn::to_array() const {
+    StringArray a;
+    a.shape = shape;
+    a.data.reserve(size());
+    for (std::size_t i = 0; i < size(); ++i) {
+        if (is_missing(i)) a.data.emplace_back(std::nullopt);
+        else a.data.emplace_back(std::string(view(i)));
+    }
+    return a;
+}
+
+// ------------------------------
+// Char arrays (UTF-8 <-> UTF-16)
+// ------------------------------
+//
+// Both directions run 16 bytes (8 code units) at a time while the text is ASCII and drop to a
+// scalar loop for the rest of a block that is not.
+
+namespace {
+
+#if defined(GBIN_SIMD_NEON)
+// Largest lane. vmaxvq_* exist only on AArch64; 32-bit ARM folds with pairwise maxima.
+inline std::uint8_t max_lane(uint8x16_t v) noexcept {
+#if defined(__aarch64__)
+    return vmaxvq_u8(v);
+#else
+    uint8x8_t m = vpmax_u8(vget_low_u8(v), vget_high_u8(v));
+    m = vpmax_u8(m, m);
+    m = vpmax_u8(m, m);
+    m = vpmax_u8(m, m);
+    return vget_lane_u8(m, 0);
+#endif
+}
+
+inline std::uint16_t max_lane(uint16x8_t v) noexcept {
+#if defined(__aarch64__)
+    return vmaxvq_u16(v);
+#else
+    uint16x4_t m = vpmax_u16(vget_low_u16(v), vget_high_u16(v));
+    m = vpmax_u16(m, m);
+    m = vpmax_u16(m, m);
+    return vget_lane_u16(m, 0);
+#endif
+}
+#endif
+
+// Widens the leading ASCII bytes of [p, p + n) into out; returns how many it consumed.
+std::size_t widen_ascii(const std::uint8_t* p, std::size_t n, std::uint16_t* out) noexcept {
+    std::size_t i = 0;
+#if defined(GBIN_SIMD_X86) && defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        if (_mm_movemask_epi8(v) != 0) break;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpackhi_epi8(v, zero));
+    }
+#elif defined(GBIN_SIMD_NEON)
+    for (; i + 16 <= n; i += 16) {
+        const uint8x16_t v = vld1q_u8(p + i);
+        if (max_lane(v) >= 0x80) break;
+        vst1q_u16(out + i, vmovl_u8(vget_low_u8(v)));
+        vst1q_u16(out + i + 8, vmovl_u8(vget_high_u8(v)));
+    }
+#endif
+    for (; i < n && p[i] < 0x80; ++i) out[i] = p[i];
+    return i;
+}
+
+// Narrows the leading ASCII code units of [p, p + n) into out; returns how many it consumed.
+std::size_t narrow_ascii(const std::uint16_t* p, std::size_t n, char* out) noexcept {
+    std::size_t i = 0;
+#if defined(GBIN_SIMD_X86) && defined(__SSE2__)
+    const __m128i high = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, high), zero)) != 0xFFFF) break;
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(v, v));
+    }
+#elif defined(GBIN_SIMD_NEON)
+    for (; i + 8 <= n; i += 8) {
+        const uint16x8_t v = vld1q_u16(p + i);
+        if (max_lane(v) >= 0x80) break;
+        vst1_u8(reinterpret_cast<std::uint8_t*>(out + i), vmovn_u16(v));
+    }
+#endif
+    for (; i < n && p[i] < 0x80; ++i) out[i] = static_cast<char>(p[i]);
+    return i;
+}
+
+[[noreturn]] void bad_utf8(std::size_t at) {
+    throw GbfError(ErrorKind::InvalidData, "invalid UTF-8 at byte " + std::to_string(at));
+}
+
+} // namespace
+
+CharArray CharArray::from_utf8(std::string_view s) {
+    const auto* p = reinterpret_cast<const std::uint8_t*>(s.data());
+    const std::size_t n = s.size();
+    // One code unit per lead byte, two for 4-byte sequences. Malformed input throws before its
+    // units are written, so this bounds the output even when it is wrong.
+    std::size_t units = 0;
+    for (std::size_t i = 0; i < n; ++i) units += ((p[i] & 0xC0) != 0x80) + (p[i] >= 0xF0);
+    CharArray c;
+    c.utf16.resize(units);
+    std::uint16_t* out = c.utf16.data();
+    std::size_t i = 0;
+    std::size_t o = 0;
+    while (i < n) {
+        const std::size_t run = widen_ascii(p + i, n - i, out + o);
+        i += run;
+        o += run;
+        if (i == n) break;
+
+        const std::uint8_t b0 = p[i];
+        std::size_t len = 0;
+        std::uint32_t cp = 0;
+        std::uint32_t min = 0;
+        if ((b0 & 0xE0) == 0xC0) {
+            len = 2; cp = b0 & 0x1Fu; min = 0x80;
+        } else if ((b0 & 0xF0) == 0xE0) {
+            len = 3; cp = b0 & 0x0Fu; min = 0x800;
+        } else if ((b0 & 0xF8) == 0xF0) {
+            len = 4; cp = b0 & 0x07u; min = 0x10000;
+        } else {
+            bad_utf8(i);
+        }
+        if (n - i < len) bad_utf8(i);
+        for (std::size_t k = 1; k < len; ++k) {
+            if ((p[i + k] & 0xC0) != 0x80) bad_utf8(i + k);
+            cp = (cp << 6) | (p[i + k] & 0x3Fu);
+        }
+        // Overlong forms, UTF-16 surrogates and code points past U+10FFFF are not valid UTF-8.
+        if (cp < min || (cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF) bad_utf8(i);
+        i += len;
+
+        if (cp < 0x10000) {
+            out[o++] = static_cast<std::uint16_t>(cp);
+        } else {
+            cp -= 0x10000;
+            out[o++] = static_cast<std::uint16_t>(0xD800 + (cp >> 10));
+            out[o++] = static_cast<std::uint16_t>(0xDC00 + (cp & 0x3FF));
+        }
+    }
+    c.utf16.resize(o);
+    if (o > 0) c.shape = {1, o};
+    return c;
+}
+
+std::string CharArray::to_utf8() const {
+    const std::uint16_t* p = utf16.data();
+    const std::size_t n = utf16.size();
+    // Exact UTF-8 length: 1-3 bytes per unit; a surrogate half is 2 of its pair's 4 bytes, or
+    // 3 for the U+FFFD that replaces it when unpaired.
+    std::size_t bytes = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::uint16_t u = p[i];
+        if (u < 0x80) bytes += 1;
+        else if (u < 0x800) bytes += 2;
+        else if (u < 0xD800 || u > 0xDFFF) bytes += 3;
+        else if (u <= 0xDBFF && i + 1 < n && p[i + 1] >= 0xDC00 && p[i + 1] <= 0xDFFF) bytes += 4, ++i;
+        else bytes += 3;
+    }
+    std::string s(bytes, '\0');
+    char* out = s.data();
+    std::size_t i = 0;
+    std::size_t o = 0;
+    while (i < n) {
+        const std::size_t run = narrow_ascii(p + i, n - i, out + o);
+        i += run;
+        o += run;
+        if (i == n) break;
+
+        std::uint32_t cp = p[i++];
+        if (cp >= 0xD800 && cp <= 0xDFFF) {
+            if (cp <= 0xDBFF && i < n && p[i] >= 0xDC00 && p[i] <= 0xDFFF) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (p[i++] - 0xDC00u);
+            } else {
+                cp = 0xFFFD; // unpaired surrogate
+            }
+        }
+        if (cp <= 0x7FF) {
+            out[o++] = static_cast<char>(0xC0 | (cp >> 6));
+            out[o++] = static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp <= 0xFFFF) {
+            out[o++] = static_cast<char>(0xE0 | (cp >> 12));
+            out[o++] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out[o++] = static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out[o++] = static_cast<char>(0xF0 | (cp >> 18));
+            out[o++] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out[o++] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out[o++] = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+    s.resize(o);
+    return s;
+}
+
 // ------------------------------
 // GbfValue helpers
 // ------------------------------
@@ -687,80 +1322,153 @@ GbfValue GbfValue::make_struct(const Struct& m) {
     return v;
 }
 
+GbfValue GbfValue::make_struct(Struct&& m) {
+    GbfValue v;
+    v.v = std::move(m);
+    return v;
+}
+
 GbfValue GbfValue::make_numeric(const NumericArray& a) {
     GbfValue v;
     v.v = a;
     return v;
 }
 
+GbfValue GbfValue::make_numeric(NumericArray&& a) {
+    GbfValue v;
+    v.v = std::move(a);
+    return v;
+}
+
 GbfValue GbfValue::make_logical(const LogicalArray& a) {
     GbfValue v;
     v.v = a;
     return v;
 }
 
+GbfValue GbfValue::make_logical(LogicalArray&& a) {
+    GbfValue v;
+    v.v = std::move(a);
+    return v;
+}
+
 GbfValue GbfValue::make_string(const StringArray& a) {
     GbfValue v;
     v.v = a;
     return v;
 }
 
-GbfValue GbfValue::make_char(const CharArray& a) {
+GbfValue GbfValue::make_string(StringArray&& a) {
     GbfValue v;
-    v.v = a;
+    v.v = std::move(a);
     return v;
 }
 
-GbfValue GbfValue::make_datetime(const DateTimeArray& a) {
+GbfValue GbfValue::make_string_column(const StringColumn& a) {
     GbfValue v;
     v.v = a;
     return v;
 }
 
-GbfValue GbfValue::make_duration(const DurationArray& a) {
+GbfValue GbfValue::make_string_column(StringColumn&& a) {
     GbfValue v;
-    v.v = a;
+    v.v = std::move(a);
     return v;
 }
 
-GbfValue GbfValue::make_calendarduration(const CalendarDurationArray& a) {
+GbfValue GbfValue::make_char(const CharArray& a) {
     GbfValue v;
     v.v = a;
     return v;
 }
 
-GbfValue GbfValue::make_categorical(const CategoricalArray& a) {
+GbfValue GbfValue::make_char(CharArray&& a) {
     GbfValue v;
-    v.v = a;
+    v.v = std::move(a);
     return v;
 }
 
-GbfValue GbfValue::make_opaque(const OpaqueValue& a) {
+GbfValue GbfValue::make_datetime(const DateTimeArray& a) {
     GbfValue v;
     v.v = a;
     return v;
 }
 
-bool GbfValue::is_struct() const noexcept {
-    return std::holds_alternative<Struct>(v);
+GbfValue GbfValue::make_datetime(DateTimeArray&& a) {
+    GbfValue v;
+    v.v = std::move(a);
+    return v;
 }
 
-const GbfValue::Struct& GbfValue::as_struct() const {
-    if (!std::holds_alternative<Struct>(v)) throw GbfError(ErrorKind::InvalidData, "value is not a struct");
-    return std::get<Struct>(v);
+GbfValue GbfValue::make_duration(const DurationArray& a) {
+    GbfValue v;
+    v.v = a;
+    return v;
 }
 
-GbfValue::Struct& GbfValue::as_struct() {
-    if (!std::holds_alternative<Struct>(v)) throw GbfError(ErrorKind::InvalidData, "value is not a struct");
-    return std::get<Struct>(v);
+GbfValue GbfValue::make_duration(DurationArray&& a) {
+    GbfValue v;
+    v.v = std::move(a);
+    return v;
+}
+
+GbfValue GbfValue::make_calendarduration(const CalendarDurationArray& a) {
+    GbfValue v;
+    v.v = a;
+    return v;
+}
+
+GbfValue GbfValue::make_calendarduration(CalendarDurationArray&& a) {
+    GbfValue v;
+    v.v = std::move(a);
+    return v;
+}
+
+GbfValue GbfValue::make_categorical(const CategoricalArray& a) {
+    GbfValue v;
+    v.v = a;
+    return v;
+}
+
+GbfValue GbfValue::make_categorical(CategoricalArray&& a) {
+    GbfValue v;
+    v.v = std::move(a);
+    return v;
+}
+
+GbfValue GbfValue::make_opaque(const OpaqueValue& a) {
+    GbfValue v;
+    v.v = a;
+    return v;
+}
+
+GbfValue GbfValue::make_opaque(OpaqueValue&& a) {
+    GbfValue v;
+    v.v = std::move(a);
+    return v;
+}
+
+bool GbfValue::is_struct() const noexcept {
+    return std::holds_alternative<Struct>(v);
+}
+
+const GbfValue::Struct& GbfValue::as_struct() const {
+    if (!std::holds_alternative<Struct>(v)) throw GbfError(ErrorKind::InvalidData, "value is not a struct");
+    return std::get<Struct>(v);
+}
+
+GbfValue::Struct& GbfValue::as_struct() {
+    if (!std::holds_alternative<Struct>(v)) throw GbfError(ErrorKind::InvalidData, "value is not a struct");
+    return std::get<Struct>(v);
 }
 
 // ------------------------------
 // Header parse/build
 // ------------------------------
 
-static Header parse_header(const std::string& raw_json) {
-    internal::JsonParser p(raw_json);
+// With `skip_fields`, the "fields" array is stepped over (the field index supplies it).
+static Header parse_header(const std::string& raw_json, bool skip_fields = false) {
+    internal::JsonParser p(raw_json, skip_fields ? "fields" : "");
     internal::Json root = p.parse();
     if (!root.is_object()) throw GbfError(ErrorKind::HeaderJsonParse, "header JSON is not an object");
 
@@ -779,6 +1487,23 @@ static Header parse_header(const std::string& raw_json) {
     if (auto* v = obj_get(obj, "payload_start")) h.payload_start = u64_from_json(*v);
     if (auto* v = obj_get(obj, "file_size")) h.file_size = u64_from_json(*v);
     if (auto* v = obj_get(obj, "header_crc32_hex")) h.header_crc32_hex = str_from_json(*v);
+    if (auto* v = obj_get(obj, "index"); v && v->is_object()) {
+        FieldIndexRef ref;
+        const auto& io = v->as_object();
+        if (auto* x = obj_get(io, "offset")) ref.offset = u64_from_json(*x);
+        if (auto* x = obj_get(io, "size")) ref.size = u64_from_json(*x);
+        if (auto* x = obj_get(io, "crc32")) ref.crc32 = u32_from_json(*x);
+        h.field_index = ref;
+    }
+
+    // Neighbouring fields mostly repeat these strings; reuse the previous one before going to
+    // the intern pool.
+    FieldMeta last;
+    auto intern = [](InternedString& prev, const internal::Json& j) -> const InternedString& {
+        const std::string v = str_from_json(j);
+        if (prev != v) prev = InternedString(v);
+        return prev;
+    };
 
     if (auto* fv = obj_get(obj, "fields")) {
         if (std::holds_alternative<internal::Json::Array>(fv->v)) {
@@ -787,16 +1512,31 @@ static Header parse_header(const std::string& raw_json) {
                 const auto& fo = fj.as_object();
                 FieldMeta f;
                 if (auto* x = obj_get(fo, "name")) f.name = str_from_json(*x);
-                if (auto* x = obj_get(fo, "kind")) f.kind = str_from_json(*x);
-                if (auto* x = obj_get(fo, "class")) f.class_name = str_from_json(*x);
+                if (auto* x = obj_get(fo, "kind")) set_meta_kind(f, str_from_json(*x));
+                if (auto* x = obj_get(fo, "class")) set_meta_class(f, intern(last.class_name, *x));
                 if (auto* x = obj_get(fo, "shape")) f.shape = shape_u64_from_json(*x);
                 if (auto* x = obj_get(fo, "complex")) f.complex = bool_from_json(*x, false);
-                if (auto* x = obj_get(fo, "encoding")) f.encoding = str_from_json(*x);
-                if (auto* x = obj_get(fo, "compression")) f.compression = str_from_json(*x);
+                if (auto* x = obj_get(fo, "encoding")) f.encoding = intern(last.encoding, *x);
+                if (auto* x = obj_get(fo, "compression")) f.compression = intern(last.compression, *x);
                 if (auto* x = obj_get(fo, "offset")) f.offset = u64_from_json(*x);
                 if (auto* x = obj_get(fo, "csize")) f.csize = u64_from_json(*x);
                 if (auto* x = obj_get(fo, "usize")) f.usize = u64_from_json(*x);
                 if (auto* x = obj_get(fo, "crc32")) f.crc32 = u32_from_json(*x);
+                if (auto* x = obj_get(fo, "level")) f.level = static_cast<int>(u64_from_json(*x));
+                if (auto* x = obj_get(fo, "extents"); x && x->is_array()) {
+                    for (const auto& ej : x->as_array()) {
+                        if (!ej.is_object()) continue;
+                        const auto& eo = ej.as_object();
+                        FieldExtent e;
+                        if (auto* y = obj_get(eo, "compression")) e.compression = intern(last.compression, *y);
+                        if (auto* y = obj_get(eo, "offset")) e.offset = u64_from_json(*y);
+                        if (auto* y = obj_get(eo, "csize")) e.csize = u64_from_json(*y);
+                        if (auto* y = obj_get(eo, "usize")) e.usize = u64_from_json(*y);
+                        if (auto* y = obj_get(eo, "crc32")) e.crc32 = u32_from_json(*y);
+                        if (auto* y = obj_get(eo, "n")) e.count = u64_from_json(*y);
+                        f.extents.push_back(std::move(e));
+                    }
+                }
                 h.fields.push_back(std::move(f));
             }
         }
@@ -805,53 +1545,182 @@ static Header parse_header(const std::string& raw_json) {
     return h;
 }
 
-static internal::Json header_to_json(const Header& h, bool crc_zeroed) {
-    using internal::Json;
-    using internal::json_bool;
-    using internal::json_str;
-    using internal::json_u64;
-
-    internal::Json::Object obj;
-
-    obj.emplace("format", json_str(h.format));
-    obj.emplace("magic", json_str(h.magic));
-    obj.emplace("version", internal::json_u64(static_cast<std::uint64_t>(h.version)));
-    obj.emplace("endianness", json_str(h.endianness));
-    obj.emplace("order", json_str(h.order));
-    obj.emplace("root", json_str(h.root));
-    if (!h.created_utc.empty()) obj.emplace("created_utc", json_str(h.created_utc));
-    if (!h.matlab_version.empty()) obj.emplace("matlab_version", json_str(h.matlab_version));
+// ------------------------------
+// Header emission
+// ------------------------------
 
-    // fields
-    internal::Json::Array fields;
-    fields.reserve(h.fields.size());
-    for (const auto& f : h.fields) {
-        internal::Json::Object fo;
-        fo.emplace("name", json_str(f.name));
-        fo.emplace("kind", json_str(f.kind));
-        fo.emplace("class", json_str(f.class_name));
+// Positions in emitted header text (see emit_header).
+struct HeaderSlots {
+    std::size_t file_size{0};     // where the file_size digits go
+    std::size_t payload_start{0}; // where the payload_start digits go
+    std::size_t crc{0};           // first of the 8 header CRC hex digits
+};
 
-        internal::Json::Array shape;
-        for (auto d : f.shape) shape.push_back(json_u64(d));
-        fo.emplace("shape", Json{shape});
+static std::size_t decimal_digits(std::uint64_t v) {
+    std::size_t d = 1;
+    while (v >= 10) {
+        v /= 10;
+        ++d;
+    }
+    return d;
+}
 
-        fo.emplace("complex", json_bool(f.complex));
-        fo.emplace("encoding", json_str(f.encoding));
-        fo.emplace("compression", json_str(f.compression));
-        fo.emplace("offset", json_u64(f.offset));
-        fo.emplace("csize", json_u64(f.csize));
-        fo.emplace("usize", json_u64(f.usize));
-        fo.emplace("crc32", json_u64(f.crc32));
+static void put_u64(std::string& out, std::uint64_t v) {
+    char buf[20];
+    const auto r = std::to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, r.ptr);
+}
 
-        fields.push_back(Json{fo});
+static void put_json_string(std::string& out, const std::string& s) {
+    static const char kHex[] = "0123456789abcdef";
+    out.push_back('"');
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    out += "\\u00";
+                    out.push_back(kHex[c >> 4]);
+                    out.push_back(kHex[c & 0xF]);
+                } else {
+                    out.push_back(static_cast<char>(c));
+                }
+        }
     }
-    obj.emplace("fields", Json{fields});
+    out.push_back('"');
+}
+
+// `key` is a plain ASCII literal; `lead` is ',' or '{'.
+static void put_key(std::string& out, char lead, const char* key) {
+    out.push_back(lead);
+    out.push_back('"');
+    out += key;
+    out += "\":";
+}
 
-    obj.emplace("payload_start", json_u64(h.payload_start));
-    obj.emplace("file_size", json_u64(h.file_size));
-    obj.emplace("header_crc32_hex", json_str(crc_zeroed ? "00000000" : h.header_crc32_hex));
+// Write header JSON text straight into a string, in the key order a std::map-backed Json
+// object serializes to (sorted), without building a DOM. The CRC is emitted as "00000000"
+// for seal_header_crc() to fill in. With `layout_holes`, the payload_start and file_size
+// numbers are left out and their insertion points recorded, so the layout can be solved
+// arithmetically and spliced in by place_header().
+static std::string emit_header(const Header& h, HeaderSlots& slots, bool layout_holes) {
+    std::string out;
+    out.reserve(256 + h.fields.size() * 224);
 
-    return Json{obj};
+    char lead = '{';
+    if (!h.created_utc.empty()) {
+        put_key(out, lead, "created_utc");
+        put_json_string(out, h.created_utc);
+        lead = ',';
+    }
+    put_key(out, lead, "endianness");
+    put_json_string(out, h.endianness);
+
+    put_key(out, ',', "fields");
+    out.push_back('[');
+    for (std::size_t i = 0; i < h.fields.size(); ++i) {
+        const FieldMeta& f = h.fields[i];
+        if (i) out.push_back(',');
+        put_key(out, '{', "class");
+        put_json_string(out, f.class_name);
+        put_key(out, ',', "complex");
+        out += f.complex ? "true" : "false";
+        put_key(out, ',', "compression");
+        put_json_string(out, f.compression);
+        put_key(out, ',', "crc32");
+        put_u64(out, f.crc32);
+        put_key(out, ',', "csize");
+        put_u64(out, f.csize);
+        put_key(out, ',', "encoding");
+        put_json_string(out, f.encoding);
+        if (!f.extents.empty()) {
+            put_key(out, ',', "extents");
+            out.push_back('[');
+            for (std::size_t k = 0; k < f.extents.size(); ++k) {
+                const FieldExtent& e = f.extents[k];
+                if (k) out.push_back(',');
+                put_key(out, '{', "compression");
+                put_json_string(out, e.compression);
+                put_key(out, ',', "crc32");
+                put_u64(out, e.crc32);
+                put_key(out, ',', "csize");
+                put_u64(out, e.csize);
+                put_key(out, ',', "n");
+                put_u64(out, e.count);
+                put_key(out, ',', "offset");
+                put_u64(out, e.offset);
+                put_key(out, ',', "usize");
+                put_u64(out, e.usize);
+                out.push_back('}');
+            }
+            out.push_back(']');
+        }
+        put_key(out, ',', "kind");
+        put_json_string(out, f.kind_str());
+        if (f.level >= 0) {
+            put_key(out, ',', "level");
+            put_u64(out, static_cast<std::uint64_t>(f.level));
+        }
+        put_key(out, ',', "name");
+        put_json_string(out, f.name);
+        put_key(out, ',', "offset");
+        put_u64(out, f.offset);
+        put_key(out, ',', "shape");
+        out.push_back('[');
+        for (std::size_t k = 0; k < f.shape.size(); ++k) {
+            if (k) out.push_back(',');
+            put_u64(out, f.shape[k]);
+        }
+        out.push_back(']');
+        put_key(out, ',', "usize");
+        put_u64(out, f.usize);
+        out.push_back('}');
+    }
+    out.push_back(']');
+
+    put_key(out, ',', "file_size");
+    slots.file_size = out.size();
+    if (!layout_holes) put_u64(out, h.file_size);
+    put_key(out, ',', "format");
+    put_json_string(out, h.format);
+    put_key(out, ',', "header_crc32_hex");
+    out.push_back('"');
+    slots.crc = out.size();
+    out += "00000000";
+    out.push_back('"');
+    if (h.field_index) {
+        put_key(out, ',', "index");
+        put_key(out, '{', "crc32");
+        put_u64(out, h.field_index->crc32);
+        put_key(out, ',', "offset");
+        put_u64(out, h.field_index->offset);
+        put_key(out, ',', "size");
+        put_u64(out, h.field_index->size);
+        out.push_back('}');
+    }
+    put_key(out, ',', "magic");
+    put_json_string(out, h.magic);
+    if (!h.matlab_version.empty()) {
+        put_key(out, ',', "matlab_version");
+        put_json_string(out, h.matlab_version);
+    }
+    put_key(out, ',', "order");
+    put_json_string(out, h.order);
+    put_key(out, ',', "payload_start");
+    slots.payload_start = out.size();
+    if (!layout_holes) put_u64(out, h.payload_start);
+    put_key(out, ',', "root");
+    put_json_string(out, h.root);
+    put_key(out, ',', "version");
+    put_u64(out, static_cast<std::uint64_t>(h.version));
+    out.push_back('}');
+    return out;
 }
 
 // ------------------------------
@@ -867,23 +1736,75 @@ static std::vector<std::uint8_t> encode_u32_le(std::uint32_t v) {
     };
 }
 
-static void append_u32_le(std::vector<std::uint8_t>& out, std::uint32_t v) {
+// Buf: std::vector<std::uint8_t> or ByteBuffer.
+template <class Buf>
+static void append_u32_le(Buf& out, std::uint32_t v) {
     auto b = encode_u32_le(v);
     out.insert(out.end(), b.begin(), b.end());
 }
 
-static void append_i32_le(std::vector<std::uint8_t>& out, std::int32_t v) {
+template <class Buf>
+static void append_i32_le(Buf& out, std::int32_t v) {
     append_u32_le(out, static_cast<std::uint32_t>(v));
 }
 
-static void append_i64_le(std::vector<std::uint8_t>& out, std::int64_t v) {
+template <class Buf>
+static void append_i64_le(Buf& out, std::int64_t v) {
     std::uint64_t u = static_cast<std::uint64_t>(v);
     for (int i = 0; i < 8; ++i) out.push_back(static_cast<std::uint8_t>((u >> (8*i)) & 0xFFu));
 }
 
-static void append_u16_le(std::vector<std::uint8_t>& out, std::uint16_t v) {
-    out.push_back(static_cast<std::uint8_t>(v & 0xFFu));
-    out.push_back(static_cast<std::uint8_t>((v >> 8) & 0xFFu));
+template <class Buf>
+static void append_u64_le(Buf& out, std::uint64_t v) {
+    append_i64_le(out, static_cast<std::int64_t>(v));
+}
+
+// Fills a payload buffer that was sized exactly up front. The encoders compute the full
+// payload size first, so writing never reallocates; integer arrays are one memcpy, plus an
+// in-place byte swap on big-endian hosts.
+class SizedWriter {
+public:
+    explicit SizedWriter(ByteBuffer& out) : p_(out.data()) {}
+
+    void u8(std::uint8_t v) { *p_++ = v; }
+
+    void u32(std::uint32_t v) {
+        p_[0] = static_cast<std::uint8_t>(v);
+        p_[1] = static_cast<std::uint8_t>(v >> 8);
+        p_[2] = static_cast<std::uint8_t>(v >> 16);
+        p_[3] = static_cast<std::uint8_t>(v >> 24);
+        p_ += 4;
+    }
+
+    void bytes(const void* src, std::size_t n) {
+        if (n > 0) std::memcpy(p_, src, n);
+        p_ += n;
+    }
+
+    // [u32 len][bytes]; the length must already have been checked by prefixed_size().
+    void prefixed(std::string_view s) {
+        u32(static_cast<std::uint32_t>(s.size()));
+        bytes(s.data(), s.size());
+    }
+
+    template <class T>
+    void array(const std::vector<T>& xs) {
+        static_assert(std::is_integral<T>::value, "integer arrays only");
+        std::uint8_t* start = p_;
+        bytes(xs.data(), xs.size() * sizeof(T));
+        if constexpr (!kHostLittleEndian) byteswap_inplace(start, sizeof(T), xs.size());
+    }
+
+private:
+    std::uint8_t* p_;
+};
+
+// Encoded size of a [u32 len][bytes] string.
+static std::size_t prefixed_size(std::string_view s) {
+    if (s.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw GbfError(ErrorKind::InvalidData, "string element exceeds 4 GiB");
+    }
+    return 4 + s.size();
 }
 
 static std::uint32_t read_u32_le_from(const std::uint8_t* p) {
@@ -893,42 +1814,145 @@ static std::uint32_t read_u32_le_from(const std::uint8_t* p) {
            (static_cast<std::uint32_t>(p[3]) << 24);
 }
 
-static std::int32_t read_i32_le_from(const std::uint8_t* p) {
-    return static_cast<std::int32_t>(read_u32_le_from(p));
-}
-
 static std::int64_t read_i64_le_from(const std::uint8_t* p) {
     std::uint64_t u = 0;
     for (int i = 0; i < 8; ++i) u |= (static_cast<std::uint64_t>(p[i]) << (8*i));
     return static_cast<std::int64_t>(u);
 }
 
-static std::uint16_t read_u16_le_from(const std::uint8_t* p) {
-    return static_cast<std::uint16_t>(p[0] | (static_cast<std::uint16_t>(p[1]) << 8));
+// Decodes n little-endian integers starting at src into out: one memcpy, plus an in-place
+// byte swap on big-endian hosts.
+template <class T>
+static void read_le_array(const std::uint8_t* src, std::size_t n, std::vector<T>& out) {
+    static_assert(std::is_integral<T>::value, "integer arrays only");
+    out.resize(n);
+    if (n == 0) return;
+    std::memcpy(out.data(), src, n * sizeof(T));
+    if constexpr (!kHostLittleEndian) byteswap_inplace(out.data(), sizeof(T), n);
+}
+
+static void set_meta_shape(FieldMeta& meta, const std::vector<std::size_t>& shape) {
+    meta.shape.clear();
+    meta.shape.reserve(shape.size());
+    for (auto d : shape) meta.shape.push_back(static_cast<std::uint64_t>(d));
+}
+
+// Interned once; describe_value runs per field, also on writer threads.
+static const InternedString& numeric_class_name(NumericClass c) {
+    static const std::vector<InternedString> names = [] {
+        std::vector<InternedString> v;
+        for (int i = 0; i <= static_cast<int>(NumericClass::Unknown); ++i) v.emplace_back(to_string(static_cast<NumericClass>(i)));
+        return v;
+    }();
+    return names[static_cast<std::size_t>(c)];
+}
+
+static void describe_as(FieldMeta& meta, FieldKind kind, const InternedString& class_name, const InternedString& encoding) {
+    set_meta_kind(meta, kind);
+    meta.class_name = class_name;
+    meta.class_id = NumericClass::Unknown;
+    meta.encoding = encoding;
+}
+
+// Fill kind/class/encoding/complex/shape of `meta` from a value, without encoding any payload.
+static void describe_value(const GbfValue& v, FieldMeta& meta) {
+    static const InternedString kNone("");
+    static const InternedString kStruct("struct");
+    static const InternedString kLogical("logical");
+    static const InternedString kString("string");
+    static const InternedString kChar("char");
+    static const InternedString kDateTime("datetime");
+    static const InternedString kDuration("duration");
+    static const InternedString kCalendarDuration("calendarDuration");
+    static const InternedString kCategorical("categorical");
+    meta.complex = false;
+
+    if (std::holds_alternative<GbfValue::Struct>(v.v)) {
+        static const InternedString enc("empty-scalar-struct");
+        describe_as(meta, FieldKind::Struct, kStruct, enc);
+        return;
+    }
+    if (std::holds_alternative<NumericArray>(v.v)) {
+        const auto& a = std::get<NumericArray>(v.v);
+        describe_as(meta, FieldKind::Numeric, numeric_class_name(a.class_id), kNone);
+        meta.class_id = a.class_id;
+        meta.complex = a.complex;
+        set_meta_shape(meta, a.shape);
+        return;
+    }
+    if (std::holds_alternative<LogicalArray>(v.v)) {
+        describe_as(meta, FieldKind::Logical, kLogical, kNone);
+        set_meta_shape(meta, std::get<LogicalArray>(v.v).shape);
+        return;
+    }
+    if (std::holds_alternative<StringArray>(v.v)) {
+        static const InternedString enc("utf-8");
+        describe_as(meta, FieldKind::String, kString, enc);
+        set_meta_shape(meta, std::get<StringArray>(v.v).shape);
+        return;
+    }
+    if (std::holds_alternative<StringColumn>(v.v)) {
+        static const InternedString enc("utf-8");
+        describe_as(meta, FieldKind::String, kString, enc);
+        set_meta_shape(meta, std::get<StringColumn>(v.v).shape);
+        return;
+    }
+    if (std::holds_alternative<CharArray>(v.v)) {
+        static const InternedString enc("utf-16-codeunits");
+        describe_as(meta, FieldKind::Char, kChar, enc);
+        set_meta_shape(meta, std::get<CharArray>(v.v).shape);
+        return;
+    }
+    if (std::holds_alternative<DateTimeArray>(v.v)) {
+        static const InternedString naive("dt:naive-unixms+nat-mask+tz+locale+format");
+        static const InternedString zoned("dt:tz-unixms+nat-mask+tz+locale+format");
+        const auto& a = std::get<DateTimeArray>(v.v);
+        describe_as(meta, FieldKind::DateTime, kDateTime, a.timezone.empty() ? naive : zoned);
+        set_meta_shape(meta, a.shape);
+        return;
+    }
+    if (std::holds_alternative<DurationArray>(v.v)) {
+        static const InternedString enc("ms-i64+nan-mask");
+        describe_as(meta, FieldKind::Duration, kDuration, enc);
+        set_meta_shape(meta, std::get<DurationArray>(v.v).shape);
+        return;
+    }
+    if (std::holds_alternative<CalendarDurationArray>(v.v)) {
+        static const InternedString enc("mask+months-i32+days-i32+time-ms-i64");
+        describe_as(meta, FieldKind::CalendarDuration, kCalendarDuration, enc);
+        set_meta_shape(meta, std::get<CalendarDurationArray>(v.v).shape);
+        return;
+    }
+    if (std::holds_alternative<CategoricalArray>(v.v)) {
+        static const InternedString enc("cats-utf8+codes-u32");
+        describe_as(meta, FieldKind::Categorical, kCategorical, enc);
+        set_meta_shape(meta, std::get<CategoricalArray>(v.v).shape);
+        return;
+    }
+    if (std::holds_alternative<OpaqueValue>(v.v)) {
+        const auto& a = std::get<OpaqueValue>(v.v);
+        set_meta_kind(meta, a.kind);
+        set_meta_class(meta, a.class_name);
+        meta.encoding = a.encoding;
+        meta.complex = a.complex;
+        set_meta_shape(meta, a.shape);
+        return;
+    }
+    throw GbfError(ErrorKind::Unsupported, "unsupported value variant");
 }
 
-static std::vector<std::uint8_t> encode_value_bytes(const GbfValue& v, FieldMeta& meta) {
-    std::vector<std::uint8_t> out;
+static ByteBuffer encode_value_bytes(const GbfValue& v, FieldMeta& meta) {
+    ByteBuffer out;
+    describe_value(v, meta);
 
     // struct: only empty scalar struct is encoded as empty.
     if (std::holds_alternative<GbfValue::Struct>(v.v)) {
-        meta.kind = "struct";
-        meta.class_name = "struct";
-        meta.encoding = "empty-scalar-struct";
-        meta.complex = false;
         meta.usize = 0;
         return {};
     }
 
     if (std::holds_alternative<NumericArray>(v.v)) {
         const auto& a = std::get<NumericArray>(v.v);
-        meta.kind = "numeric";
-        meta.class_name = to_string(a.class_id);
-        meta.encoding = "";
-        meta.complex = a.complex;
-        // shape in header is u64
-        meta.shape.clear();
-        for (auto d : a.shape) meta.shape.push_back(static_cast<std::uint64_t>(d));
 
         const std::size_t elem = bytes_per_elem(a.class_id);
         std::size_t expected_real = 0;
@@ -949,7 +1973,7 @@ static std::vector<std::uint8_t> encode_value_bytes(const GbfValue& v, FieldMeta
             }
         }
 
-        out = a.real_le;
+        out.assign(a.real_le.begin(), a.real_le.end());
         if (a.complex) {
             if (!a.imag_le) throw GbfError(ErrorKind::InvalidData, "complex numeric requires imag_le");
             const auto& im = *a.imag_le;
@@ -961,40 +1985,49 @@ static std::vector<std::uint8_t> encode_value_bytes(const GbfValue& v, FieldMeta
 
     if (std::holds_alternative<LogicalArray>(v.v)) {
         const auto& a = std::get<LogicalArray>(v.v);
-        meta.kind = "logical";
-        meta.class_name = "logical";
-        meta.encoding = "";
-        meta.complex = false;
-        meta.shape.clear();
-        for (auto d : a.shape) meta.shape.push_back(static_cast<std::uint64_t>(d));
-        out = a.data;
+        out.assign(a.data.begin(), a.data.end());
         meta.usize = static_cast<std::uint64_t>(out.size());
         return out;
     }
 
     if (std::holds_alternative<StringArray>(v.v)) {
         const auto& a = std::get<StringArray>(v.v);
-        meta.kind = "string";
-        meta.class_name = "string";
-        meta.encoding = "utf-8";
-        meta.complex = false;
-        meta.shape.clear();
-        for (auto d : a.shape) meta.shape.push_back(static_cast<std::uint64_t>(d));
 
         // Per-element: [u8 missing][u32 len][bytes]
         if (a.data.size() != numel(a.shape)) {
             throw GbfError(ErrorKind::InvalidData, "string array data length does not match shape");
         }
+        std::size_t total = a.data.size();
+        for (const auto& el : a.data) total += el ? prefixed_size(*el) : 4;
+        out = ByteBuffer::uninitialized(total);
+        SizedWriter w(out);
         for (const auto& el : a.data) {
-            if (!el.has_value()) {
-                out.push_back(1);
-                append_u32_le(out, 0);
-            } else {
-                out.push_back(0);
-                const auto& s = *el;
-                append_u32_le(out, static_cast<std::uint32_t>(s.size()));
-                out.insert(out.end(), s.begin(), s.end());
-            }
+            w.u8(el ? 0 : 1);
+            w.prefixed(el ? std::string_view(*el) : std::string_view());
+        }
+        meta.usize = static_cast<std::uint64_t>(out.size());
+        return out;
+    }
+
+    if (std::holds_alternative<StringColumn>(v.v)) {
+        const auto& a = std::get<StringColumn>(v.v);
+
+        // Same layout as StringArray, filled straight from the blob.
+        const std::size_t n = numel(a.shape);
+        if (a.size() != n || a.valid.size() < (n + 7) / 8 || a.offsets.back() > a.blob.size()) {
+            throw GbfError(ErrorKind::InvalidData, "string column does not match shape");
+        }
+        std::size_t total = n;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (a.offsets[i] > a.offsets[i + 1]) throw GbfError(ErrorKind::InvalidData, "string column offsets decrease");
+            total += a.is_missing(i) ? 4 : prefixed_size(a.view(i));
+        }
+        out = ByteBuffer::uninitialized(total);
+        SizedWriter w(out);
+        for (std::size_t i = 0; i < n; ++i) {
+            const bool missing = a.is_missing(i);
+            w.u8(missing ? 1 : 0);
+            w.prefixed(missing ? std::string_view() : a.view(i));
         }
         meta.usize = static_cast<std::uint64_t>(out.size());
         return out;
@@ -1002,32 +2035,18 @@ static std::vector<std::uint8_t> encode_value_bytes(const GbfValue& v, FieldMeta
 
     if (std::holds_alternative<CharArray>(v.v)) {
         const auto& a = std::get<CharArray>(v.v);
-        meta.kind = "char";
-        meta.class_name = "char";
-        meta.encoding = "utf-16-codeunits";
-        meta.complex = false;
-        meta.shape.clear();
-        for (auto d : a.shape) meta.shape.push_back(static_cast<std::uint64_t>(d));
 
         if (a.utf16.size() != numel(a.shape)) {
             throw GbfError(ErrorKind::InvalidData, "char array data length does not match shape");
         }
-        out.reserve(a.utf16.size() * 2);
-        for (std::uint16_t cu : a.utf16) append_u16_le(out, cu);
+        out = ByteBuffer::uninitialized(a.utf16.size() * 2);
+        SizedWriter(out).array(a.utf16);
         meta.usize = static_cast<std::uint64_t>(out.size());
         return out;
     }
 
     if (std::holds_alternative<DateTimeArray>(v.v)) {
         const auto& a = std::get<DateTimeArray>(v.v);
-        meta.kind = "datetime";
-        meta.class_name = "datetime";
-        meta.encoding = a.timezone.empty()
-            ? "dt:naive-unixms+nat-mask+tz+locale+format"
-            : "dt:tz-unixms+nat-mask+tz+locale+format";
-        meta.complex = false;
-        meta.shape.clear();
-        for (auto d : a.shape) meta.shape.push_back(static_cast<std::uint64_t>(d));
 
         std::size_t n = numel(a.shape);
         if (a.nat_mask.size() != n || a.unix_ms.size() != n) {
@@ -1037,15 +2056,15 @@ static std::vector<std::uint8_t> encode_value_bytes(const GbfValue& v, FieldMeta
         // Layout inferred from MATLAB files:
         // [u8 n_strings=3] [u32 tz_len][tz bytes] [u32 locale_len][locale bytes] [u32 fmt_len][fmt bytes]
         // [nat_mask bytes (n)] [i64 unix_ms values (n)]
-        out.push_back(3);
-        append_u32_le(out, static_cast<std::uint32_t>(a.timezone.size()));
-        out.insert(out.end(), a.timezone.begin(), a.timezone.end());
-        append_u32_le(out, static_cast<std::uint32_t>(a.locale.size()));
-        out.insert(out.end(), a.locale.begin(), a.locale.end());
-        append_u32_le(out, static_cast<std::uint32_t>(a.format.size()));
-        out.insert(out.end(), a.format.begin(), a.format.end());
-        out.insert(out.end(), a.nat_mask.begin(), a.nat_mask.end());
-        for (auto ms : a.unix_ms) append_i64_le(out, ms);
+        out = ByteBuffer::uninitialized(1 + prefixed_size(a.timezone) + prefixed_size(a.locale) +
+                                        prefixed_size(a.format) + n * 9);
+        SizedWriter w(out);
+        w.u8(3);
+        w.prefixed(a.timezone);
+        w.prefixed(a.locale);
+        w.prefixed(a.format);
+        w.array(a.nat_mask);
+        w.array(a.unix_ms);
 
         meta.usize = static_cast<std::uint64_t>(out.size());
         return out;
@@ -1053,19 +2072,15 @@ static std::vector<std::uint8_t> encode_value_bytes(const GbfValue& v, FieldMeta
 
     if (std::holds_alternative<DurationArray>(v.v)) {
         const auto& a = std::get<DurationArray>(v.v);
-        meta.kind = "duration";
-        meta.class_name = "duration";
-        meta.encoding = "ms-i64+nan-mask";
-        meta.complex = false;
-        meta.shape.clear();
-        for (auto d : a.shape) meta.shape.push_back(static_cast<std::uint64_t>(d));
 
         std::size_t n = numel(a.shape);
         if (a.nan_mask.size() != n || a.ms.size() != n) {
             throw GbfError(ErrorKind::InvalidData, "duration arrays must match shape");
         }
-        out.insert(out.end(), a.nan_mask.begin(), a.nan_mask.end());
-        for (auto ms : a.ms) append_i64_le(out, ms);
+        out = ByteBuffer::uninitialized(n * 9);
+        SizedWriter w(out);
+        w.array(a.nan_mask);
+        w.array(a.ms);
 
         meta.usize = static_cast<std::uint64_t>(out.size());
         return out;
@@ -1073,21 +2088,17 @@ static std::vector<std::uint8_t> encode_value_bytes(const GbfValue& v, FieldMeta
 
     if (std::holds_alternative<CalendarDurationArray>(v.v)) {
         const auto& a = std::get<CalendarDurationArray>(v.v);
-        meta.kind = "calendarduration";
-        meta.class_name = "calendarDuration";
-        meta.encoding = "mask+months-i32+days-i32+time-ms-i64";
-        meta.complex = false;
-        meta.shape.clear();
-        for (auto d : a.shape) meta.shape.push_back(static_cast<std::uint64_t>(d));
 
         std::size_t n = numel(a.shape);
         if (a.mask.size() != n || a.months.size() != n || a.days.size() != n || a.time_ms.size() != n) {
             throw GbfError(ErrorKind::InvalidData, "calendarduration arrays must match shape");
         }
-        out.insert(out.end(), a.mask.begin(), a.mask.end());
-        for (auto x : a.months) append_i32_le(out, x);
-        for (auto x : a.days) append_i32_le(out, x);
-        for (auto x : a.time_ms) append_i64_le(out, x);
+        out = ByteBuffer::uninitialized(n * 17);
+        SizedWriter w(out);
+        w.array(a.mask);
+        w.array(a.months);
+        w.array(a.days);
+        w.array(a.time_ms);
 
         meta.usize = static_cast<std::uint64_t>(out.size());
         return out;
@@ -1095,24 +2106,20 @@ static std::vector<std::uint8_t> encode_value_bytes(const GbfValue& v, FieldMeta
 
     if (std::holds_alternative<CategoricalArray>(v.v)) {
         const auto& a = std::get<CategoricalArray>(v.v);
-        meta.kind = "categorical";
-        meta.class_name = "categorical";
-        meta.encoding = "cats-utf8+codes-u32";
-        meta.complex = false;
-        meta.shape.clear();
-        for (auto d : a.shape) meta.shape.push_back(static_cast<std::uint64_t>(d));
 
         std::size_t n = numel(a.shape);
         if (a.codes.size() != n) {
             throw GbfError(ErrorKind::InvalidData, "categorical codes must match shape");
         }
 
-        append_u32_le(out, static_cast<std::uint32_t>(a.categories.size()));
-        for (const auto& s : a.categories) {
-            append_u32_le(out, static_cast<std::uint32_t>(s.size()));
-            out.insert(out.end(), s.begin(), s.end());
-        }
-        for (auto code : a.codes) append_u32_le(out, code);
+        // [u32 n_categories] ([u32 len][bytes])* [u32 codes (n)]
+        std::size_t total = 4 + n * 4;
+        for (const auto& s : a.categories) total += prefixed_size(s);
+        out = ByteBuffer::uninitialized(total);
+        SizedWriter w(out);
+        w.u32(static_cast<std::uint32_t>(a.categories.size()));
+        for (const auto& s : a.categories) w.prefixed(s);
+        w.array(a.codes);
 
         meta.usize = static_cast<std::uint64_t>(out.size());
         return out;
@@ -1120,13 +2127,7 @@ static std::vector<std::uint8_t> encode_value_bytes(const GbfValue& v, FieldMeta
 
     if (std::holds_alternative<OpaqueValue>(v.v)) {
         const auto& a = std::get<OpaqueValue>(v.v);
-        meta.kind = a.kind;
-        meta.class_name = a.class_name;
-        meta.encoding = a.encoding;
-        meta.complex = a.complex;
-        meta.shape.clear();
-        for (auto d : a.shape) meta.shape.push_back(static_cast<std::uint64_t>(d));
-        out = a.bytes;
+        out.assign(a.bytes.begin(), a.bytes.end());
         meta.usize = static_cast<std::uint64_t>(out.size());
         return out;
     }
@@ -1134,257 +2135,291 @@ static std::vector<std::uint8_t> encode_value_bytes(const GbfValue& v, FieldMeta
     throw GbfError(ErrorKind::Unsupported, "unsupported value variant");
 }
 
-static GbfValue decode_value_bytes(const FieldMeta& meta, const std::vector<std::uint8_t>& bytes) {
-    const std::string kind = meta.kind;
-    const std::string cls = meta.class_name;
-    std::vector<std::size_t> shape = shape_usize_from_u64(meta.shape);
-    std::size_t n = numel(shape);
+// ------------------------------
+// Decoding, one function per FieldKind
+// ------------------------------
+//
+// Each decoder gets the payload (possibly empty: usize == 0) and the field's shape. Decoders
+// that keep the bytes as-is (numeric, logical, opaque) adopt the buffer instead of copying it.
 
-    // Empty payloads: construct empty containers per kind.
-    if (bytes.empty()) {
-        if (kind == "struct") {
-            return GbfValue::make_struct();
-        }
-        if (kind == "numeric") {
-            NumericArray a;
-            a.class_id = numeric_class_from_string(cls);
-            a.shape = shape;
-            a.complex = meta.complex;
-            return GbfValue::make_numeric(a);
-        }
-        if (kind == "logical") {
-            LogicalArray a;
-            a.shape = shape;
-            return GbfValue::make_logical(a);
-        }
-        if (kind == "string") {
-            StringArray a;
-            a.shape = shape;
-            a.data.assign(n, std::nullopt);
-            return GbfValue::make_string(a);
-        }
-        if (kind == "char") {
-            CharArray a;
-            a.shape = shape;
-            return GbfValue::make_char(a);
-        }
-        // Others: create opaque.
-        OpaqueValue o;
-        o.kind = kind;
-        o.class_name = cls;
-        o.shape = shape;
-        o.complex = meta.complex;
-        o.encoding = meta.encoding;
-        o.bytes = bytes;
-        return GbfValue::make_opaque(o);
-    }
-
-    if (kind == "struct") {
-        // empty scalar struct marker
-        return GbfValue::make_struct();
-    }
-
-    if (kind == "numeric") {
-        NumericArray a;
-        a.class_id = numeric_class_from_string(cls);
-        a.shape = shape;
-        a.complex = meta.complex;
+namespace {
 
-        const std::size_t elem = bytes_per_elem(a.class_id);
-        std::size_t expected_real = 0;
-        if (!checked_mul_size(n, elem, expected_real)) {
+using Decoder = GbfValue (*)(const FieldMeta&, std::vector<std::size_t>&&, ByteBuffer&&);
+
+GbfValue decode_opaque(const FieldMeta& meta, std::vector<std::size_t>&& shape, ByteBuffer&& bytes) {
+    OpaqueValue o;
+    o.kind = meta.kind_str();
+    o.class_name = meta.class_name;
+    o.shape = std::move(shape);
+    o.complex = meta.complex;
+    o.encoding = meta.encoding;
+    o.bytes = std::move(bytes);
+    return GbfValue::make_opaque(std::move(o));
+}
+
+GbfValue decode_struct(const FieldMeta&, std::vector<std::size_t>&&, ByteBuffer&&) {
+    // empty scalar struct marker
+    return GbfValue::make_struct();
+}
+
+GbfValue decode_numeric(const FieldMeta& meta, std::vector<std::size_t>&& shape, ByteBuffer&& bytes) {
+    NumericArray a;
+    a.class_id = meta.class_id;
+    a.complex = meta.complex;
+    const std::size_t n = numel(shape);
+    a.shape = std::move(shape);
+    if (bytes.empty()) return GbfValue::make_numeric(std::move(a));
+
+    const std::size_t elem = bytes_per_elem(a.class_id);
+    std::size_t expected_real = 0;
+    if (!checked_mul_size(n, elem, expected_real)) {
+        throw GbfError(ErrorKind::InvalidData, "numeric expected size overflow");
+    }
+
+    if (!a.complex) {
+        if (bytes.size() != expected_real) {
+            throw GbfError(ErrorKind::InvalidData, "numeric payload size does not match shape/class");
+        }
+        a.real_le = std::move(bytes);
+    } else {
+        std::size_t expected_total = 0;
+        if (!checked_mul_size(expected_real, 2, expected_total)) {
             throw GbfError(ErrorKind::InvalidData, "numeric expected size overflow");
         }
+        if (bytes.size() != expected_total) {
+            throw GbfError(ErrorKind::InvalidData, "complex numeric payload size does not match shape/class");
+        }
+        // Only the imaginary half is copied; the real half keeps the payload buffer, minus the
+        // tail it no longer needs.
+        a.imag_le = ByteBuffer::uninitialized(expected_real);
+        std::memcpy(a.imag_le->data(), bytes.data() + expected_real, expected_real);
+        bytes.resize(expected_real);
+        bytes.shrink_to_fit();
+        a.real_le = std::move(bytes);
+    }
+    return GbfValue::make_numeric(std::move(a));
+}
 
-        if (!a.complex) {
-            if (bytes.size() != expected_real) {
-                throw GbfError(ErrorKind::InvalidData, "numeric payload size does not match shape/class");
-            }
-            a.real_le = bytes;
+GbfValue decode_logical(const FieldMeta&, std::vector<std::size_t>&& shape, ByteBuffer&& bytes) {
+    LogicalArray a;
+    a.shape = std::move(shape);
+    a.data = std::move(bytes);
+    return GbfValue::make_logical(std::move(a));
+}
+
+GbfValue decode_string(const FieldMeta&, std::vector<std::size_t>&& shape, ByteBuffer&& bytes) {
+    StringArray a;
+    const std::size_t n = numel(shape);
+    a.shape = std::move(shape);
+    if (bytes.empty()) {
+        a.data.assign(n, std::nullopt);
+        return GbfValue::make_string(std::move(a));
+    }
+    a.data.reserve(n);
+
+    std::size_t pos = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (pos + 1 + 4 > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated string payload");
+        std::uint8_t missing = bytes[pos];
+        std::uint32_t len = read_u32_le_from(&bytes[pos + 1]);
+        pos += 1 + 4;
+        if (pos + len > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated string payload");
+        if (missing != 0) {
+            // ignore len bytes if len>0? (should be 0)
+            pos += len;
+            a.data.push_back(std::nullopt);
         } else {
-            std::size_t expected_total = 0;
-            if (!checked_mul_size(expected_real, 2, expected_total)) {
-                throw GbfError(ErrorKind::InvalidData, "numeric expected size overflow");
-            }
-            if (bytes.size() != expected_total) {
-                throw GbfError(ErrorKind::InvalidData, "complex numeric payload size does not match shape/class");
-            }
-            a.real_le.assign(bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(expected_real));
-            std::vector<std::uint8_t> im(bytes.begin() + static_cast<std::ptrdiff_t>(expected_real), bytes.end());
-            a.imag_le = std::move(im);
+            std::string s(reinterpret_cast<const char*>(&bytes[pos]), reinterpret_cast<const char*>(&bytes[pos + len]));
+            pos += len;
+            a.data.push_back(std::move(s));
         }
-        return GbfValue::make_numeric(a);
     }
+    // ignore trailing bytes (tolerant)
+    return GbfValue::make_string(std::move(a));
+}
 
-    if (kind == "logical") {
-        LogicalArray a;
-        a.shape = shape;
-        a.data = bytes;
-        return GbfValue::make_logical(a);
+// decode_string into a StringColumn: one pass to validate and size, one to copy.
+GbfValue decode_string_column(const FieldMeta&, std::vector<std::size_t>&& shape, ByteBuffer&& bytes) {
+    StringColumn a;
+    const std::size_t n = numel(shape);
+    a.shape = std::move(shape);
+    a.valid.assign((n + 7) / 8, 0);
+    a.offsets.resize(n + 1, 0);
+    if (bytes.empty()) return GbfValue::make_string_column(std::move(a));
+
+    std::size_t pos = 0;
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (pos + 1 + 4 > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated string payload");
+        const std::uint32_t len = read_u32_le_from(&bytes[pos + 1]);
+        if (pos + 5 + len > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated string payload");
+        if (bytes[pos] == 0) total += len;
+        pos += 5 + len;
     }
 
-    if (kind == "string") {
-        StringArray a;
-        a.shape = shape;
-        a.data.clear();
-        a.data.reserve(n);
-
-        std::size_t pos = 0;
-        for (std::size_t i = 0; i < n; ++i) {
-            if (pos + 1 + 4 > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated string payload");
-            std::uint8_t missing = bytes[pos];
-            std::uint32_t len = read_u32_le_from(&bytes[pos + 1]);
-            pos += 1 + 4;
-            if (pos + len > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated string payload");
-            if (missing != 0) {
-                // ignore len bytes if len>0? (should be 0)
-                pos += len;
-                a.data.push_back(std::nullopt);
-            } else {
-                std::string s(reinterpret_cast<const char*>(&bytes[pos]), reinterpret_cast<const char*>(&bytes[pos + len]));
-                pos += len;
-                a.data.push_back(std::move(s));
-            }
+    a.blob.resize(total);
+    pos = 0;
+    std::size_t at = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::uint32_t len = read_u32_le_from(&bytes[pos + 1]);
+        if (bytes[pos] == 0) {
+            a.valid[i >> 3] |= static_cast<std::uint8_t>(1u << (i & 7));
+            if (len > 0) std::memcpy(&a.blob[at], &bytes[pos + 5], len);
+            at += len;
         }
-        // ignore trailing bytes (tolerant)
-        return GbfValue::make_string(a);
+        a.offsets[i + 1] = at;
+        pos += 5 + len;
     }
+    return GbfValue::make_string_column(std::move(a));
+}
 
-    if (kind == "char") {
-        CharArray a;
-        a.shape = shape;
-        std::size_t expected = n * 2;
-        if (bytes.size() < expected) throw GbfError(ErrorKind::Truncated, "truncated char payload");
-        a.utf16.reserve(n);
-        for (std::size_t i = 0; i < n; ++i) {
-            a.utf16.push_back(read_u16_le_from(&bytes[i * 2]));
-        }
-        return GbfValue::make_char(a);
-    }
-
-    if (kind == "datetime") {
-        DateTimeArray a;
-        a.shape = shape;
-        std::size_t pos = 0;
-        if (pos + 1 > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated datetime payload");
-        std::uint8_t nstr = bytes[pos++];
-        // Expect 3 strings, but be tolerant.
-        std::vector<std::string> strs;
-        for (std::size_t si = 0; si < nstr; ++si) {
-            if (pos + 4 > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated datetime payload");
-            std::uint32_t len = read_u32_le_from(&bytes[pos]);
-            pos += 4;
-            if (pos + len > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated datetime payload");
-            strs.emplace_back(reinterpret_cast<const char*>(&bytes[pos]), reinterpret_cast<const char*>(&bytes[pos + len]));
-            pos += len;
-        }
-        // Map: [tz, locale, format] when available.
-        if (strs.size() > 0) a.timezone = strs[0];
-        if (strs.size() > 1) a.locale = strs[1];
-        if (strs.size() > 2) a.format = strs[2];
-
-        if (pos + n > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated datetime payload");
-        a.nat_mask.assign(bytes.begin() + static_cast<std::ptrdiff_t>(pos), bytes.begin() + static_cast<std::ptrdiff_t>(pos + n));
-        pos += n;
+GbfValue decode_char(const FieldMeta&, std::vector<std::size_t>&& shape, ByteBuffer&& bytes) {
+    CharArray a;
+    const std::size_t n = numel(shape);
+    a.shape = std::move(shape);
+    if (bytes.empty()) return GbfValue::make_char(std::move(a));
+    std::size_t expected = n * 2;
+    if (bytes.size() < expected) throw GbfError(ErrorKind::Truncated, "truncated char payload");
+    read_le_array(bytes.data(), n, a.utf16);
+    return GbfValue::make_char(std::move(a));
+}
 
-        if (pos + 8 * n > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated datetime payload");
-        a.unix_ms.resize(n);
-        for (std::size_t i = 0; i < n; ++i) {
-            a.unix_ms[i] = read_i64_le_from(&bytes[pos + i * 8]);
-        }
-        return GbfValue::make_datetime(a);
+GbfValue decode_datetime(const FieldMeta& meta, std::vector<std::size_t>&& shape, ByteBuffer&& bytes) {
+    if (bytes.empty()) return decode_opaque(meta, std::move(shape), std::move(bytes));
+    DateTimeArray a;
+    const std::size_t n = numel(shape);
+    a.shape = std::move(shape);
+    std::size_t pos = 0;
+    std::uint8_t nstr = bytes[pos++];
+    // Expect 3 strings, but be tolerant.
+    std::vector<std::string> strs;
+    for (std::size_t si = 0; si < nstr; ++si) {
+        if (pos + 4 > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated datetime payload");
+        std::uint32_t len = read_u32_le_from(&bytes[pos]);
+        pos += 4;
+        if (pos + len > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated datetime payload");
+        strs.emplace_back(reinterpret_cast<const char*>(&bytes[pos]), reinterpret_cast<const char*>(&bytes[pos + len]));
+        pos += len;
     }
+    // Map: [tz, locale, format] when available.
+    if (strs.size() > 0) a.timezone = strs[0];
+    if (strs.size() > 1) a.locale = strs[1];
+    if (strs.size() > 2) a.format = strs[2];
+
+    if (pos + n > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated datetime payload");
+    read_le_array(bytes.data() + pos, n, a.nat_mask);
+    pos += n;
+
+    if (pos + 8 * n > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated datetime payload");
+    read_le_array(bytes.data() + pos, n, a.unix_ms);
+    return GbfValue::make_datetime(std::move(a));
+}
 
-    if (kind == "duration") {
-        DurationArray a;
-        a.shape = shape;
-        std::size_t expected = n + 8 * n;
-        if (bytes.size() < expected) throw GbfError(ErrorKind::Truncated, "truncated duration payload");
-        a.nan_mask.assign(bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(n));
-        a.ms.resize(n);
-        std::size_t pos = n;
-        for (std::size_t i = 0; i < n; ++i) {
-            a.ms[i] = read_i64_le_from(&bytes[pos + i * 8]);
-        }
-        return GbfValue::make_duration(a);
-    }
-
-    if (kind == "calendarduration") {
-        CalendarDurationArray a;
-        a.shape = shape;
-        std::size_t expected = n + 4 * n + 4 * n + 8 * n;
-        if (bytes.size() < expected) throw GbfError(ErrorKind::Truncated, "truncated calendarduration payload");
-        std::size_t pos = 0;
-        a.mask.assign(bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(n));
-        pos += n;
-        a.months.resize(n);
-        for (std::size_t i = 0; i < n; ++i) a.months[i] = read_i32_le_from(&bytes[pos + i * 4]);
-        pos += 4 * n;
-        a.days.resize(n);
-        for (std::size_t i = 0; i < n; ++i) a.days[i] = read_i32_le_from(&bytes[pos + i * 4]);
-        pos += 4 * n;
-        a.time_ms.resize(n);
-        for (std::size_t i = 0; i < n; ++i) a.time_ms[i] = read_i64_le_from(&bytes[pos + i * 8]);
-        return GbfValue::make_calendarduration(a);
-    }
-
-    if (kind == "categorical") {
-        CategoricalArray a;
-        a.shape = shape;
-        std::size_t pos = 0;
+GbfValue decode_duration(const FieldMeta& meta, std::vector<std::size_t>&& shape, ByteBuffer&& bytes) {
+    if (bytes.empty()) return decode_opaque(meta, std::move(shape), std::move(bytes));
+    DurationArray a;
+    const std::size_t n = numel(shape);
+    a.shape = std::move(shape);
+    std::size_t expected = n + 8 * n;
+    if (bytes.size() < expected) throw GbfError(ErrorKind::Truncated, "truncated duration payload");
+    read_le_array(bytes.data(), n, a.nan_mask);
+    read_le_array(bytes.data() + n, n, a.ms);
+    return GbfValue::make_duration(std::move(a));
+}
+
+GbfValue decode_calendarduration(const FieldMeta& meta, std::vector<std::size_t>&& shape, ByteBuffer&& bytes) {
+    if (bytes.empty()) return decode_opaque(meta, std::move(shape), std::move(bytes));
+    CalendarDurationArray a;
+    const std::size_t n = numel(shape);
+    a.shape = std::move(shape);
+    std::size_t expected = n + 4 * n + 4 * n + 8 * n;
+    if (bytes.size() < expected) throw GbfError(ErrorKind::Truncated, "truncated calendarduration payload");
+    const std::uint8_t* p = bytes.data();
+    read_le_array(p, n, a.mask);
+    read_le_array(p + n, n, a.months);
+    read_le_array(p + 5 * n, n, a.days);
+    read_le_array(p + 9 * n, n, a.time_ms);
+    return GbfValue::make_calendarduration(std::move(a));
+}
+
+GbfValue decode_categorical(const FieldMeta& meta, std::vector<std::size_t>&& shape, ByteBuffer&& bytes) {
+    if (bytes.empty()) return decode_opaque(meta, std::move(shape), std::move(bytes));
+    CategoricalArray a;
+    const std::size_t n = numel(shape);
+    a.shape = std::move(shape);
+    std::size_t pos = 0;
+    if (pos + 4 > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated categorical payload");
+    std::uint32_t ncat = read_u32_le_from(&bytes[pos]);
+    pos += 4;
+    a.categories.clear();
+    a.categories.reserve(ncat);
+    for (std::uint32_t i = 0; i < ncat; ++i) {
         if (pos + 4 > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated categorical payload");
-        std::uint32_t ncat = read_u32_le_from(&bytes[pos]);
+        std::uint32_t len = read_u32_le_from(&bytes[pos]);
         pos += 4;
-        a.categories.clear();
-        a.categories.reserve(ncat);
-        for (std::uint32_t i = 0; i < ncat; ++i) {
-            if (pos + 4 > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated categorical payload");
-            std::uint32_t len = read_u32_le_from(&bytes[pos]);
-            pos += 4;
-            if (pos + len > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated categorical payload");
-            a.categories.emplace_back(reinterpret_cast<const char*>(&bytes[pos]), reinterpret_cast<const char*>(&bytes[pos + len]));
-            pos += len;
-        }
-        if (pos + 4 * n > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated categorical payload");
-        a.codes.resize(n);
-        for (std::size_t i = 0; i < n; ++i) {
-            a.codes[i] = read_u32_le_from(&bytes[pos + i * 4]);
-        }
-        return GbfValue::make_categorical(a);
+        if (pos + len > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated categorical payload");
+        a.categories.emplace_back(reinterpret_cast<const char*>(&bytes[pos]), reinterpret_cast<const char*>(&bytes[pos + len]));
+        pos += len;
     }
+    if (pos + 4 * n > bytes.size()) throw GbfError(ErrorKind::Truncated, "truncated categorical payload");
+    read_le_array(bytes.data() + pos, n, a.codes);
+    return GbfValue::make_categorical(std::move(a));
+}
 
-    // Unknown kind => opaque
-    OpaqueValue o;
-    o.kind = kind;
-    o.class_name = cls;
-    o.shape = shape;
-    o.complex = meta.complex;
-    o.encoding = meta.encoding;
-    o.bytes = bytes;
-    return GbfValue::make_opaque(o);
+// Indexed by FieldKind; unknown kinds decode to OpaqueValue.
+const Decoder kDecoders[] = {
+    decode_opaque,
+    decode_struct,
+    decode_numeric,
+    decode_logical,
+    decode_string,
+    decode_char,
+    decode_datetime,
+    decode_duration,
+    decode_calendarduration,
+    decode_categorical,
+};
+static_assert(std::size(kDecoders) == static_cast<std::size_t>(FieldKind::Categorical) + 1, "one decoder per FieldKind");
+
+} // namespace
+
+static GbfValue decode_value_bytes(const FieldMeta& meta, ByteBuffer&& bytes, const ReadOptions& opts) {
+    const auto k = static_cast<std::size_t>(meta.kind);
+    Decoder decode = k < std::size(kDecoders) ? kDecoders[k] : decode_opaque;
+    if (opts.columnar_strings && meta.kind == FieldKind::String) decode = decode_string_column;
+    return decode(meta, shape_usize_from_u64(meta.shape), std::move(bytes));
 }
 
-static void insert_path(GbfValue& root, const std::string& path, const GbfValue& leaf) {
-    auto parts = split_path(path);
-    if (parts.empty()) return;
+// Walks `path` in place: only the map keys of newly created nodes are allocated.
+static void insert_path(GbfValue& root, std::string_view path, GbfValue&& leaf) {
+    if (path.empty()) throw GbfError(ErrorKind::InvalidData, "invalid path: empty segment");
 
     GbfValue* cur = &root;
     if (!cur->is_struct()) {
         *cur = GbfValue::make_struct();
     }
 
-    for (std::size_t i = 0; i + 1 < parts.size(); ++i) {
+    std::size_t start = 0;
+    for (std::size_t dot = path.find('.'); dot != std::string_view::npos; dot = path.find('.', start)) {
+        const std::string_view part = path.substr(start, dot - start);
+        if (part.empty()) throw GbfError(ErrorKind::InvalidData, "invalid path: empty segment");
         auto& m = cur->as_struct();
-        auto it = m.find(parts[i]);
-        if (it == m.end()) {
-            it = m.emplace(parts[i], GbfValue::make_struct()).first;
-            } else if (!it->second.is_struct()) {
-                throw GbfError(ErrorKind::InvalidData, "path hits non-struct at '" + join_path(parts, i + 1) + "'");
-            }
+        auto it = m.lower_bound(part);
+        if (it == m.end() || it->first != part) {
+            it = m.emplace_hint(it, std::string(part), GbfValue::make_struct());
+        } else if (!it->second.is_struct()) {
+            throw GbfError(ErrorKind::InvalidData, "path hits non-struct at '" + std::string(path.substr(0, dot)) + "'");
+        }
         cur = &it->second;
+        start = dot + 1;
     }
 
-    cur->as_struct()[parts.back()] = leaf;
+    const std::string_view last = path.substr(start);
+    if (last.empty()) throw GbfError(ErrorKind::InvalidData, "invalid path: empty segment");
+    auto& m = cur->as_struct();
+    auto it = m.lower_bound(last);
+    if (it == m.end() || it->first != last) m.emplace_hint(it, std::string(last), std::move(leaf));
+    else it->second = std::move(leaf);
 }
 
 static std::vector<const FieldMeta*> fields_with_prefix(const std::vector<FieldMeta>& fields, const std::string& prefix) {
@@ -1400,39 +2435,455 @@ static std::vector<const FieldMeta*> fields_with_prefix(const std::vector<FieldM
 }
 
 // ------------------------------
-// API implementations
+// Binary field index
 // ------------------------------
+//
+// Written after the last payload when WriteOptions::field_index is set and referenced from the
+// header JSON as "index": {offset (from payload_start), size, crc32}. Little-endian,
+// position-independent (usable from an mmap), with the tables in this order:
+//
+//   [8B "GBFINDX\0"][u32 version = 1][u32 record size = 88]
+//   [u64 records][u64 dims][u64 extents][u64 string table bytes][u64 name bytes]
+//   records  sorted by name (bytewise), 88 bytes each:
+//            u64 name_off, u32 name_len, u32 order (position in the JSON field list),
+//            u32 kind, class, encoding, compression (string table ids), u32 flags (1 = complex),
+//            i32 level, u32 dims_off, u32 ndims, u64 offset, csize, usize, u32 crc32,
+//            u32 extents_off, u32 extents_count, u32 reserved
+//   dims     u64 each
+//   extents  40 bytes each: u64 offset, csize, usize, n; u32 crc32; u32 compression id
+//   strings  [u32 count] then count x [u32 len][bytes]
+//   names    the names, concatenated in record order
+
+static const char kIndexMagic[8] = {'G', 'B', 'F', 'I', 'N', 'D', 'X', '\0'};
+constexpr std::size_t kIndexPreamble = 56;
+constexpr std::size_t kIndexRecord = 88;
+constexpr std::size_t kIndexExtent = 40;
+
+static std::uint64_t read_u64_le_from(const std::uint8_t* p) {
+    return static_cast<std::uint64_t>(read_i64_le_from(p));
+}
 
-std::tuple<Header, std::uint32_t, std::string> read_header_only(
-    const std::filesystem::path& file,
-    const ReadOptions& opts
-) {
-    std::ifstream is(file, std::ios::binary);
-    if (!is) {
-        throw GbfError(ErrorKind::Io, "failed to open file: " + file.string());
-    }
-
-    std::array<char, 8> magic{};
-    is.read(magic.data(), magic.size());
-    if (!is) throw GbfError(ErrorKind::Truncated, "unexpected EOF reading magic");
-    std::string magic_s(magic.data(), magic.size());
-    // trim trailing NULs
-    while (!magic_s.empty() && magic_s.back() == '\0') magic_s.pop_back();
+static std::vector<std::uint8_t> build_field_index(const std::vector<FieldMeta>& fields) {
+    std::vector<std::uint32_t> order(fields.size());
+    for (std::size_t i = 0; i < order.size(); ++i) order[i] = static_cast<std::uint32_t>(i);
+    std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return fields[a].name < fields[b].name;
+    });
+
+    std::map<std::string, std::uint32_t> ids;
+    std::vector<const std::string*> strings;
+    auto intern = [&](const std::string& v) {
+        auto it = ids.find(v);
+        if (it == ids.end()) {
+            it = ids.emplace(v, static_cast<std::uint32_t>(strings.size())).first;
+            strings.push_back(&it->first);
+        }
+        return it->second;
+    };
 
-    if (magic_s != "GREDBIN") {
-        throw GbfError(ErrorKind::BadMagic, "bad magic: '" + magic_s + "'");
+    std::vector<std::uint8_t> records;
+    std::vector<std::uint8_t> dims;
+    std::vector<std::uint8_t> extents;
+    std::vector<std::uint8_t> names;
+    records.reserve(fields.size() * kIndexRecord);
+    std::uint64_t ndims_total = 0;
+    std::uint64_t nextents_total = 0;
+    for (std::uint32_t i : order) {
+        const FieldMeta& f = fields[i];
+        append_u64_le(records, names.size());
+        append_u32_le(records, static_cast<std::uint32_t>(f.name.size()));
+        append_u32_le(records, i);
+        append_u32_le(records, intern(f.kind_str()));
+        append_u32_le(records, intern(f.class_name));
+        append_u32_le(records, intern(f.encoding));
+        append_u32_le(records, intern(f.compression));
+        append_u32_le(records, f.complex ? 1u : 0u);
+        append_i32_le(records, f.level);
+        append_u32_le(records, static_cast<std::uint32_t>(ndims_total));
+        append_u32_le(records, static_cast<std::uint32_t>(f.shape.size()));
+        append_u64_le(records, f.offset);
+        append_u64_le(records, f.csize);
+        append_u64_le(records, f.usize);
+        append_u32_le(records, f.crc32);
+        append_u32_le(records, static_cast<std::uint32_t>(nextents_total));
+        append_u32_le(records, static_cast<std::uint32_t>(f.extents.size()));
+        append_u32_le(records, 0);
+
+        names.insert(names.end(), f.name.begin(), f.name.end());
+        for (auto d : f.shape) append_u64_le(dims, d);
+        ndims_total += f.shape.size();
+        for (const auto& e : f.extents) {
+            append_u64_le(extents, e.offset);
+            append_u64_le(extents, e.csize);
+            append_u64_le(extents, e.usize);
+            append_u64_le(extents, e.count);
+            append_u32_le(extents, e.crc32);
+            append_u32_le(extents, intern(e.compression));
+        }
+        nextents_total += f.extents.size();
+    }
+    if (ndims_total > UINT32_MAX || nextents_total > UINT32_MAX) {
+        throw GbfError(ErrorKind::InvalidData, "too many dimensions/extents for the field index");
     }
 
-    std::uint32_t header_len = read_u32_le(is);
-    if (header_len == 0 || header_len > kMaxHeaderLen) {
-        throw GbfError(ErrorKind::InvalidData, "unreasonable header length");
+    std::vector<std::uint8_t> table;
+    append_u32_le(table, static_cast<std::uint32_t>(strings.size()));
+    for (const std::string* str : strings) {
+        append_u32_le(table, static_cast<std::uint32_t>(str->size()));
+        table.insert(table.end(), str->begin(), str->end());
     }
-    std::string raw_json;
-    raw_json.resize(header_len);
-    is.read(&raw_json[0], header_len);
-    if (!is) throw GbfError(ErrorKind::Truncated, "unexpected EOF reading header JSON");
 
-    Header hdr = parse_header(raw_json);
+    std::vector<std::uint8_t> out(kIndexMagic, kIndexMagic + 8);
+    append_u32_le(out, 1);
+    append_u32_le(out, static_cast<std::uint32_t>(kIndexRecord));
+    append_u64_le(out, fields.size());
+    append_u64_le(out, ndims_total);
+    append_u64_le(out, nextents_total);
+    append_u64_le(out, table.size());
+    append_u64_le(out, names.size());
+    out.reserve(out.size() + records.size() + dims.size() + extents.size() + table.size() + names.size());
+    out.insert(out.end(), records.begin(), records.end());
+    out.insert(out.end(), dims.begin(), dims.end());
+    out.insert(out.end(), extents.begin(), extents.end());
+    out.insert(out.end(), table.begin(), table.end());
+    out.insert(out.end(), names.begin(), names.end());
+    return out;
+}
+
+namespace {
+
+// Read-only view over a loaded field index. The constructor checks every table bound, so
+// accessors do not.
+class FieldIndex {
+public:
+    explicit FieldIndex(std::vector<std::uint8_t> bytes) : bytes_(std::move(bytes)) {
+        const std::uint8_t* p = bytes_.data();
+        if (bytes_.size() < kIndexPreamble || std::memcmp(p, kIndexMagic, 8) != 0 ||
+            read_u32_le_from(p + 8) != 1 || read_u32_le_from(p + 12) != kIndexRecord) {
+            bad();
+        }
+        count_ = read_u64_le_from(p + 16);
+        const std::uint64_t ndims = read_u64_le_from(p + 24);
+        const std::uint64_t nextents = read_u64_le_from(p + 32);
+        const std::uint64_t table = read_u64_le_from(p + 40);
+        const std::uint64_t names = read_u64_le_from(p + 48);
+        const std::uint64_t n = bytes_.size();
+        if (count_ > n / kIndexRecord || ndims > n / 8 || nextents > n / kIndexExtent || table > n || names > n) bad();
+
+        records_ = kIndexPreamble;
+        dims_ = records_ + count_ * kIndexRecord;
+        extents_ = dims_ + ndims * 8;
+        const std::uint64_t table_at = extents_ + nextents * kIndexExtent;
+        names_ = table_at + table;
+        if (names_ + names != n) bad();
+
+        std::uint64_t pos = table_at;
+        if (table < 4) bad();
+        const std::uint32_t nstrings = read_u32_le_from(p + pos);
+        pos += 4;
+        strings_.reserve(std::min<std::uint64_t>(nstrings, table / 4));
+        kinds_.reserve(strings_.capacity());
+        for (std::uint32_t i = 0; i < nstrings; ++i) {
+            if (pos + 4 > names_) bad();
+            const std::uint32_t len = read_u32_le_from(p + pos);
+            pos += 4;
+            if (pos + len > names_) bad();
+            strings_.emplace_back(std::string_view(reinterpret_cast<const char*>(p + pos), len));
+            kinds_.push_back(field_kind_from_string(strings_.back().str()));
+            pos += len;
+        }
+
+        for (std::size_t i = 0; i < count_; ++i) {
+            const std::uint8_t* r = record(i);
+            const std::uint64_t name_off = read_u64_le_from(r);
+            if (name_off > names || read_u32_le_from(r + 8) > names - name_off) bad();
+            if (read_u32_le_from(r + 12) >= count_) bad();
+            for (int k = 0; k < 4; ++k) {
+                if (read_u32_le_from(r + 16 + 4 * k) >= strings_.size()) bad();
+            }
+            if (std::uint64_t{read_u32_le_from(r + 40)} + read_u32_le_from(r + 44) > ndims) bad();
+            if (std::uint64_t{read_u32_le_from(r + 76)} + read_u32_le_from(r + 80) > nextents) bad();
+            if (i > 0 && !(name(i - 1) < name(i))) bad();
+        }
+        for (std::uint64_t e = 0; e < nextents; ++e) {
+            if (read_u32_le_from(p + extents_ + e * kIndexExtent + 36) >= strings_.size()) bad();
+        }
+    }
+
+    std::size_t size() const { return static_cast<std::size_t>(count_); }
+
+    std::string_view name(std::size_t i) const {
+        const std::uint8_t* r = record(i);
+        return std::string_view(reinterpret_cast<const char*>(bytes_.data() + names_ + read_u64_le_from(r)),
+                                read_u32_le_from(r + 8));
+    }
+
+    std::uint32_t order(std::size_t i) const { return read_u32_le_from(record(i) + 12); }
+
+    // First record whose name is not less than `key`.
+    std::size_t lower_bound(std::string_view key) const {
+        std::size_t lo = 0;
+        std::size_t hi = size();
+        while (lo < hi) {
+            const std::size_t mid = lo + (hi - lo) / 2;
+            if (name(mid) < key) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    FieldMeta meta(std::size_t i) const {
+        const std::uint8_t* r = record(i);
+        FieldMeta f;
+        f.name = std::string(name(i));
+        const std::uint32_t kind = read_u32_le_from(r + 16);
+        f.kind = kinds_[kind];
+        if (f.kind == FieldKind::Unknown) f.kind_name = strings_[kind];
+        set_meta_class(f, strings_[read_u32_le_from(r + 20)]);
+        f.encoding = strings_[read_u32_le_from(r + 24)];
+        f.compression = strings_[read_u32_le_from(r + 28)];
+        f.complex = (read_u32_le_from(r + 32) & 1u) != 0;
+        f.level = static_cast<std::int32_t>(read_u32_le_from(r + 36));
+        const std::uint32_t dims_off = read_u32_le_from(r + 40);
+        f.shape.resize(read_u32_le_from(r + 44));
+        for (std::size_t k = 0; k < f.shape.size(); ++k) {
+            f.shape[k] = read_u64_le_from(bytes_.data() + dims_ + (dims_off + k) * 8);
+        }
+        f.offset = read_u64_le_from(r + 48);
+        f.csize = read_u64_le_from(r + 56);
+        f.usize = read_u64_le_from(r + 64);
+        f.crc32 = read_u32_le_from(r + 72);
+        const std::uint32_t ext_off = read_u32_le_from(r + 76);
+        f.extents.resize(read_u32_le_from(r + 80));
+        for (std::size_t k = 0; k < f.extents.size(); ++k) {
+            const std::uint8_t* e = bytes_.data() + extents_ + (ext_off + k) * kIndexExtent;
+            f.extents[k].offset = read_u64_le_from(e);
+            f.extents[k].csize = read_u64_le_from(e + 8);
+            f.extents[k].usize = read_u64_le_from(e + 16);
+            f.extents[k].count = read_u64_le_from(e + 24);
+            f.extents[k].crc32 = read_u32_le_from(e + 32);
+            f.extents[k].compression = strings_[read_u32_le_from(e + 36)];
+        }
+        return f;
+    }
+
+    std::vector<FieldMeta> fields_in_header_order() const {
+        std::vector<FieldMeta> out(size());
+        for (std::size_t i = 0; i < size(); ++i) out[order(i)] = meta(i);
+        return out;
+    }
+
+private:
+    const std::uint8_t* record(std::size_t i) const { return bytes_.data() + records_ + i * kIndexRecord; }
+
+    [[noreturn]] static void bad() { throw GbfError(ErrorKind::InvalidData, "malformed field index"); }
+
+    std::vector<std::uint8_t> bytes_;
+    std::vector<InternedString> strings_;
+    std::vector<FieldKind> kinds_; // field_kind_from_string of each entry of strings_
+    std::uint64_t count_{0};
+    std::uint64_t records_{0};
+    std::uint64_t dims_{0};
+    std::uint64_t extents_{0};
+    std::uint64_t names_{0};
+};
+
+} // namespace
+
+// nullopt when the header has no usable index (absent, out of bounds, CRC mismatch or
+// malformed); the caller then falls back to the JSON field list.
+static std::optional<FieldIndex> load_field_index(std::istream& is, const Header& hdr) {
+    if (!hdr.field_index) return std::nullopt;
+    const FieldIndexRef& ref = *hdr.field_index;
+    std::uint64_t pos = 0;
+    std::uint64_t end = 0;
+    if (ref.size < kIndexPreamble || ref.size > kMaxFieldCsize || !checked_add_u64(hdr.payload_start, ref.offset, pos) ||
+        !checked_add_u64(pos, ref.size, end) || (hdr.file_size != 0 && end > hdr.file_size)) {
+        return std::nullopt;
+    }
+    std::vector<std::uint8_t> bytes(static_cast<std::size_t>(ref.size));
+    is.clear();
+    is.seekg(static_cast<std::streamoff>(pos), std::ios::beg);
+    is.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!is || crc32_bytes(bytes.data(), bytes.size()) != ref.crc32) return std::nullopt;
+    try {
+        return FieldIndex(std::move(bytes));
+    } catch (const GbfError&) {
+        return std::nullopt;
+    }
+}
+
+// ------------------------------
+// Compressed header framing
+// ------------------------------
+//
+//   [8B "GREDBIZ\0"][u32 header_len][frame, header_len bytes][payload]
+//   frame: [u32 json_len][u32 stored_len][u8 name_len][codec name][stored bytes][zero padding]
+//
+// The magic differs from "GREDBIN\0" within its first 7 bytes, as some readers compare only
+// those, so readers without support stop at the magic instead of parsing compressed bytes.
+// header_len, payload_start and the header CRC keep their meaning: payload_start is
+// 12 + header_len and the CRC covers the decompressed JSON.
+
+static const char kPlainMagic[8] = {'G', 'R', 'E', 'D', 'B', 'I', 'N', '\0'};
+static const char kCompressedHeaderMagic[8] = {'G', 'R', 'E', 'D', 'B', 'I', 'Z', '\0'};
+static constexpr std::size_t kHeaderFramePreamble = 9; // json_len + stored_len + name_len
+
+static int header_codec_level(const Codec& codec, const WriteOptions& opts) {
+    return codec.name == "zlib" ? opts.zlib_level : opts.codec_level;
+}
+
+static std::string encode_header_frame(const std::string& json, const std::string& codec_name, const WriteOptions& opts) {
+    const Codec& codec = require_codec(codec_name);
+    if (codec.name.size() > 255) throw GbfError(ErrorKind::Unsupported, "header codec name too long");
+    if (json.size() > kMaxHeaderJsonLen) throw GbfError(ErrorKind::InvalidData, "header too large");
+    const std::size_t head = kHeaderFramePreamble + codec.name.size();
+    std::string frame(head + codec.bound(json.size()), '\0');
+    std::uint8_t* out = reinterpret_cast<std::uint8_t*>(&frame[0]);
+    const std::size_t n = codec.compress(reinterpret_cast<const std::uint8_t*>(json.data()), json.size(),
+                                         out + head, frame.size() - head, header_codec_level(codec, opts));
+    if (n > std::numeric_limits<std::uint32_t>::max()) throw GbfError(ErrorKind::InvalidData, "header too large");
+    frame.resize(head + n);
+
+    const std::vector<std::uint8_t> json_len = encode_u32_le(static_cast<std::uint32_t>(json.size()));
+    const std::vector<std::uint8_t> stored_len = encode_u32_le(static_cast<std::uint32_t>(n));
+    std::memcpy(out, json_len.data(), 4);
+    std::memcpy(out + 4, stored_len.data(), 4);
+    out[8] = static_cast<std::uint8_t>(codec.name.size());
+    std::memcpy(out + kHeaderFramePreamble, codec.name.data(), codec.name.size());
+    return frame;
+}
+
+// Stream-inflate `stored_len` bytes of zlib data from `is` into `json`, reading in chunks so
+// no copy of the compressed header is held and decompression overlaps the reads.
+static void inflate_header_stream(std::istream& is, std::uint64_t stored_len, std::string& json) {
+    z_stream zs{};
+    if (::inflateInit(&zs) != Z_OK) throw GbfError(ErrorKind::ZlibError, "zlib inflateInit failed");
+    std::vector<char> chunk(std::size_t{1} << 20);
+    std::size_t produced = 0;
+    int rc = Z_OK;
+    while (rc != Z_STREAM_END && stored_len > 0) {
+        const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(chunk.size(), stored_len));
+        is.read(chunk.data(), static_cast<std::streamsize>(n));
+        if (!is) {
+            ::inflateEnd(&zs);
+            throw GbfError(ErrorKind::Truncated, "unexpected EOF reading compressed header");
+        }
+        stored_len -= n;
+        zs.next_in = reinterpret_cast<Bytef*>(chunk.data());
+        zs.avail_in = static_cast<uInt>(n);
+        while (zs.avail_in > 0 && rc != Z_STREAM_END) {
+            const std::size_t room = std::min<std::size_t>(json.size() - produced, std::numeric_limits<uInt>::max());
+            zs.next_out = reinterpret_cast<Bytef*>(&json[0]) + produced;
+            zs.avail_out = static_cast<uInt>(room);
+            rc = ::inflate(&zs, Z_NO_FLUSH);
+            produced += room - zs.avail_out;
+            if (rc != Z_OK && rc != Z_STREAM_END) {
+                ::inflateEnd(&zs);
+                throw GbfError(ErrorKind::ZlibError, "corrupt compressed header");
+            }
+        }
+    }
+    ::inflateEnd(&zs);
+    if (rc != Z_STREAM_END || produced != json.size()) {
+        throw GbfError(ErrorKind::ZlibError, "compressed header length mismatch");
+    }
+}
+
+// Read a header frame of `header_len` bytes from `is` (positioned after the length) and
+// return the JSON; `codec_name` receives the codec it was stored with.
+static std::string read_header_frame(std::istream& is, std::uint32_t header_len, std::string& codec_name) {
+    std::array<std::uint8_t, kHeaderFramePreamble> pre{};
+    if (header_len < kHeaderFramePreamble) throw GbfError(ErrorKind::InvalidData, "compressed header frame too short");
+    is.read(reinterpret_cast<char*>(pre.data()), static_cast<std::streamsize>(pre.size()));
+    if (!is) throw GbfError(ErrorKind::Truncated, "unexpected EOF reading header frame");
+    const std::uint32_t json_len = read_u32_le_from(pre.data());
+    const std::uint32_t stored_len = read_u32_le_from(pre.data() + 4);
+    const std::size_t name_len = pre[8];
+    if (json_len == 0 || json_len > kMaxHeaderJsonLen ||
+        static_cast<std::uint64_t>(kHeaderFramePreamble) + name_len + stored_len > header_len) {
+        throw GbfError(ErrorKind::InvalidData, "invalid compressed header frame");
+    }
+    codec_name.assign(name_len, '\0');
+    if (name_len > 0) is.read(&codec_name[0], static_cast<std::streamsize>(name_len));
+    if (!is) throw GbfError(ErrorKind::Truncated, "unexpected EOF reading header frame");
+    const Codec& codec = require_codec(codec_name);
+
+    std::string json(json_len, '\0');
+    if (codec.name == "zlib") {
+        inflate_header_stream(is, stored_len, json);
+    } else {
+        ByteBuffer stored = ByteBuffer::uninitialized(stored_len);
+        is.read(reinterpret_cast<char*>(stored.data()), static_cast<std::streamsize>(stored.size()));
+        if (!is) throw GbfError(ErrorKind::Truncated, "unexpected EOF reading compressed header");
+        codec.decompress(stored.data(), stored.size(), reinterpret_cast<std::uint8_t*>(&json[0]), json.size());
+    }
+    return json;
+}
+
+// [magic][u32 header_len][header region]; the magic says whether the region is plain JSON or
+// a compressed frame.
+static std::vector<std::uint8_t> header_block(const Header& hdr, const std::string& region) {
+    std::vector<std::uint8_t> head(12 + region.size());
+    std::memcpy(head.data(), hdr.header_codec.empty() ? kPlainMagic : kCompressedHeaderMagic, 8);
+    const std::vector<std::uint8_t> len_le = encode_u32_le(static_cast<std::uint32_t>(region.size()));
+    std::memcpy(head.data() + 8, len_le.data(), 4);
+    std::memcpy(head.data() + 12, region.data(), region.size());
+    return head;
+}
+
+// ------------------------------
+// API implementations
+// ------------------------------
+
+namespace {
+
+struct HeaderRead {
+    Header hdr;
+    std::uint32_t header_len{0};
+    std::string raw_json;
+    // Set when the field list came from the binary index; hdr.fields is then left empty.
+    std::optional<FieldIndex> index;
+};
+
+} // namespace
+
+static HeaderRead read_header_parts(const std::filesystem::path& file, const ReadOptions& opts) {
+    std::ifstream is(file, std::ios::binary);
+    if (!is) {
+        throw GbfError(ErrorKind::Io, "failed to open file: " + file.string());
+    }
+
+    std::array<char, 8> magic{};
+    is.read(magic.data(), magic.size());
+    if (!is) throw GbfError(ErrorKind::Truncated, "unexpected EOF reading magic");
+    std::string magic_s(magic.data(), magic.size());
+    // trim trailing NULs
+    while (!magic_s.empty() && magic_s.back() == '\0') magic_s.pop_back();
+
+    const bool compressed = std::memcmp(magic.data(), kCompressedHeaderMagic, magic.size()) == 0;
+    if (magic_s != "GREDBIN" && !compressed) {
+        throw GbfError(ErrorKind::BadMagic, "bad magic: '" + magic_s + "'");
+    }
+
+    std::uint32_t header_len = read_u32_le(is);
+    if (header_len == 0 || header_len > kMaxHeaderLen) {
+        throw GbfError(ErrorKind::InvalidData, "unreasonable header length");
+    }
+    std::string raw_json;
+    std::string header_codec;
+    if (compressed) {
+        raw_json = read_header_frame(is, header_len, header_codec);
+    } else {
+        raw_json.resize(header_len);
+        is.read(&raw_json[0], header_len);
+        if (!is) throw GbfError(ErrorKind::Truncated, "unexpected EOF reading header JSON");
+    }
+
+    // "index" sorts after "fields", so it is found quickly from the end.
+    const bool try_index = opts.use_field_index && raw_json.rfind("\"index\":{") != std::string::npos;
+    Header hdr = parse_header(raw_json, /*skip_fields=*/try_index);
+    hdr.header_codec = std::move(header_codec);
 
     // Compute payload_start from framing if missing.
     std::uint64_t computed_payload_start = 8ull + 4ull + static_cast<std::uint64_t>(header_len);
@@ -1467,10 +2918,41 @@ std::tuple<Header, std::uint32_t, std::string> read_header_only(
         }
     }
 
-    return {hdr, header_len, raw_json};
+    std::optional<FieldIndex> index;
+    if (try_index) {
+        index = load_field_index(is, hdr);
+        if (!index) hdr.fields = parse_header(raw_json).fields;
+    }
+    return {std::move(hdr), header_len, std::move(raw_json), std::move(index)};
+}
+
+std::tuple<Header, std::uint32_t, std::string> read_header_only(
+    const std::filesystem::path& file,
+    const ReadOptions& opts
+) {
+    HeaderRead r = read_header_parts(file, opts);
+    if (r.index) r.hdr.fields = r.index->fields_in_header_order();
+    return {std::move(r.hdr), r.header_len, std::move(r.raw_json)};
+}
+
+std::pair<Header, FieldTable> read_header_table(const std::filesystem::path& file, const ReadOptions& opts) {
+    HeaderRead r = read_header_parts(file, opts);
+    FieldTable table;
+    if (r.index) {
+        const FieldIndex& index = *r.index;
+        std::vector<std::size_t> sorted_at(index.size());
+        for (std::size_t i = 0; i < index.size(); ++i) sorted_at[index.order(i)] = i;
+        table.reserve(index.size());
+        for (std::size_t i : sorted_at) table.push_back(index.meta(i));
+    } else {
+        table = FieldTable(r.hdr.fields);
+        r.hdr.fields = std::vector<FieldMeta>();
+    }
+    return {std::move(r.hdr), std::move(table)};
 }
 
-static std::vector<std::uint8_t> read_field_payload(
+static ByteBuffer read_field_payload(
+    const std::filesystem::path& file,
     std::ifstream& is,
     const Header& hdr,
     const FieldMeta& f,
@@ -1493,16 +2975,19 @@ static std::vector<std::uint8_t> read_field_payload(
             throw GbfError(ErrorKind::Truncated, "field payload exceeds file bounds");
         }
     }
-    is.seekg(static_cast<std::streamoff>(pos), std::ios::beg);
-    if (!is) throw GbfError(ErrorKind::Io, "seek failed while reading payload");
-
-    std::vector<std::uint8_t> chunk(static_cast<std::size_t>(f.csize));
-    is.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
-    if (!is) throw GbfError(ErrorKind::Truncated, "unexpected EOF reading field payload");
+    ByteBuffer chunk = ByteBuffer::uninitialized(static_cast<std::size_t>(f.csize));
+    const bool direct = opts.direct_io.enabled && f.csize >= opts.direct_io.min_bytes &&
+        detail::direct_read(file, pos, chunk.data(), chunk.size(), opts.direct_io);
+    if (!direct) {
+        is.seekg(static_cast<std::streamoff>(pos), std::ios::beg);
+        if (!is) throw GbfError(ErrorKind::Io, "seek failed while reading payload");
+        is.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+        if (!is) throw GbfError(ErrorKind::Truncated, "unexpected EOF reading field payload");
+    }
 
-    std::vector<std::uint8_t> raw;
-    if (f.compression == "zlib") {
-        raw = zlib_decompress(chunk, static_cast<std::size_t>(f.usize));
+    ByteBuffer raw;
+    if (!is_uncompressed(f.compression)) {
+        raw = codec_decompress(require_codec(f.compression), chunk, static_cast<std::size_t>(f.usize));
     } else {
         raw = std::move(chunk);
         if (raw.size() != static_cast<std::size_t>(f.usize)) {
@@ -1525,6 +3010,97 @@ static std::vector<std::uint8_t> read_field_payload(
     return raw;
 }
 
+// Field-level `compression` of extended fields. Not a registered codec, so readers that do not
+// know about extents fail on such a field with "unsupported codec" instead of misreading it.
+static const char* const kExtentsCompression = "extents";
+
+static bool is_extendable_kind(FieldKind kind) {
+    return kind == FieldKind::Numeric || kind == FieldKind::Logical || kind == FieldKind::DateTime ||
+           kind == FieldKind::Duration;
+}
+
+// Column-major: concatenating along the last dimension appends each component's elements.
+template <class C>
+static void append_all(C& dst, const C& src) {
+    dst.insert(dst.end(), src.begin(), src.end());
+}
+
+static void append_last_dim(GbfValue& dst, const GbfValue& src) {
+    std::visit([&](auto& d) {
+        using T = std::decay_t<decltype(d)>;
+        const T* s = std::get_if<T>(&src.v);
+        if (!s) throw GbfError(ErrorKind::InvalidData, "extent kind mismatch");
+        if constexpr (std::is_same_v<T, NumericArray>) {
+            append_all(d.real_le, s->real_le);
+            if (d.imag_le && s->imag_le) append_all(*d.imag_le, *s->imag_le);
+            d.shape.back() += s->shape.back();
+        } else if constexpr (std::is_same_v<T, LogicalArray>) {
+            append_all(d.data, s->data);
+            d.shape.back() += s->shape.back();
+        } else if constexpr (std::is_same_v<T, DateTimeArray>) {
+            append_all(d.nat_mask, s->nat_mask);
+            append_all(d.unix_ms, s->unix_ms);
+            d.shape.back() += s->shape.back();
+        } else if constexpr (std::is_same_v<T, DurationArray>) {
+            append_all(d.nan_mask, s->nan_mask);
+            append_all(d.ms, s->ms);
+            d.shape.back() += s->shape.back();
+        } else {
+            throw GbfError(ErrorKind::Unsupported, "extents are not supported for this kind");
+        }
+    }, dst.v);
+}
+
+// The field as it would read if it held only extent `e`.
+static FieldMeta extent_meta(const FieldMeta& f, const FieldExtent& e) {
+    FieldMeta m = f;
+    m.extents.clear();
+    m.compression = e.compression;
+    m.offset = e.offset;
+    m.csize = e.csize;
+    m.usize = e.usize;
+    m.crc32 = e.crc32;
+    m.shape.back() = e.count;
+    return m;
+}
+
+// Read and decode one field, concatenating the extents of extended fields.
+static GbfValue read_field_value(
+    const std::filesystem::path& file,
+    std::ifstream& is,
+    const Header& hdr,
+    const FieldMeta& f,
+    const ReadOptions& opts
+) {
+    if (f.extents.empty()) {
+        return decode_value_bytes(f, read_field_payload(file, is, hdr, f, opts), opts);
+    }
+    if (!is_extendable_kind(f.kind) || f.shape.empty()) {
+        throw GbfError(ErrorKind::InvalidData, "extents on a non-extendable field: " + f.name);
+    }
+
+    // Real numeric and logical payloads are bare elements: splice the raw bytes and decode once.
+    if ((f.kind == FieldKind::Numeric && !f.complex) || f.kind == FieldKind::Logical) {
+        ByteBuffer raw;
+        raw.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(f.usize, kMaxFieldUsize)));
+        for (const auto& e : f.extents) {
+            // Appending (rather than adopting the first extent) keeps the single up-front allocation.
+            ByteBuffer part = read_field_payload(file, is, hdr, extent_meta(f, e), opts);
+            raw.insert(raw.end(), part.begin(), part.end());
+        }
+        return decode_value_bytes(f, std::move(raw), opts);
+    }
+
+    GbfValue out;
+    for (std::size_t i = 0; i < f.extents.size(); ++i) {
+        const FieldMeta m = extent_meta(f, f.extents[i]);
+        GbfValue part = decode_value_bytes(m, read_field_payload(file, is, hdr, m, opts), opts);
+        if (i == 0) out = std::move(part);
+        else append_last_dim(out, part);
+    }
+    return out;
+}
+
 GbfValue read_file(const std::filesystem::path& file, const ReadOptions& opts) {
     auto [hdr, header_len, raw_json] = read_header_only(file, opts);
 
@@ -1534,22 +3110,52 @@ GbfValue read_file(const std::filesystem::path& file, const ReadOptions& opts) {
     GbfValue root = GbfValue::make_struct();
 
     for (const auto& f : hdr.fields) {
-        std::vector<std::uint8_t> payload = read_field_payload(is, hdr, f, opts);
-        GbfValue leaf = decode_value_bytes(f, payload);
-        insert_path(root, f.name, leaf);
+        insert_path(root, f.name, read_field_value(file, is, hdr, f, opts));
     }
 
     return root;
 }
 
-GbfValue read_var(const std::filesystem::path& file, const std::string& var, const ReadOptions& opts) {
+Dataset read_file_flat(const std::filesystem::path& file, const ReadOptions& opts) {
     auto [hdr, header_len, raw_json] = read_header_only(file, opts);
 
+    std::ifstream is(file, std::ios::binary);
+    if (!is) throw GbfError(ErrorKind::Io, "failed to open file: " + file.string());
+
+    Dataset out;
+    out.reserve(hdr.fields.size());
+    for (auto& f : hdr.fields) {
+        GbfValue leaf = read_field_value(file, is, hdr, f, opts);
+        out.add(std::move(f.name), std::move(leaf));
+    }
+    return out;
+}
+
+GbfValue read_var(const std::filesystem::path& file, const std::string& var, const ReadOptions& opts) {
     // Root special case
     if (var.empty() || var == "<root>") {
         return read_file(file, opts);
     }
 
+    HeaderRead parts = read_header_parts(file, opts);
+    Header& hdr = parts.hdr;
+    if (parts.index) {
+        // Binary search: materialize only `var` itself, or else the run of names under "var.".
+        const FieldIndex& idx = *parts.index;
+        std::size_t i = idx.lower_bound(var);
+        if (i < idx.size() && idx.name(i) == var) {
+            hdr.fields.push_back(idx.meta(i));
+        } else {
+            const std::string prefix = var + ".";
+            std::vector<std::size_t> hits;
+            for (i = idx.lower_bound(prefix); i < idx.size() && idx.name(i).compare(0, prefix.size(), prefix) == 0; ++i) {
+                hits.push_back(i);
+            }
+            std::sort(hits.begin(), hits.end(), [&](std::size_t a, std::size_t b) { return idx.order(a) < idx.order(b); });
+            for (std::size_t h : hits) hdr.fields.push_back(idx.meta(h));
+        }
+    }
+
     // Find exact leaf
     const FieldMeta* exact = nullptr;
     for (const auto& f : hdr.fields) {
@@ -1560,8 +3166,7 @@ GbfValue read_var(const std::filesystem::path& file, const std::string& var, con
     if (!is) throw GbfError(ErrorKind::Io, "failed to open file: " + file.string());
 
     if (exact) {
-        std::vector<std::uint8_t> payload = read_field_payload(is, hdr, *exact, opts);
-        return decode_value_bytes(*exact, payload);
+        return read_field_value(file, is, hdr, *exact, opts);
     }
 
     // Otherwise treat var as prefix and build struct
@@ -1572,179 +3177,1659 @@ GbfValue read_var(const std::filesystem::path& file, const std::string& var, con
 
     GbfValue out = GbfValue::make_struct();
     for (const auto* fp : selected) {
-        std::vector<std::uint8_t> payload = read_field_payload(is, hdr, *fp, opts);
-        GbfValue leaf = decode_value_bytes(*fp, payload);
+        GbfValue leaf = read_field_value(file, is, hdr, *fp, opts);
 
         // Trim prefix from name
         std::string rel = fp->name;
         if (rel == var) {
             // exact should have matched, but just in case
-            out = leaf;
+            out = std::move(leaf);
             continue;
         }
         if (!var.empty() && rel.size() > var.size() && rel.compare(0, var.size(), var) == 0 && rel[var.size()] == '.') {
             rel = rel.substr(var.size() + 1);
         }
-        insert_path(out, rel, leaf);
+        insert_path(out, rel, std::move(leaf));
     }
     return out;
 }
 
-static void flatten(const GbfValue& v, const std::string& prefix, std::vector<std::pair<std::string, GbfValue>>& leaves) {
-    if (std::holds_alternative<GbfValue::Struct>(v.v)) {
-        const auto& m = std::get<GbfValue::Struct>(v.v);
-        if (m.empty()) {
-            // Empty scalar struct: materialize leaf only when it is explicitly a value (i.e., prefix itself is a named field).
-            if (!prefix.empty()) {
-                leaves.emplace_back(prefix, v);
-            }
-            return;
-        }
-        for (const auto& kv : m) {
-            std::string child = prefix.empty() ? kv.first : (prefix + "." + kv.first);
-            flatten(kv.second, child, leaves);
-        }
-        return;
+static void check_alignment(std::size_t alignment) {
+    if (alignment > 1 && (alignment & (alignment - 1)) != 0) {
+        throw GbfError(ErrorKind::InvalidData, "alignment must be a power of two");
     }
-    leaves.emplace_back(prefix, v);
 }
 
-void write_file(const std::filesystem::path& file, const GbfValue& root, const WriteOptions& opts) {
-    // Flatten root into leaves. Root is typically a struct; for non-struct root, store at "<root>".
-    std::vector<std::pair<std::string, GbfValue>> leaves;
-    if (std::holds_alternative<GbfValue::Struct>(root.v)) {
-        flatten(root, "", leaves);
-    } else {
-        leaves.emplace_back(std::string("<root>"), root);
+static std::uint64_t align_up(std::uint64_t v, std::size_t alignment) {
+    if (alignment <= 1) return v;
+    const std::uint64_t a = static_cast<std::uint64_t>(alignment);
+    return (v + a - 1) & ~(a - 1);
+}
+
+// Pad header JSON with `reserve` spaces of slack, then more until the payload
+// (12 + header_len) starts aligned.
+static void pad_header_json(std::string& json, std::size_t reserve, std::size_t alignment) {
+    json.append(reserve, ' ');
+    const std::uint64_t start = 8ull + 4ull + static_cast<std::uint64_t>(json.size());
+    json.append(static_cast<std::size_t>(align_up(start, alignment) - start), ' ');
+}
+
+// Fill in the header CRC: CRC32 of the final (padded) text with the value still zeroed.
+static void seal_header_crc(std::string& json, std::size_t crc_pos, Header& hdr) {
+    hdr.header_crc32_hex = upper_hex8(crc32_bytes(reinterpret_cast<const std::uint8_t*>(json.data()), json.size()));
+    std::memcpy(&json[crc_pos], hdr.header_crc32_hex.data(), 8);
+}
+
+// Fill the payload_start/file_size holes of text from emit_header(..., layout_holes=true).
+static std::string splice_layout(
+    const std::string& text,
+    const HeaderSlots& slots,
+    Header& hdr,
+    std::uint64_t ps,
+    std::uint64_t fs,
+    std::size_t capacity
+) {
+    hdr.payload_start = ps;
+    hdr.file_size = fs;
+    std::string out;
+    out.reserve(capacity);
+    out.append(text, 0, slots.file_size);
+    put_u64(out, fs);
+    out.append(text, slots.file_size, slots.payload_start - slots.file_size);
+    put_u64(out, ps);
+    out.append(text, slots.payload_start, std::string::npos);
+    return out;
+}
+
+// Splice payload_start/file_size into text from emit_header(..., layout_holes=true) and pad it
+// with `reserve` spaces plus enough to align 12 + header_len. payload_start depends on its own
+// digit count through header_len, so that is solved on integers: digit counts only grow, and
+// this settles in at most a few rounds.
+static std::string place_header(
+    const std::string& text,
+    const HeaderSlots& slots,
+    Header& hdr,
+    std::uint64_t payload_size,
+    std::size_t reserve,
+    std::size_t alignment
+) {
+    std::uint64_t ps = 0;
+    std::uint64_t fs = 0;
+    std::uint64_t header_len = 0;
+    for (;;) {
+        const std::uint64_t len = text.size() + decimal_digits(ps) + decimal_digits(fs);
+        header_len = align_up(12 + len + reserve, alignment) - 12;
+        const std::uint64_t next_ps = 12 + header_len;
+        if (next_ps == ps && next_ps + payload_size == fs) break;
+        if (header_len > kMaxHeaderLen) throw GbfError(ErrorKind::InvalidData, "header too large");
+        ps = next_ps;
+        fs = next_ps + payload_size;
     }
+    std::string out = splice_layout(text, slots, hdr, ps, fs, static_cast<std::size_t>(header_len));
+    out.resize(static_cast<std::size_t>(header_len), ' ');
 
-    // Build fields and payload
-    Header hdr;
-    hdr.format = "GBF";
-    hdr.magic = "GREDBIN";
-    hdr.version = 1;
-    hdr.endianness = "little";
-    hdr.order = "column-major";
-    hdr.root = "struct";
-    hdr.created_utc = ""; // caller can set via opaque value if desired
+    seal_header_crc(out, slots.crc + decimal_digits(fs), hdr);
+    return out;
+}
 
-    std::vector<std::uint8_t> payload;
-    payload.reserve(1024);
+// Same for a compressed header: the frame is padded with zeros instead. Its size depends on
+// the spliced values only through a few bytes, so the region gets some slack and the loop
+// settles once the frame fits.
+static std::string place_compressed_header(
+    const std::string& text,
+    const HeaderSlots& slots,
+    Header& hdr,
+    std::uint64_t payload_size,
+    const WriteOptions& opts
+) {
+    std::uint64_t header_len = 0;
+    for (int iter = 0;; ++iter) {
+        if (iter == 8) throw GbfError(ErrorKind::InvalidData, "could not settle header layout");
+        const std::uint64_t ps = 12 + header_len;
+        std::string json = splice_layout(text, slots, hdr, ps, ps + payload_size, text.size() + 40);
+        seal_header_crc(json, slots.crc + decimal_digits(hdr.file_size), hdr);
+        std::string frame = encode_header_frame(json, hdr.header_codec, opts);
+        if (frame.size() + opts.header_reserve <= header_len) {
+            frame.resize(static_cast<std::size_t>(header_len), '\0');
+            return frame;
+        }
+        header_len = align_up(12 + frame.size() + opts.header_reserve + 64, opts.alignment) - 12;
+        if (header_len > kMaxHeaderLen) throw GbfError(ErrorKind::InvalidData, "header too large");
+    }
+}
 
-    std::uint64_t payload_off = 0;
-    hdr.fields.clear();
-    hdr.fields.reserve(leaves.size());
+// ------------------------------
+// Adaptive compression
+// ------------------------------
 
-    for (const auto& kv : leaves) {
-        FieldMeta meta;
-        meta.name = kv.first;
-        meta.compression = "none";
-        meta.offset = 0;
-        meta.csize = 0;
-        meta.usize = 0;
-        meta.crc32 = 0;
+namespace {
 
-        std::vector<std::uint8_t> raw = encode_value_bytes(kv.second, meta);
-        meta.usize = static_cast<std::uint64_t>(raw.size());
+// Minimal positional file access with explicit durability, for the adaptive writer and
+// update/compact.
+class RawFile {
+public:
+    RawFile(const std::filesystem::path& p, bool writable, bool create = false) : path_(p) {
+#if defined(_WIN32)
+        int flags = _O_BINARY | (writable ? _O_RDWR : _O_RDONLY) | (create ? (_O_CREAT | _O_TRUNC) : 0);
+        fd_ = ::_wopen(p.c_str(), flags, _S_IREAD | _S_IWRITE);
+#else
+        int flags = (writable ? O_RDWR : O_RDONLY) | (create ? (O_CREAT | O_TRUNC) : 0) | O_CLOEXEC;
+        fd_ = ::open(p.c_str(), flags, 0644);
+#endif
+        if (fd_ < 0) throw GbfError(ErrorKind::Io, "failed to open file: " + p.string());
+    }
+    ~RawFile() {
+#if defined(_WIN32)
+        if (fd_ >= 0) ::_close(fd_);
+#else
+        if (fd_ >= 0) ::close(fd_);
+#endif
+    }
+    RawFile(const RawFile&) = delete;
+    RawFile& operator=(const RawFile&) = delete;
+
+    std::uint64_t size() const {
+#if defined(_WIN32)
+        struct _stat64 st {};
+        if (::_fstat64(fd_, &st) != 0) fail("stat");
+#else
+        struct stat st {};
+        if (::fstat(fd_, &st) != 0) fail("stat");
+#endif
+        return static_cast<std::uint64_t>(st.st_size);
+    }
 
-        if (opts.include_crc32 && !raw.empty()) {
-            meta.crc32 = crc32_bytes(raw.data(), raw.size());
+    void read_at(std::uint64_t pos, std::uint8_t* dst, std::size_t n) const {
+        std::size_t done = 0;
+        while (done < n) {
+            const std::size_t want = std::min<std::size_t>(n - done, kMaxIo);
+#if defined(_WIN32)
+            if (::_lseeki64(fd_, static_cast<__int64>(pos + done), SEEK_SET) < 0) fail("seek");
+            int r = ::_read(fd_, dst + done, static_cast<unsigned>(want));
+#else
+            ssize_t r = ::pread(fd_, dst + done, want, static_cast<off_t>(pos + done));
+            if (r < 0 && errno == EINTR) continue;
+#endif
+            if (r < 0) fail("read");
+            if (r == 0) throw GbfError(ErrorKind::Truncated, "unexpected EOF in " + path_.string());
+            done += static_cast<std::size_t>(r);
         }
+    }
 
-        std::vector<std::uint8_t> stored = raw;
-        if (!raw.empty()) {
-            if (opts.compression == CompressionMode::Always || opts.compression == CompressionMode::Auto) {
-                std::vector<std::uint8_t> comp = zlib_compress(raw, opts.zlib_level);
-                if (opts.compression == CompressionMode::Always || (comp.size() < raw.size())) {
-                    stored = std::move(comp);
-                    meta.compression = "zlib";
-                }
-            }
+    void write_at(std::uint64_t pos, const std::uint8_t* src, std::size_t n) {
+        std::size_t done = 0;
+        while (done < n) {
+            const std::size_t want = std::min<std::size_t>(n - done, kMaxIo);
+#if defined(_WIN32)
+            if (::_lseeki64(fd_, static_cast<__int64>(pos + done), SEEK_SET) < 0) fail("seek");
+            int r = ::_write(fd_, src + done, static_cast<unsigned>(want));
+#else
+            ssize_t r = ::pwrite(fd_, src + done, want, static_cast<off_t>(pos + done));
+            if (r < 0 && errno == EINTR) continue;
+#endif
+            if (r <= 0) fail("write");
+            done += static_cast<std::size_t>(r);
         }
+    }
 
-        meta.csize = static_cast<std::uint64_t>(stored.size());
-        if (meta.csize == 0) {
-            meta.offset = 0;
-        } else {
-            meta.offset = payload_off;
-            payload_off += meta.csize;
-            payload.insert(payload.end(), stored.begin(), stored.end());
+    void truncate(std::uint64_t n) {
+#if defined(_WIN32)
+        if (::_chsize_s(fd_, static_cast<__int64>(n)) != 0) fail("truncate");
+#else
+        if (::ftruncate(fd_, static_cast<off_t>(n)) != 0) fail("truncate");
+#endif
+    }
+
+    int fd() const { return fd_; }
+
+    void sync() {
+#if defined(_WIN32)
+        if (::_commit(fd_) != 0) fail("sync");
+#else
+        if (::fsync(fd_) != 0) fail("sync");
+#endif
+    }
+
+    // Starts writing [pos, pos + n) back to the device without waiting (Linux only; a no-op
+    // elsewhere).
+    void start_writeback(std::uint64_t pos, std::uint64_t n) {
+#if defined(__linux__)
+        if (::sync_file_range(fd_, static_cast<off64_t>(pos), static_cast<off64_t>(n), SYNC_FILE_RANGE_WRITE) != 0) {
+            fail("sync");
         }
+#else
+        (void)pos;
+        (void)n;
+#endif
+    }
 
-        hdr.fields.push_back(std::move(meta));
+    // Waits until [pos, pos + n) has reached the device. Linux syncs just that range; elsewhere
+    // this is a full sync.
+    void sync_range(std::uint64_t pos, std::uint64_t n) {
+#if defined(__linux__)
+        const unsigned flags = SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER;
+        if (::sync_file_range(fd_, static_cast<off64_t>(pos), static_cast<off64_t>(n), flags) != 0) fail("sync");
+#else
+        (void)pos;
+        (void)n;
+        sync();
+#endif
     }
 
-    // Iteratively finalize header JSON because payload_start and file_size depend on header_len.
-    hdr.payload_start = 0;
-    hdr.file_size = 0;
-    hdr.header_crc32_hex = "00000000";
+private:
+    static constexpr std::size_t kMaxIo = std::size_t{1} << 30;
 
-    std::string header_json;
-    std::uint32_t header_len = 0;
+    [[noreturn]] void fail(const char* what) const {
+        throw GbfError(ErrorKind::Io, std::string(what) + " failed on " + path_.string() + ": " + std::strerror(errno));
+    }
 
-    for (int iter = 0; iter < 6; ++iter) {
-        internal::Json j0 = header_to_json(hdr, /*crc_zeroed=*/true);
-        header_json = internal::json_dump_compact(j0);
-        header_len = static_cast<std::uint32_t>(header_json.size());
+    std::filesystem::path path_;
+    int fd_{-1};
+};
 
-        std::uint64_t new_payload_start = 8ull + 4ull + static_cast<std::uint64_t>(header_len);
-        std::uint64_t new_file_size = new_payload_start + static_cast<std::uint64_t>(payload.size());
 
-        if (hdr.payload_start == new_payload_start && hdr.file_size == new_file_size) {
-            break;
-        }
-        hdr.payload_start = new_payload_start;
-        hdr.file_size = new_file_size;
+// Picks the codec level for the next field from the throughput measured so far.
+// Measurements are accumulated over a window of at least kWindowBytes of raw input so
+// that tiny fields do not make the level oscillate.
+class LevelController {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    LevelController(const AdaptiveCompression& cfg, int start_level, std::uint64_t total_raw)
+        : cfg_(cfg),
+          level_(std::clamp(start_level, cfg.min_level, cfg.max_level)),
+          total_raw_(total_raw),
+          t0_(Clock::now()) {}
+
+    int level() const { return level_; }
+
+    static double seconds_since(Clock::time_point t) {
+        return std::chrono::duration<double>(Clock::now() - t).count();
     }
 
-    // Compute header CRC on zeroed header JSON bytes and write into the actual field.
-    std::uint32_t crc = crc32_str_zeroed_header(header_json);
-    hdr.header_crc32_hex = upper_hex8(crc);
+    void add_compress(std::size_t raw, double secs) {
+        win_raw_ += raw;
+        win_compress_s_ += secs;
+    }
 
-    // Now serialize with crc value (but CRC is still computed on zeroed header string, per spec).
-    internal::Json j_final = header_to_json(hdr, /*crc_zeroed=*/false);
-    std::string header_json_final = internal::json_dump_compact(j_final);
-    if (header_json_final.size() != header_len) {
-        // CRC string is fixed-width, but payload_start/file_size might have changed due to digits. Re-run if needed.
-        hdr.header_crc32_hex = "00000000";
-        // One more fixpoint.
-        for (int iter = 0; iter < 6; ++iter) {
-            internal::Json j0 = header_to_json(hdr, /*crc_zeroed=*/true);
-            header_json = internal::json_dump_compact(j0);
-            header_len = static_cast<std::uint32_t>(header_json.size());
+    // `stored` bytes were handed to the file in `secs`.
+    void add_write(std::size_t stored, double secs) {
+        win_stored_ += stored;
+        pending_bytes_ += stored;
+        pending_s_ += secs;
+    }
 
-            std::uint64_t new_payload_start = 8ull + 4ull + static_cast<std::uint64_t>(header_len);
-            std::uint64_t new_file_size = new_payload_start + static_cast<std::uint64_t>(payload.size());
+    // Everything written since the last call reached the device after `secs` more of waiting;
+    // that span sets the I/O cost per byte until the next one.
+    void add_sync(double secs) {
+        if (pending_bytes_ == 0) return;
+        io_s_per_byte_ = (pending_s_ + secs) / static_cast<double>(pending_bytes_);
+        pending_bytes_ = 0;
+        pending_s_ = 0.0;
+    }
 
-            if (hdr.payload_start == new_payload_start && hdr.file_size == new_file_size) {
-                break;
+    // Called after each field has been written.
+    void field_done(std::size_t raw) {
+        done_raw_ += raw;
+        if (win_raw_ < kWindowBytes) return;
+
+        // Until the first sync completes, only the (page cache) write time is known.
+        const double per_byte = io_s_per_byte_ > 0.0 ? io_s_per_byte_
+            : pending_bytes_ > 0 ? pending_s_ / static_cast<double>(pending_bytes_) : 0.0;
+        const double win_io_s = static_cast<double>(win_stored_) * per_byte;
+        const double required = required_rate();
+        const double spent = win_compress_s_ + win_io_s;
+        if (required > 0.0 && spent > 0.0) {
+            const double achieved = static_cast<double>(win_raw_) / spent;
+            if (achieved < required * 0.95) {
+                // Too slow: if compression dominates, compress less; if the disk dominates,
+                // compress harder so fewer bytes hit the disk.
+                step(win_compress_s_ >= win_io_s ? -1 : +1);
+            } else if (achieved > required * 1.25) {
+                step(+1); // headroom: spend it on ratio
             }
-            hdr.payload_start = new_payload_start;
-            hdr.file_size = new_file_size;
         }
-        crc = crc32_str_zeroed_header(header_json);
-        hdr.header_crc32_hex = upper_hex8(crc);
-        j_final = header_to_json(hdr, /*crc_zeroed=*/false);
-        header_json_final = internal::json_dump_compact(j_final);
-        header_len = static_cast<std::uint32_t>(header_json_final.size());
+        win_raw_ = 0;
+        win_compress_s_ = 0.0;
+        win_stored_ = 0;
     }
 
-    // Write file
-    std::ofstream os(file, std::ios::binary | std::ios::trunc);
-    if (!os) throw GbfError(ErrorKind::Io, "failed to open for write: " + file.string());
-
-    // 8-byte magic
-    std::array<char, 8> magic{};
-    std::memset(magic.data(), 0, magic.size());
-    std::memcpy(magic.data(), "GREDBIN", 7); // include trailing NUL or keep 8? "GREDBIN" is 7 letters; but examples show 7? Actually GREDBIN is 7. We'll pad with NUL.
-    // If you want exactly 7 chars + NUL, this is correct.
-    os.write(magic.data(), magic.size());
-    write_u32_le(os, header_len);
-    os.write(header_json_final.data(), static_cast<std::streamsize>(header_json_final.size()));
-    if (!payload.empty()) {
-        os.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+private:
+    static constexpr std::size_t kWindowBytes = 1u << 20;
+
+    // Raw bytes/s needed from here on; 0 => unconstrained.
+    double required_rate() const {
+        double rate = cfg_.target_mib_s > 0.0 ? cfg_.target_mib_s * 1024.0 * 1024.0 : 0.0;
+        if (cfg_.deadline_s > 0.0) {
+            const double left_s = cfg_.deadline_s - seconds_since(t0_);
+            const double left_bytes = static_cast<double>(total_raw_ - std::min(done_raw_, total_raw_));
+            if (left_s <= 0.0) return std::numeric_limits<double>::infinity();
+            rate = std::max(rate, left_bytes / left_s);
+        }
+        return rate;
+    }
+
+    void step(int d) { level_ = std::clamp(level_ + d, cfg_.min_level, cfg_.max_level); }
+
+    AdaptiveCompression cfg_;
+    int level_;
+    std::uint64_t total_raw_;
+    std::uint64_t done_raw_{0};
+    Clock::time_point t0_;
+
+    std::size_t win_raw_{0};
+    double win_compress_s_{0.0};
+    std::size_t win_stored_{0};
+
+    std::uint64_t pending_bytes_{0};
+    double pending_s_{0.0};
+    double io_s_per_byte_{0.0};
+};
+
+} // namespace
+
+// Streaming writer used when adaptive compression is on: fields go straight to disk behind a
+// header region sized for the worst case, so I/O time can be measured per field.
+static void write_file_adaptive(
+    const std::filesystem::path& file,
+    const std::vector<std::pair<std::string, GbfValue>>& leaves,
+    Header hdr,
+    const Codec& codec,
+    int start_level,
+    const WriteOptions& opts
+) {
+    const AdaptiveCompression& ad = opts.adaptive;
+    if (ad.min_level > ad.max_level) {
+        throw GbfError(ErrorKind::InvalidData, "adaptive compression: min_level > max_level");
+    }
+
+    // Encode up front: the deadline controller needs the total raw size.
+    std::vector<ByteBuffer> raws;
+    raws.reserve(leaves.size());
+    std::uint64_t total_raw = 0;
+    hdr.fields.clear();
+    hdr.fields.reserve(leaves.size());
+    for (const auto& kv : leaves) {
+        FieldMeta meta;
+        meta.name = kv.first;
+        raws.push_back(encode_value_bytes(kv.second, meta));
+        total_raw += static_cast<std::uint64_t>(raws.back().size());
+        hdr.fields.push_back(std::move(meta));
+    }
+
+    // Size the header region for the widest possible values, so the final header always fits.
+    Header widest = hdr;
+    const std::uint64_t kMax64 = std::numeric_limits<std::uint64_t>::max();
+    for (auto& meta : widest.fields) {
+        meta.compression = codec.name.size() > 4 ? codec.name : std::string("none");
+        meta.offset = kMax64;
+        meta.csize = kMax64;
+        meta.usize = kMax64;
+        meta.crc32 = std::numeric_limits<std::uint32_t>::max();
+        meta.level = std::numeric_limits<int>::max();
+    }
+    widest.payload_start = kMax64;
+    widest.file_size = kMax64;
+    HeaderSlots slots;
+    std::string widest_json = emit_header(widest, slots, /*layout_holes=*/false);
+    pad_header_json(widest_json, opts.header_reserve, opts.alignment);
+    const std::size_t header_len = widest_json.size();
+    if (header_len > kMaxHeaderLen) {
+        throw GbfError(ErrorKind::InvalidData, "header too large");
+    }
+
+    RawFile out(file, /*writable=*/true, /*create=*/true);
+    hdr.payload_start = 8ull + 4ull + static_cast<std::uint64_t>(header_len);
+
+    // The I/O term must measure the device, not the copy into the page cache. Writeback starts
+    // right after each write; every kSyncBytes of payload the writer waits for it, and the
+    // whole span (writes plus wait) gives the controller its I/O cost per byte.
+    constexpr std::uint64_t kSyncBytes = std::uint64_t{32} << 20;
+    LevelController ctl(ad, start_level, total_raw);
+    std::uint64_t payload_off = 0;
+    std::uint64_t synced_off = 0;
+    for (std::size_t i = 0; i < raws.size(); ++i) {
+        FieldMeta& meta = hdr.fields[i];
+        ByteBuffer raw = std::move(raws[i]);
+        meta.compression = "none";
+        meta.crc32 = (opts.include_crc32 && !raw.empty()) ? crc32_bytes(raw.data(), raw.size()) : 0;
+
+        ByteBuffer stored;
+        if (!raw.empty()) {
+            const int level = ctl.level();
+            auto t = LevelController::Clock::now();
+            ByteBuffer comp = codec_compress(codec, raw, level);
+            ctl.add_compress(raw.size(), LevelController::seconds_since(t));
+            if (opts.compression == CompressionMode::Always || comp.size() < raw.size()) {
+                stored = std::move(comp);
+                meta.compression = codec.name;
+                meta.level = level;
+            } else {
+                stored = std::move(raw);
+            }
+        }
+
+        meta.csize = static_cast<std::uint64_t>(stored.size());
+        meta.offset = 0;
+        if (!stored.empty()) {
+            payload_off = align_up(payload_off, opts.alignment); // the gap reads back as zeros
+            meta.offset = payload_off;
+            auto t = LevelController::Clock::now();
+            out.write_at(hdr.payload_start + payload_off, stored.data(), stored.size());
+            out.start_writeback(hdr.payload_start + payload_off, stored.size());
+            ctl.add_write(stored.size(), LevelController::seconds_since(t));
+            payload_off += meta.csize;
+        }
+        if (payload_off > synced_off && (payload_off - synced_off >= kSyncBytes || i + 1 == raws.size())) {
+            auto t = LevelController::Clock::now();
+            out.sync_range(hdr.payload_start + synced_off, payload_off - synced_off);
+            ctl.add_sync(LevelController::seconds_since(t));
+            synced_off = payload_off;
+        }
+        ctl.field_done(static_cast<std::size_t>(meta.usize));
+    }
+
+    hdr.file_size = hdr.payload_start + payload_off;
+    std::string header_json = emit_header(hdr, slots, /*layout_holes=*/false);
+    if (header_json.size() > header_len) {
+        throw GbfError(ErrorKind::InvalidData, "header exceeds its reserved size");
+    }
+    header_json.resize(header_len, ' '); // trailing whitespace is valid JSON
+    seal_header_crc(header_json, slots.crc, hdr);
+
+    const std::vector<std::uint8_t> head = header_block(hdr, header_json);
+    out.write_at(0, head.data(), head.size());
+    out.truncate(hdr.file_size);
+}
+
+static void flatten(const GbfValue& v, const std::string& prefix, std::vector<std::pair<std::string, GbfValue>>& leaves) {
+    if (std::holds_alternative<GbfValue::Struct>(v.v)) {
+        const auto& m = std::get<GbfValue::Struct>(v.v);
+        if (m.empty()) {
+            // Empty scalar struct: materialize leaf only when it is explicitly a value (i.e., prefix itself is a named field).
+            if (!prefix.empty()) {
+                leaves.emplace_back(prefix, v);
+            }
+            return;
+        }
+        for (const auto& kv : m) {
+            std::string child = prefix.empty() ? kv.first : (prefix + "." + kv.first);
+            flatten(kv.second, child, leaves);
+        }
+        return;
+    }
+    leaves.emplace_back(prefix, v);
+}
+
+// Like flatten, but moves the leaves out of `v`.
+static void flatten_move(GbfValue&& v, const std::string& prefix, std::vector<std::pair<std::string, GbfValue>>& leaves) {
+    if (auto* m = std::get_if<GbfValue::Struct>(&v.v)) {
+        if (m->empty()) {
+            if (!prefix.empty()) leaves.emplace_back(prefix, std::move(v));
+            return;
+        }
+        for (auto& kv : *m) {
+            flatten_move(std::move(kv.second), prefix.empty() ? kv.first : (prefix + "." + kv.first), leaves);
+        }
+        return;
+    }
+    leaves.emplace_back(prefix, std::move(v));
+}
+
+// Throws InvalidData unless `path` has no empty segments and `value` is something a leaf can
+// hold: a non-empty struct would be written as an empty one, silently dropping its fields.
+static void check_leaf(std::string_view path, const GbfValue& value) {
+    if (path.empty() || path.front() == '.' || path.back() == '.' || path.find("..") != std::string_view::npos) {
+        throw GbfError(ErrorKind::InvalidData, "invalid path: empty segment in '" + std::string(path) + "'");
+    }
+    if (const auto* m = std::get_if<GbfValue::Struct>(&value.v); m && !m->empty()) {
+        throw GbfError(ErrorKind::InvalidData, "leaf '" + std::string(path) + "' holds a non-empty struct; add its fields as leaves");
+    }
+}
+
+// Throws InvalidData if a leaf is invalid (see check_leaf) or its path is also the prefix of
+// another ("a" and "a.b"), which no tree can hold.
+static void check_leaf_paths(const std::vector<Dataset::Leaf>& leaves) {
+    std::vector<std::string_view> names;
+    names.reserve(leaves.size());
+    for (const auto& leaf : leaves) {
+        check_leaf(leaf.first, leaf.second); // leaves may have been changed through at()/find()
+        names.emplace_back(leaf.first);
+    }
+    std::sort(names.begin(), names.end());
+    std::string probe;
+    for (std::string_view n : names) {
+        probe.assign(n);
+        probe.push_back('.');
+        auto it = std::lower_bound(names.begin(), names.end(), std::string_view(probe));
+        if (it != names.end() && it->compare(0, probe.size(), probe) == 0) {
+            throw GbfError(ErrorKind::InvalidData, "path is both a leaf and a struct: '" + std::string(n) + "'");
+        }
+    }
+}
+
+// ------------------------------
+// Flat datasets
+// ------------------------------
+
+Dataset::Dataset(const GbfValue& root) {
+    std::vector<Leaf> leaves;
+    if (root.is_struct()) flatten(root, "", leaves);
+    else leaves.emplace_back(std::string("<root>"), root);
+    reserve(leaves.size());
+    for (auto& leaf : leaves) add(std::move(leaf.first), std::move(leaf.second));
+}
+
+Dataset::Dataset(GbfValue&& root) {
+    std::vector<Leaf> leaves;
+    if (root.is_struct()) flatten_move(std::move(root), "", leaves);
+    else leaves.emplace_back(std::string("<root>"), std::move(root));
+    reserve(leaves.size());
+    for (auto& leaf : leaves) add(std::move(leaf.first), std::move(leaf.second));
+}
+
+GbfValue Dataset::to_value() const& {
+    return Dataset(*this).to_value();
+}
+
+GbfValue Dataset::to_value() && {
+    check_leaf_paths(leaves_);
+    GbfValue root = GbfValue::make_struct();
+    for (auto& leaf : leaves_) insert_path(root, leaf.first, std::move(leaf.second));
+    leaves_.clear();
+    index_.clear();
+    return root;
+}
+
+void Dataset::reserve(std::size_t n) {
+    leaves_.reserve(n);
+    index_.reserve(n);
+}
+
+std::size_t Dataset::index_of(std::string_view path) const {
+    auto [lo, hi] = index_.equal_range(std::hash<std::string_view>{}(path));
+    for (; lo != hi; ++lo) {
+        if (leaves_[lo->second].first == path) return lo->second;
+    }
+    return leaves_.size();
+}
+
+GbfValue& Dataset::add(std::string path, GbfValue value) {
+    check_leaf(path, value);
+    if (index_of(path) != leaves_.size()) throw GbfError(ErrorKind::InvalidData, "duplicate path: '" + path + "'");
+    index_.emplace(std::hash<std::string_view>{}(path), leaves_.size());
+    leaves_.emplace_back(std::move(path), std::move(value));
+    return leaves_.back().second;
+}
+
+GbfValue& Dataset::set(std::string path, GbfValue value) {
+    if (GbfValue* v = find(path)) {
+        check_leaf(path, value);
+        return *v = std::move(value);
+    }
+    return add(std::move(path), std::move(value));
+}
+
+const GbfValue* Dataset::find(std::string_view path) const {
+    const std::size_t i = index_of(path);
+    return i < leaves_.size() ? &leaves_[i].second : nullptr;
+}
+
+GbfValue* Dataset::find(std::string_view path) {
+    const std::size_t i = index_of(path);
+    return i < leaves_.size() ? &leaves_[i].second : nullptr;
+}
+
+const GbfValue& Dataset::at(std::string_view path) const {
+    if (const GbfValue* v = find(path)) return *v;
+    throw GbfError(ErrorKind::NotFound, "variable not found: " + std::string(path));
+}
+
+GbfValue& Dataset::at(std::string_view path) {
+    if (GbfValue* v = find(path)) return *v;
+    throw GbfError(ErrorKind::NotFound, "variable not found: " + std::string(path));
+}
+
+std::vector<const Dataset::Leaf*> Dataset::with_prefix(std::string_view prefix) const {
+    std::vector<const Leaf*> out;
+    for (const auto& leaf : leaves_) {
+        const std::string& n = leaf.first;
+        if (prefix.empty() || n == prefix ||
+            (n.size() > prefix.size() && n.compare(0, prefix.size(), prefix) == 0 && n[prefix.size()] == '.')) {
+            out.push_back(&leaf);
+        }
+    }
+    return out;
+}
+
+static const Codec* resolve_codec(const WriteOptions& opts, int& level) {
+    level = opts.codec_level;
+    if (opts.compression == CompressionMode::Never) return nullptr;
+    const Codec* codec = &require_codec(opts.codec);
+    if (codec->name == "zlib") level = opts.zlib_level;
+    return codec;
+}
+
+// Encode one leaf into its stored (possibly compressed) bytes; fills everything in `meta`
+// except `offset`.
+static ByteBuffer encode_field(
+    const GbfValue& v,
+    FieldMeta& meta,
+    const WriteOptions& opts,
+    const Codec* codec,
+    int codec_level
+) {
+    meta.compression = "none";
+    meta.offset = 0;
+    meta.csize = 0;
+    meta.usize = 0;
+    meta.crc32 = 0;
+
+    ByteBuffer raw = encode_value_bytes(v, meta);
+    meta.usize = static_cast<std::uint64_t>(raw.size());
+
+    if (opts.include_crc32 && !raw.empty()) {
+        meta.crc32 = crc32_bytes(raw.data(), raw.size());
+    }
+
+    ByteBuffer stored = std::move(raw);
+    if (!stored.empty() && codec) {
+        ByteBuffer comp = codec_compress(*codec, stored, codec_level);
+        if (opts.compression == CompressionMode::Always || (comp.size() < stored.size())) {
+            stored = std::move(comp);
+            meta.compression = codec->name;
+        }
+    }
+    meta.csize = static_cast<std::uint64_t>(stored.size());
+    return stored;
+}
+
+// Build the index for hdr.fields, place it at the next 8-byte boundary after `payload_off`
+// (which then moves past it) and reference it from the header.
+static std::vector<std::uint8_t> attach_field_index(Header& hdr, std::uint64_t& payload_off) {
+    std::vector<std::uint8_t> index = build_field_index(hdr.fields);
+    FieldIndexRef ref;
+    ref.offset = align_up(payload_off, 8);
+    ref.size = index.size();
+    ref.crc32 = crc32_bytes(index.data(), index.size());
+    hdr.field_index = ref;
+    payload_off = ref.offset + ref.size;
+    return index;
+}
+
+// Settle payload_start/file_size/header_crc32_hex for a payload of `payload_size` bytes placed
+// right after the header, and return the final header region: the padded JSON, or the padded
+// compressed frame when opts.header_codec is set.
+static std::string finalize_header(Header& hdr, std::uint64_t payload_size, const WriteOptions& opts) {
+    hdr.header_codec = opts.header_codec.empty() ? std::string() : require_codec(opts.header_codec).name;
+    HeaderSlots slots;
+    const std::string text = emit_header(hdr, slots, /*layout_holes=*/true);
+    if (!hdr.header_codec.empty()) return place_compressed_header(text, slots, hdr, payload_size, opts);
+    return place_header(text, slots, hdr, payload_size, opts.header_reserve, opts.alignment);
+}
+
+// Defined with the positional I/O helpers below.
+static void write_file_parallel(
+    const std::filesystem::path& file,
+    const std::vector<std::pair<std::string, GbfValue>>& leaves,
+    Header& hdr,
+    const Codec* codec,
+    int codec_level,
+    const WriteOptions& opts
+);
+
+static Header new_header() {
+    Header hdr;
+    hdr.format = "GBF";
+    hdr.magic = "GREDBIN";
+    hdr.version = 1;
+    hdr.endianness = "little";
+    hdr.order = "column-major";
+    hdr.root = "struct";
+    hdr.created_utc = ""; // caller can set via opaque value if desired
+    return hdr;
+}
+
+static void write_leaves(
+    const std::filesystem::path& file,
+    const std::vector<std::pair<std::string, GbfValue>>& leaves,
+    const WriteOptions& opts
+) {
+    // Build fields and payload
+    Header hdr = new_header();
+
+    int codec_level = 0;
+    const Codec* codec = resolve_codec(opts, codec_level);
+    if (codec && opts.adaptive.enabled) {
+        write_file_adaptive(file, leaves, hdr, *codec, codec_level, opts);
+        return;
+    }
+    if (opts.write_threads > 1) {
+        write_file_parallel(file, leaves, hdr, codec, codec_level, opts);
+        return;
+    }
+
+    ByteBuffer payload;
+    payload.reserve(1024);
+
+    std::uint64_t payload_off = 0;
+    hdr.fields.clear();
+    hdr.fields.reserve(leaves.size());
+
+    for (const auto& kv : leaves) {
+        FieldMeta meta;
+        meta.name = kv.first;
+        ByteBuffer stored = encode_field(kv.second, meta, opts, codec, codec_level);
+
+        if (meta.csize == 0) {
+            meta.offset = 0;
+        } else {
+            const std::uint64_t aligned = align_up(payload_off, opts.alignment);
+            payload.resize(static_cast<std::size_t>(aligned), 0);
+            payload_off = aligned;
+            meta.offset = payload_off;
+            payload_off += meta.csize;
+            payload.insert(payload.end(), stored.begin(), stored.end());
+        }
+
+        hdr.fields.push_back(std::move(meta));
+    }
+    if (opts.field_index) {
+        std::vector<std::uint8_t> index = attach_field_index(hdr, payload_off);
+        payload.resize(static_cast<std::size_t>(hdr.field_index->offset), 0);
+        payload.insert(payload.end(), index.begin(), index.end());
+    }
+
+    const std::vector<std::uint8_t> head = header_block(hdr, finalize_header(hdr, payload.size(), opts));
+
+    // Write file
+    if (opts.direct_io.enabled && hdr.file_size >= opts.direct_io.min_bytes) {
+        const std::vector<detail::ConstBytes> parts = {
+            {head.data(), head.size()},
+            {payload.data(), payload.size()},
+        };
+        if (detail::direct_write(file, parts, opts.direct_io)) return;
+    }
+
+    std::ofstream os(file, std::ios::binary | std::ios::trunc);
+    if (!os) throw GbfError(ErrorKind::Io, "failed to open for write: " + file.string());
+
+    os.write(reinterpret_cast<const char*>(head.data()), static_cast<std::streamsize>(head.size()));
+    if (!payload.empty()) {
+        os.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
     }
     if (!os) throw GbfError(ErrorKind::Io, "failed writing GBF file");
 }
 
+void write_file(const std::filesystem::path& file, const GbfValue& root, const WriteOptions& opts) {
+    check_alignment(opts.alignment);
+
+    // Flatten root into leaves. Root is typically a struct; for non-struct root, store at "<root>".
+    std::vector<std::pair<std::string, GbfValue>> leaves;
+    if (std::holds_alternative<GbfValue::Struct>(root.v)) {
+        flatten(root, "", leaves);
+    } else {
+        leaves.emplace_back(std::string("<root>"), root);
+    }
+    write_leaves(file, leaves, opts);
+}
+
+void write_file(const std::filesystem::path& file, const Dataset& data, const WriteOptions& opts) {
+    check_alignment(opts.alignment);
+    check_leaf_paths(data.leaves());
+    write_leaves(file, data.leaves(), opts);
+}
+
+// ------------------------------
+// In-place updates
+// ------------------------------
+
+namespace {
+
+// Run fn(i) for i in [0, n) on up to `threads` threads. The first exception stops the
+// remaining work and is rethrown.
+template <class Fn>
+void parallel_for(std::size_t n, unsigned threads, Fn fn) {
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool> stop{false};
+    std::exception_ptr error;
+    std::mutex error_mu;
+
+    auto worker = [&]() {
+        try {
+            while (!stop.load(std::memory_order_relaxed)) {
+                const std::size_t i = next.fetch_add(1);
+                if (i >= n) return;
+                fn(i);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mu);
+            if (!error) error = std::current_exception();
+            stop = true;
+        }
+    };
+
+    const std::size_t nthreads = std::min<std::size_t>(std::max(threads, 1u), n);
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < nthreads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+    if (error) std::rethrow_exception(error);
+}
+
+// Make a create/rename/remove in `p`'s directory durable (no-op where unsupported).
+void sync_parent_dir(const std::filesystem::path& p) {
+#if !defined(_WIN32)
+    std::filesystem::path dir = p.parent_path();
+    if (dir.empty()) dir = ".";
+    int fd = ::open(dir.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        (void)::fsync(fd);
+        ::close(fd);
+    }
+#else
+    (void)p;
+#endif
+}
+
+} // namespace
+
+// Undo journal "<file>.gbfj", written and synced before the data file is touched:
+//   [8B "GBFJRNL\0"][u64 original file size][u32 record count]
+//   records: [u64 pos][u64 len][len bytes of original content]
+//   [u32 CRC32 of everything above]
+// A complete journal means the file may be half-updated: put the records back and truncate.
+// An incomplete one means the file was never touched: just drop it.
+static const char kJournalMagic[8] = {'G', 'B', 'F', 'J', 'R', 'N', 'L', '\0'};
+
+struct UndoRecord {
+    std::uint64_t pos{0};
+    std::vector<std::uint8_t> bytes{};
+};
+
+static std::filesystem::path journal_path(const std::filesystem::path& file) {
+    std::filesystem::path j = file;
+    j += ".gbfj";
+    return j;
+}
+
+static void write_journal(const std::filesystem::path& file, std::uint64_t old_size, const std::vector<UndoRecord>& records) {
+    std::vector<std::uint8_t> j(kJournalMagic, kJournalMagic + 8);
+    append_u64_le(j, old_size);
+    append_u32_le(j, static_cast<std::uint32_t>(records.size()));
+    for (const auto& r : records) {
+        append_u64_le(j, r.pos);
+        append_u64_le(j, static_cast<std::uint64_t>(r.bytes.size()));
+        j.insert(j.end(), r.bytes.begin(), r.bytes.end());
+    }
+    append_u32_le(j, crc32_bytes(j.data(), j.size()));
+
+    const std::filesystem::path jp = journal_path(file);
+    RawFile jf(jp, /*writable=*/true, /*create=*/true);
+    jf.write_at(0, j.data(), j.size());
+    jf.sync();
+    sync_parent_dir(jp);
+}
+
+bool recover_file(const std::filesystem::path& file) {
+    const std::filesystem::path jp = journal_path(file);
+    std::error_code ec;
+    if (!std::filesystem::exists(jp, ec)) return false;
+
+    std::vector<std::uint8_t> j;
+    {
+        RawFile jf(jp, /*writable=*/false);
+        j.resize(static_cast<std::size_t>(jf.size()));
+        if (!j.empty()) jf.read_at(0, j.data(), j.size());
+    }
+
+    // Parse; any inconsistency means the journal itself never completed.
+    bool complete = j.size() >= 8 + 8 + 4 + 4 && std::memcmp(j.data(), kJournalMagic, 8) == 0 &&
+        read_u32_le_from(j.data() + j.size() - 4) == crc32_bytes(j.data(), j.size() - 4);
+    std::uint64_t old_size = 0;
+    std::vector<UndoRecord> records;
+    if (complete) {
+        const std::uint8_t* p = j.data() + 8;
+        const std::uint8_t* end = j.data() + j.size() - 4;
+        old_size = static_cast<std::uint64_t>(read_i64_le_from(p));
+        std::uint32_t count = read_u32_le_from(p + 8);
+        p += 12;
+        for (std::uint32_t i = 0; i < count && complete; ++i) {
+            if (end - p < 16) { complete = false; break; }
+            UndoRecord r;
+            r.pos = static_cast<std::uint64_t>(read_i64_le_from(p));
+            std::uint64_t len = static_cast<std::uint64_t>(read_i64_le_from(p + 8));
+            p += 16;
+            if (len > static_cast<std::uint64_t>(end - p)) { complete = false; break; }
+            r.bytes.assign(p, p + len);
+            p += len;
+            records.push_back(std::move(r));
+        }
+    }
+
+    if (complete) {
+        RawFile f(file, /*writable=*/true);
+        for (const auto& r : records) f.write_at(r.pos, r.bytes.data(), r.bytes.size());
+        f.truncate(old_size);
+        f.sync();
+    }
+    std::filesystem::remove(jp);
+    sync_parent_dir(jp);
+    return complete;
+}
+
+namespace {
+
+// One contiguous stored byte range in the layout being committed to an existing file.
+struct PlannedBlob {
+    enum class Mode { Keep, InPlace, Append };
+    Mode mode{Mode::Keep};
+    std::uint64_t pos{0};              // absolute: current bytes (Keep) or slot to overwrite (InPlace)
+    std::uint64_t size{0};
+    ByteBuffer data{};                 // stored bytes for InPlace/Append
+};
+
+// A field and its blobs: one per extent, or one for the whole payload (none when empty).
+struct PlannedField {
+    FieldMeta meta{};
+    std::vector<PlannedBlob> blobs{};
+};
+
+PlannedField kept_field(const FieldMeta& f, std::uint64_t payload_start) {
+    PlannedField pf;
+    pf.meta = f;
+    if (!f.extents.empty()) {
+        for (const auto& e : f.extents) {
+            PlannedBlob b;
+            b.pos = payload_start + e.offset;
+            b.size = e.csize;
+            pf.blobs.push_back(std::move(b));
+        }
+    } else if (f.csize > 0) {
+        PlannedBlob b;
+        b.pos = payload_start + f.offset;
+        b.size = f.csize;
+        pf.blobs.push_back(std::move(b));
+    }
+    return pf;
+}
+
+PlannedBlob new_blob(ByteBuffer data) {
+    PlannedBlob b;
+    b.mode = PlannedBlob::Mode::Append;
+    b.size = static_cast<std::uint64_t>(data.size());
+    b.data = std::move(data);
+    return b;
+}
+
+} // namespace
+
+// Rewrite `file`'s header for `fields`, writing new payloads in place or after the current end
+// of file. Blobs that fall inside a grown header region are moved to the end as well.
+// Crash-safe through the undo journal; dead space is left for compact_file().
+static void commit_fields(
+    const std::filesystem::path& file,
+    const Header& old_hdr,
+    std::uint32_t old_header_len,
+    std::vector<PlannedField> fields,
+    const WriteOptions& opts
+) {
+    RawFile f(file, /*writable=*/true);
+    const std::uint64_t old_size = f.size();
+
+    Header hdr = old_hdr;
+    hdr.field_index.reset(); // would go stale; compact_file can rebuild it
+    std::uint64_t header_len = old_header_len;
+    std::string header_json;
+    HeaderSlots slots;
+    std::vector<std::vector<std::uint64_t>> dest(fields.size());
+
+    for (int iter = 0;; ++iter) {
+        if (iter == 8) throw GbfError(ErrorKind::InvalidData, "could not settle header layout");
+        const std::uint64_t ps = 8ull + 4ull + header_len;
+        std::uint64_t tail = std::max(old_size, ps);
+        hdr.fields.clear();
+        for (std::size_t i = 0; i < fields.size(); ++i) {
+            const auto& blobs = fields[i].blobs;
+            dest[i].assign(blobs.size(), 0);
+            for (std::size_t k = 0; k < blobs.size(); ++k) {
+                if (blobs[k].size == 0) {
+                    dest[i][k] = ps;
+                } else if (blobs[k].mode == PlannedBlob::Mode::Append || blobs[k].pos < ps) {
+                    tail = align_up(tail, opts.alignment);
+                    dest[i][k] = tail;
+                    tail += blobs[k].size;
+                } else {
+                    dest[i][k] = blobs[k].pos;
+                }
+            }
+
+            FieldMeta meta = fields[i].meta;
+            for (std::size_t k = 0; k < meta.extents.size(); ++k) meta.extents[k].offset = dest[i][k] - ps;
+            meta.offset = dest[i].empty() ? 0 : dest[i][0] - ps;
+            hdr.fields.push_back(std::move(meta));
+        }
+        hdr.payload_start = ps;
+        hdr.file_size = tail;
+        header_json = emit_header(hdr, slots, /*layout_holes=*/false);
+        if (!hdr.header_codec.empty()) {
+            // A compressed header keeps its framing; the region then holds the frame.
+            seal_header_crc(header_json, slots.crc, hdr);
+            header_json = encode_header_frame(header_json, hdr.header_codec, opts);
+        }
+        if (header_json.size() <= header_len) break;
+
+        // Relocate: grow the header with slack so the next few updates fit again.
+        pad_header_json(header_json, std::max(opts.header_reserve, header_json.size() / 4), opts.alignment);
+        header_len = header_json.size();
+        if (header_len > kMaxHeaderLen) throw GbfError(ErrorKind::InvalidData, "header too large");
+    }
+
+    if (hdr.header_codec.empty()) {
+        header_json.resize(static_cast<std::size_t>(header_len), ' ');
+        seal_header_crc(header_json, slots.crc, hdr);
+    } else {
+        header_json.resize(static_cast<std::size_t>(header_len), '\0');
+    }
+    const std::vector<std::uint8_t> head = header_block(hdr, header_json);
+
+    // Collect writes; kept blobs that move are copied before anything is overwritten.
+    struct Write { std::uint64_t pos; const std::uint8_t* data; std::size_t size; };
+    std::vector<Write> writes;
+    for (std::size_t i = 0; i < fields.size(); ++i) {
+        for (std::size_t k = 0; k < fields[i].blobs.size(); ++k) {
+            PlannedBlob& b = fields[i].blobs[k];
+            if (b.size == 0) continue;
+            if (b.mode == PlannedBlob::Mode::Keep) {
+                if (dest[i][k] == b.pos) continue;
+                b.data.resize_uninitialized(static_cast<std::size_t>(b.size));
+                f.read_at(b.pos, b.data.data(), b.data.size());
+            }
+            writes.push_back({dest[i][k], b.data.data(), b.data.size()});
+        }
+    }
+    writes.push_back({0, head.data(), head.size()}); // header last
+
+    std::vector<UndoRecord> undo;
+    for (const auto& w : writes) {
+        if (w.pos >= old_size) continue; // beyond the old end: undone by truncation
+        UndoRecord r;
+        r.pos = w.pos;
+        r.bytes.resize(static_cast<std::size_t>(std::min<std::uint64_t>(w.size, old_size - w.pos)));
+        f.read_at(r.pos, r.bytes.data(), r.bytes.size());
+        undo.push_back(std::move(r));
+    }
+    write_journal(file, old_size, undo);
+
+    for (const auto& w : writes) f.write_at(w.pos, w.data, w.size);
+    f.truncate(hdr.file_size);
+    f.sync();
+
+    const std::filesystem::path jp = journal_path(file);
+    std::filesystem::remove(jp);
+    sync_parent_dir(jp);
+}
+
+void update_var(const std::filesystem::path& file, const std::string& var, const GbfValue& value, const WriteOptions& opts) {
+    check_alignment(opts.alignment);
+    if (var.empty() || var == "<root>") {
+        throw GbfError(ErrorKind::Unsupported, "update_var needs a variable path; use write_file for the root");
+    }
+    recover_file(file);
+
+    auto [hdr, header_len, raw_json] = read_header_only(file, ReadOptions{true});
+    const std::string prefix = var + ".";
+    auto matches = [&](const std::string& name) {
+        return name == var || name.compare(0, prefix.size(), prefix) == 0;
+    };
+
+    std::vector<std::pair<std::string, GbfValue>> leaves;
+    flatten(value, var, leaves);
+
+    int codec_level = 0;
+    const Codec* codec = resolve_codec(opts, codec_level);
+
+    std::vector<PlannedField> planned;
+    planned.reserve(hdr.fields.size() + leaves.size());
+    bool replaced = false;
+    for (const auto& old : hdr.fields) {
+        if (!matches(old.name)) {
+            planned.push_back(kept_field(old, hdr.payload_start));
+            continue;
+        }
+        if (replaced) continue;
+        replaced = true;
+
+        // The new subtree takes the place of the first matching field.
+        for (const auto& kv : leaves) {
+            PlannedField pf;
+            pf.meta.name = kv.first;
+            ByteBuffer data = encode_field(kv.second, pf.meta, opts, codec, codec_level);
+            if (!data.empty()) {
+                PlannedBlob b = new_blob(std::move(data));
+                for (const auto& slot : hdr.fields) {
+                    if (slot.name == kv.first && slot.extents.empty() && slot.csize >= b.size) {
+                        b.mode = PlannedBlob::Mode::InPlace;
+                        b.pos = hdr.payload_start + slot.offset;
+                        break;
+                    }
+                }
+                pf.blobs.push_back(std::move(b));
+            }
+            planned.push_back(std::move(pf));
+        }
+    }
+    if (!replaced) throw GbfError(ErrorKind::NotFound, "variable not found: " + var);
+
+    commit_fields(file, hdr, header_len, std::move(planned), opts);
+}
+
+// A new path may neither equal an existing one nor nest under/over an existing leaf.
+static bool paths_clash(const std::string& a, const std::string& b) {
+    const std::string& s = a.size() < b.size() ? a : b;
+    const std::string& l = a.size() < b.size() ? b : a;
+    return l.compare(0, s.size(), s) == 0 && (l.size() == s.size() || l[s.size()] == '.');
+}
+
+void append_vars(const std::filesystem::path& file, const GbfValue& values, const WriteOptions& opts) {
+    check_alignment(opts.alignment);
+    if (!std::holds_alternative<GbfValue::Struct>(values.v)) {
+        throw GbfError(ErrorKind::InvalidData, "append_vars expects a struct of variables");
+    }
+    recover_file(file);
+
+    auto [hdr, header_len, raw_json] = read_header_only(file, ReadOptions{true});
+
+    std::vector<std::pair<std::string, GbfValue>> leaves;
+    flatten(values, "", leaves);
+
+    for (const auto& kv : leaves) {
+        for (const auto& f : hdr.fields) {
+            if (paths_clash(kv.first, f.name)) {
+                throw GbfError(ErrorKind::InvalidData, "variable already exists: " + f.name);
+            }
+        }
+    }
+
+    int codec_level = 0;
+    const Codec* codec = resolve_codec(opts, codec_level);
+
+    std::vector<PlannedField> planned;
+    planned.reserve(hdr.fields.size() + leaves.size());
+    for (const auto& old : hdr.fields) {
+        planned.push_back(kept_field(old, hdr.payload_start));
+    }
+    for (const auto& kv : leaves) {
+        PlannedField pf;
+        pf.meta.name = kv.first;
+        ByteBuffer data = encode_field(kv.second, pf.meta, opts, codec, codec_level);
+        if (!data.empty()) pf.blobs.push_back(new_blob(std::move(data)));
+        planned.push_back(std::move(pf));
+    }
+
+    commit_fields(file, hdr, header_len, std::move(planned), opts);
+}
+
+void extend_var(const std::filesystem::path& file, const std::string& var, const GbfValue& slice, const WriteOptions& opts) {
+    check_alignment(opts.alignment);
+    recover_file(file);
+
+    auto [hdr, header_len, raw_json] = read_header_only(file, ReadOptions{true});
+    std::size_t idx = hdr.fields.size();
+    for (std::size_t i = 0; i < hdr.fields.size(); ++i) {
+        if (hdr.fields[i].name == var) { idx = i; break; }
+    }
+    if (idx == hdr.fields.size()) throw GbfError(ErrorKind::NotFound, "variable not found: " + var);
+    const FieldMeta& old = hdr.fields[idx];
+    if (!is_extendable_kind(old.kind)) {
+        throw GbfError(ErrorKind::Unsupported, "only numeric, logical, datetime and duration fields can be extended");
+    }
+
+    int codec_level = 0;
+    const Codec* codec = resolve_codec(opts, codec_level);
+    FieldMeta sm;
+    sm.name = var;
+    ByteBuffer data = encode_field(slice, sm, opts, codec, codec_level);
+    if (sm.kind != old.kind || sm.class_name != old.class_name || sm.complex != old.complex ||
+        sm.encoding != old.encoding) {
+        throw GbfError(ErrorKind::InvalidData, "slice type does not match '" + var + "'");
+    }
+    if (sm.shape.size() != old.shape.size() || old.shape.empty() ||
+        !std::equal(old.shape.begin(), old.shape.end() - 1, sm.shape.begin())) {
+        throw GbfError(ErrorKind::InvalidData, "slice shape must match all but the last dimension");
+    }
+    if (const auto* s = std::get_if<DateTimeArray>(&slice.v)) {
+        // Timezone, locale and format live in each payload rather than the header, and reads
+        // keep the first extent's; compare against that one.
+        const FieldMeta first = old.extents.empty() ? old : extent_meta(old, old.extents.front());
+        std::ifstream is(file, std::ios::binary);
+        if (!is) throw GbfError(ErrorKind::Io, "failed to open file: " + file.string());
+        const GbfValue cur = decode_value_bytes(first, read_field_payload(file, is, hdr, first, ReadOptions{true}),
+                                                ReadOptions{true});
+        const auto* d = std::get_if<DateTimeArray>(&cur.v);
+        if (d && (d->timezone != s->timezone || d->locale != s->locale || d->format != s->format)) {
+            throw GbfError(ErrorKind::InvalidData, "slice timezone, locale or format does not match '" + var + "'");
+        }
+    }
+
+    std::vector<PlannedField> planned;
+    planned.reserve(hdr.fields.size());
+    for (std::size_t i = 0; i < hdr.fields.size(); ++i) {
+        PlannedField pf = kept_field(hdr.fields[i], hdr.payload_start);
+        if (i != idx) {
+            planned.push_back(std::move(pf));
+            continue;
+        }
+
+        FieldMeta& meta = pf.meta;
+        if (meta.extents.empty()) {
+            // The existing payload becomes the first extent.
+            FieldExtent e;
+            e.offset = meta.offset;
+            e.csize = meta.csize;
+            e.usize = meta.usize;
+            e.crc32 = meta.crc32;
+            e.compression = meta.compression;
+            e.count = meta.shape.back();
+            meta.extents.push_back(std::move(e));
+            if (pf.blobs.empty()) pf.blobs.push_back(PlannedBlob{});
+        }
+        FieldExtent e;
+        e.csize = sm.csize;
+        e.usize = sm.usize;
+        e.crc32 = sm.crc32;
+        e.compression = sm.compression;
+        e.count = sm.shape.back();
+        meta.extents.push_back(std::move(e));
+        pf.blobs.push_back(new_blob(std::move(data)));
+
+        meta.shape.back() += sm.shape.back();
+        meta.compression = kExtentsCompression;
+        meta.level = -1;
+        meta.crc32 = 0; // per-extent CRCs
+        meta.csize = 0;
+        meta.usize = 0;
+        for (const auto& x : meta.extents) {
+            meta.csize += x.csize;
+            meta.usize += x.usize;
+        }
+        planned.push_back(std::move(pf));
+    }
+
+    commit_fields(file, hdr, header_len, std::move(planned), opts);
+}
+
+void compact_file(const std::filesystem::path& file, const WriteOptions& opts) {
+    check_alignment(opts.alignment);
+    recover_file(file);
+
+    auto [hdr, header_len, raw_json] = read_header_only(file, ReadOptions{true});
+    const std::uint64_t old_payload_start = hdr.payload_start;
+    std::vector<std::uint64_t> src;
+    src.reserve(hdr.fields.size());
+    // Locates the merged fields' old extents once `hdr` describes the new layout.
+    Header stored;
+    stored.payload_start = hdr.payload_start;
+    stored.file_size = hdr.file_size;
+
+    // Extended fields are merged into one payload (re-encoded with `opts`); the rest are
+    // copied as stored. Merged payloads are encoded here only for their sizes and again in the
+    // copy loop, so at most one of them is held in memory.
+    int codec_level = 0;
+    const Codec* codec = resolve_codec(opts, codec_level);
+    std::map<std::size_t, FieldMeta> extended;
+    {
+        std::ifstream is(file, std::ios::binary);
+        if (!is) throw GbfError(ErrorKind::Io, "failed to open file: " + file.string());
+        for (std::size_t i = 0; i < hdr.fields.size(); ++i) {
+            FieldMeta& meta = hdr.fields[i];
+            if (meta.extents.empty()) continue;
+            FieldMeta m;
+            m.name = meta.name;
+            encode_field(read_field_value(file, is, hdr, meta, ReadOptions{true}), m, opts, codec, codec_level);
+            extended[i] = std::exchange(meta, std::move(m));
+        }
+    }
+
+    std::uint64_t payload_off = 0;
+    for (auto& meta : hdr.fields) {
+        src.push_back(old_payload_start + meta.offset);
+        if (meta.csize == 0) {
+            meta.offset = 0;
+            continue;
+        }
+        payload_off = align_up(payload_off, opts.alignment);
+        meta.offset = payload_off;
+        payload_off += meta.csize;
+    }
+    hdr.field_index.reset();
+    std::vector<std::uint8_t> index;
+    if (opts.field_index) index = attach_field_index(hdr, payload_off);
+    const std::vector<std::uint8_t> head = header_block(hdr, finalize_header(hdr, payload_off, opts));
+
+    std::filesystem::path tmp = file;
+    tmp += ".compact.tmp";
+    {
+        RawFile in(file, /*writable=*/false);
+        RawFile out(tmp, /*writable=*/true, /*create=*/true);
+
+        out.write_at(0, head.data(), head.size());
+
+        ByteBuffer buf = ByteBuffer::uninitialized(std::size_t{4} << 20);
+        std::ifstream is;
+        if (!extended.empty()) is.open(file, std::ios::binary);
+        for (std::size_t i = 0; i < hdr.fields.size(); ++i) {
+            const FieldMeta& meta = hdr.fields[i];
+            const std::uint64_t dst = hdr.payload_start + meta.offset;
+            auto x = extended.find(i);
+            if (x != extended.end()) {
+                FieldMeta m;
+                m.name = meta.name;
+                const ByteBuffer data = encode_field(read_field_value(file, is, stored, x->second, ReadOptions{true}),
+                                                     m, opts, codec, codec_level);
+                if (m.csize != meta.csize || m.crc32 != meta.crc32) {
+                    throw GbfError(ErrorKind::InvalidData, "re-encoding '" + meta.name + "' is not deterministic");
+                }
+                out.write_at(dst, data.data(), data.size());
+                continue;
+            }
+            for (std::uint64_t done = 0; done < meta.csize;) {
+                const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(buf.size(), meta.csize - done));
+                in.read_at(src[i] + done, buf.data(), n);
+                out.write_at(dst + done, buf.data(), n);
+                done += n;
+            }
+        }
+        if (!index.empty()) out.write_at(hdr.payload_start + hdr.field_index->offset, index.data(), index.size());
+        out.truncate(hdr.file_size);
+        out.sync();
+    }
+    std::filesystem::rename(tmp, file);
+    sync_parent_dir(file);
+}
+
+// ------------------------------
+// Write-in-place
+// ------------------------------
+
+namespace {
+
+// Header region of a Writer before anything is known about the fields.
+constexpr std::size_t kWriterHeaderRegion = 4096;
+
+// Field starts are at least cache-line aligned so the spans handed out suit any element type.
+constexpr std::size_t kWriterMinAlign = 64;
+
+// A reserved field: mapped file pages on POSIX, a staging buffer elsewhere.
+struct ReservedRegion {
+    std::size_t field{0};       // index into Writer::Impl::fields
+    std::uint8_t* data{nullptr};
+    std::size_t bytes{0};
+    std::size_t elem{1};        // element size; the span holds host-order elements
+#if defined(_WIN32)
+    std::vector<std::uint8_t> buffer{};
+#else
+    void* map_base{nullptr};
+    std::size_t map_len{0};
+#endif
+};
+
+} // namespace
+
+struct Writer::Impl {
+    std::filesystem::path path;
+    WriteOptions opts;
+    RawFile file;
+    std::size_t align{kWriterMinAlign};
+    std::uint64_t region{0};      // header_len the payload is currently laid out for
+    std::uint64_t payload_end{0}; // relative to payload_start
+    std::vector<FieldMeta> fields{};
+    std::vector<ReservedRegion> reserved{};
+    const Codec* codec{nullptr};
+    int codec_level{0};
+    bool done{false};
+
+    Impl(const std::filesystem::path& p, const WriteOptions& o)
+        : path(p), opts(o), file(p, /*writable=*/true, /*create=*/true) {
+        align = std::max<std::size_t>(kWriterMinAlign, opts.alignment);
+        // 12 + region is a multiple of `align`, so aligned payload offsets are aligned in the file.
+        region = align_up(12 + std::max(opts.header_reserve, kWriterHeaderRegion), align) - 12;
+        codec = resolve_codec(opts, codec_level);
+    }
+
+    std::uint64_t payload_start() const { return 12 + region; }
+
+    void check_name(const std::string& name) const {
+        if (done) throw GbfError(ErrorKind::InvalidData, "writer already committed");
+        if (name.empty() || name == "<root>") throw GbfError(ErrorKind::InvalidData, "writer fields need a variable path");
+        for (const auto& f : fields) {
+            if (paths_clash(name, f.name)) throw GbfError(ErrorKind::InvalidData, "variable already exists: " + f.name);
+        }
+    }
+
+    // Next aligned payload offset for `bytes`, extending the file to cover it.
+    std::uint64_t allocate(std::uint64_t bytes) {
+        const std::uint64_t off = align_up(payload_end, align);
+        payload_end = off + bytes;
+        const std::uint64_t abs = payload_start() + off;
+#if !defined(_WIN32)
+        if (bytes > 0) {
+            int rc = ::posix_fallocate(file.fd(), static_cast<off_t>(abs), static_cast<off_t>(bytes));
+            if (rc != 0) {
+                // No preallocation on this filesystem: a sparse extension serves the mapping.
+                if (rc != EINVAL && rc != EOPNOTSUPP) {
+                    throw GbfError(ErrorKind::Io, "fallocate failed on " + path.string() + ": " + std::strerror(rc));
+                }
+                if (file.size() < abs + bytes) file.truncate(abs + bytes);
+            }
+        }
+#else
+        (void)abs;
+#endif
+        return off;
+    }
+
+    void release_regions() {
+#if !defined(_WIN32)
+        for (auto& r : reserved) {
+            if (r.map_base) ::munmap(r.map_base, r.map_len);
+            r.map_base = nullptr;
+        }
+#endif
+        reserved.clear();
+    }
+
+    // Move [payload_start, payload_start + payload_end) to start at 12 + new_region.
+    void grow_region(std::uint64_t new_region) {
+        const std::uint64_t from = payload_start();
+        const std::uint64_t to = 12 + new_region;
+        ByteBuffer buf = ByteBuffer::uninitialized(static_cast<std::size_t>(std::min<std::uint64_t>(payload_end, 4u << 20)));
+        for (std::uint64_t left = payload_end; left > 0;) {
+            const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(buf.size(), left));
+            left -= n;
+            file.read_at(from + left, buf.data(), n);
+            file.write_at(to + left, buf.data(), n);
+        }
+        region = new_region;
+    }
+};
+
+Writer::Writer(const std::filesystem::path& file, const WriteOptions& opts) {
+    check_alignment(opts.alignment);
+    impl_ = std::make_unique<Impl>(file, opts);
+}
+
+Writer::~Writer() {
+    if (!impl_ || impl_->done) return;
+    impl_->release_regions();
+    std::error_code ec;
+    std::filesystem::remove(impl_->path, ec);
+}
+
+Writer::Writer(Writer&&) noexcept = default;
+Writer& Writer::operator=(Writer&&) noexcept = default;
+
+void* Writer::reserve_raw(
+    const std::string& name,
+    NumericClass class_id,
+    NumericClass elem_class,
+    const std::vector<std::size_t>& shape,
+    std::size_t& count
+) {
+    Impl& w = *impl_;
+    w.check_name(name);
+    if (class_id == NumericClass::Unknown || elem_class != class_id) {
+        throw GbfError(ErrorKind::InvalidData, "element type does not match class " + to_string(class_id));
+    }
+    count = numel(shape);
+    std::size_t bytes = 0;
+    if (!checked_mul_size(count, bytes_per_elem(class_id), bytes)) {
+        throw GbfError(ErrorKind::InvalidData, "numeric size overflow");
+    }
+
+    FieldMeta meta;
+    meta.name = name;
+    NumericArray proto;
+    proto.class_id = class_id;
+    proto.shape = shape;
+    describe_value(GbfValue::make_numeric(proto), meta);
+    meta.compression = "none";
+    meta.csize = bytes;
+    meta.usize = bytes;
+    meta.offset = bytes > 0 ? w.allocate(bytes) : 0;
+
+    ReservedRegion r;
+    r.field = w.fields.size();
+    r.bytes = bytes;
+    r.elem = bytes_per_elem(class_id);
+    if (bytes > 0) {
+#if defined(_WIN32)
+        r.buffer.assign(bytes, 0);
+        r.data = r.buffer.data();
+#else
+        static const std::uint64_t page = static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+        const std::uint64_t abs = w.payload_start() + meta.offset;
+        const std::uint64_t map_off = abs & ~(page - 1);
+        r.map_len = static_cast<std::size_t>(abs + bytes - map_off);
+        void* base = ::mmap(nullptr, r.map_len, PROT_READ | PROT_WRITE, MAP_SHARED, w.file.fd(), static_cast<off_t>(map_off));
+        if (base == MAP_FAILED) {
+            throw GbfError(ErrorKind::Io, "mmap failed on " + w.path.string() + ": " + std::strerror(errno));
+        }
+        r.map_base = base;
+        r.data = static_cast<std::uint8_t*>(base) + (abs - map_off);
+#endif
+    }
+    w.fields.push_back(std::move(meta));
+    w.reserved.push_back(std::move(r));
+    return w.reserved.back().data;
+}
+
+void Writer::put(const std::string& name, const GbfValue& value) {
+    Impl& w = *impl_;
+    w.check_name(name);
+    FieldMeta meta;
+    meta.name = name;
+    const ByteBuffer stored = encode_field(value, meta, w.opts, w.codec, w.codec_level);
+    meta.offset = stored.empty() ? 0 : w.allocate(stored.size());
+    if (!stored.empty()) w.file.write_at(w.payload_start() + meta.offset, stored.data(), stored.size());
+    w.fields.push_back(std::move(meta));
+}
+
+void Writer::commit() {
+    Impl& w = *impl_;
+    if (w.done) throw GbfError(ErrorKind::InvalidData, "writer already committed");
+
+    for (auto& r : w.reserved) {
+        FieldMeta& meta = w.fields[r.field];
+        if constexpr (!kHostLittleEndian) byteswap_inplace(r.data, r.elem, r.bytes / r.elem);
+        if (w.opts.include_crc32 && r.bytes > 0) meta.crc32 = crc32_bytes(r.data, r.bytes);
+#if defined(_WIN32)
+        if (r.bytes > 0) w.file.write_at(w.payload_start() + meta.offset, r.data, r.bytes);
+#endif
+    }
+    w.release_regions();
+
+    Header hdr = new_header();
+    hdr.fields = w.fields;
+    std::string header_json;
+    HeaderSlots slots;
+    for (int iter = 0;; ++iter) {
+        if (iter == 8) throw GbfError(ErrorKind::InvalidData, "could not settle header layout");
+        hdr.payload_start = w.payload_start();
+        hdr.file_size = hdr.payload_start + w.payload_end;
+        header_json = emit_header(hdr, slots, /*layout_holes=*/false);
+        if (header_json.size() <= w.region) break;
+        if (header_json.size() > kMaxHeaderLen) throw GbfError(ErrorKind::InvalidData, "header too large");
+        w.grow_region(align_up(12 + header_json.size() + header_json.size() / 4, w.align) - 12);
+    }
+
+    header_json.resize(static_cast<std::size_t>(w.region), ' ');
+    seal_header_crc(header_json, slots.crc, hdr);
+
+    const std::vector<std::uint8_t> head = header_block(hdr, header_json);
+    w.file.write_at(0, head.data(), head.size());
+    w.file.truncate(hdr.file_size);
+    w.done = true;
+}
+
+// ------------------------------
+// Parallel positional write
+// ------------------------------
+
+static void write_file_parallel(
+    const std::filesystem::path& file,
+    const std::vector<std::pair<std::string, GbfValue>>& leaves,
+    Header& hdr,
+    const Codec* codec,
+    int codec_level,
+    const WriteOptions& opts
+) {
+    // 1. Encode (and compress) every field; sizes fix the layout.
+    hdr.fields.assign(leaves.size(), FieldMeta{});
+    std::vector<ByteBuffer> stored(leaves.size());
+    parallel_for(leaves.size(), opts.write_threads, [&](std::size_t i) {
+        hdr.fields[i].name = leaves[i].first;
+        stored[i] = encode_field(leaves[i].second, hdr.fields[i], opts, codec, codec_level);
+    });
+
+    std::uint64_t payload_off = 0;
+    for (auto& meta : hdr.fields) {
+        if (meta.csize == 0) {
+            meta.offset = 0;
+            continue;
+        }
+        payload_off = align_up(payload_off, opts.alignment);
+        meta.offset = payload_off;
+        payload_off += meta.csize;
+    }
+    std::vector<std::uint8_t> index;
+    if (opts.field_index) index = attach_field_index(hdr, payload_off);
+    const std::vector<std::uint8_t> head = header_block(hdr, finalize_header(hdr, payload_off, opts));
+
+    // 2. Preallocate; alignment gaps read back as zeros.
+    RawFile out(file, /*writable=*/true, /*create=*/true);
+#if !defined(_WIN32)
+    if (hdr.file_size > 0) {
+        int rc = ::posix_fallocate(out.fd(), 0, static_cast<off_t>(hdr.file_size));
+        if (rc != 0 && rc != EINVAL && rc != EOPNOTSUPP) {
+            throw GbfError(ErrorKind::Io, "fallocate failed on " + file.string() + ": " + std::strerror(rc));
+        }
+    }
+#endif
+    out.truncate(hdr.file_size);
+
+    // 3. Every field to its own offset, concurrently (Windows lacks a positional write on
+    // CRT descriptors, so it writes them in turn); the header goes last.
+#if defined(_WIN32)
+    const unsigned io_threads = 1;
+#else
+    const unsigned io_threads = opts.write_threads;
+#endif
+    parallel_for(stored.size(), io_threads, [&](std::size_t i) {
+        if (!stored[i].empty()) out.write_at(hdr.payload_start + hdr.fields[i].offset, stored[i].data(), stored[i].size());
+    });
+    if (!index.empty()) out.write_at(hdr.payload_start + hdr.field_index->offset, index.data(), index.size());
+    out.write_at(0, head.data(), head.size());
+}
+
 } // namespace gbin
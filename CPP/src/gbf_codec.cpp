@@ -0,0 +1,174 @@
+
+#include "gbin/gbf.hpp"
+
+#include <climits>
+#include <mutex>
+
+#include <zlib.h>
+
+#if defined(GBIN_HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+#if defined(GBIN_HAVE_LZ4)
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
+namespace gbin {
+
+// ------------------------------
+// Built-in codecs
+// ------------------------------
+
+static Codec make_zlib_codec() {
+    Codec c;
+    c.name = "zlib";
+    c.bound = [](std::size_t n) {
+        return static_cast<std::size_t>(::compressBound(static_cast<uLong>(n)));
+    };
+    c.compress = [](const std::uint8_t* in, std::size_t n, std::uint8_t* out, std::size_t cap, int level) {
+        uLongf out_len = static_cast<uLongf>(cap);
+        int rc = ::compress2(reinterpret_cast<Bytef*>(out), &out_len,
+                             reinterpret_cast<const Bytef*>(in), static_cast<uLong>(n), level);
+        if (rc != Z_OK) {
+            throw GbfError(ErrorKind::ZlibError, "zlib compress2 failed");
+        }
+        return static_cast<std::size_t>(out_len);
+    };
+    c.decompress = [](const std::uint8_t* in, std::size_t n, std::uint8_t* out, std::size_t usize) {
+        uLongf out_len = static_cast<uLongf>(usize);
+        int rc = ::uncompress(reinterpret_cast<Bytef*>(out), &out_len,
+                              reinterpret_cast<const Bytef*>(in), static_cast<uLong>(n));
+        if (rc != Z_OK || static_cast<std::size_t>(out_len) != usize) {
+            throw GbfError(ErrorKind::ZlibError, "zlib uncompress failed");
+        }
+    };
+    return c;
+}
+
+#if defined(GBIN_HAVE_ZSTD)
+static Codec make_zstd_codec() {
+    Codec c;
+    c.name = "zstd";
+    c.bound = [](std::size_t n) { return ZSTD_compressBound(n); };
+    c.compress = [](const std::uint8_t* in, std::size_t n, std::uint8_t* out, std::size_t cap, int level) {
+        std::size_t rc = ZSTD_compress(out, cap, in, n, level);
+        if (ZSTD_isError(rc)) {
+            throw GbfError(ErrorKind::CodecError, std::string("zstd compress failed: ") + ZSTD_getErrorName(rc));
+        }
+        return rc;
+    };
+    c.decompress = [](const std::uint8_t* in, std::size_t n, std::uint8_t* out, std::size_t usize) {
+        std::size_t rc = ZSTD_decompress(out, usize, in, n);
+        if (ZSTD_isError(rc) || rc != usize) {
+            throw GbfError(ErrorKind::CodecError, "zstd decompress failed");
+        }
+    };
+    return c;
+}
+#endif
+
+#if defined(GBIN_HAVE_LZ4)
+static Codec make_lz4_codec() {
+    Codec c;
+    c.name = "lz4";
+    c.bound = [](std::size_t n) -> std::size_t {
+        if (n > static_cast<std::size_t>(LZ4_MAX_INPUT_SIZE)) {
+            throw GbfError(ErrorKind::Unsupported, "lz4: field larger than LZ4_MAX_INPUT_SIZE");
+        }
+        return static_cast<std::size_t>(LZ4_compressBound(static_cast<int>(n)));
+    };
+    c.compress = [](const std::uint8_t* in, std::size_t n, std::uint8_t* out, std::size_t cap, int level) {
+        const int icap = cap > static_cast<std::size_t>(INT_MAX) ? INT_MAX : static_cast<int>(cap);
+        const char* src = reinterpret_cast<const char*>(in);
+        char* dst = reinterpret_cast<char*>(out);
+        int rc = (level > 0)
+            ? LZ4_compress_HC(src, dst, static_cast<int>(n), icap, level)
+            : LZ4_compress_default(src, dst, static_cast<int>(n), icap);
+        if (rc <= 0) {
+            throw GbfError(ErrorKind::CodecError, "lz4 compress failed");
+        }
+        return static_cast<std::size_t>(rc);
+    };
+    c.decompress = [](const std::uint8_t* in, std::size_t n, std::uint8_t* out, std::size_t usize) {
+        if (n > static_cast<std::size_t>(INT_MAX) || usize > static_cast<std::size_t>(INT_MAX)) {
+            throw GbfError(ErrorKind::CodecError, "lz4 decompress: block too large");
+        }
+        int rc = LZ4_decompress_safe(reinterpret_cast<const char*>(in), reinterpret_cast<char*>(out),
+                                     static_cast<int>(n), static_cast<int>(usize));
+        if (rc < 0 || static_cast<std::size_t>(rc) != usize) {
+            throw GbfError(ErrorKind::CodecError, "lz4 decompress failed");
+        }
+    };
+    return c;
+}
+#endif
+
+// ------------------------------
+// Registry
+// ------------------------------
+
+namespace {
+
+struct CodecRegistry {
+    std::mutex mu;
+    // std::map keeps element addresses stable, so find_codec() can hand out pointers.
+    std::map<std::string, Codec> codecs;
+
+    CodecRegistry() {
+        add(make_zlib_codec());
+#if defined(GBIN_HAVE_ZSTD)
+        add(make_zstd_codec());
+#endif
+#if defined(GBIN_HAVE_LZ4)
+        add(make_lz4_codec());
+#endif
+    }
+
+    // Entries are never replaced: another thread may be inside a pointer from find_codec().
+    void add(Codec c) {
+        if (codecs.count(c.name) != 0) {
+            throw GbfError(ErrorKind::Unsupported, "codec '" + c.name + "' is already registered");
+        }
+        std::string key = c.name;
+        codecs.emplace(std::move(key), std::move(c));
+    }
+};
+
+CodecRegistry& registry() {
+    static CodecRegistry r;
+    return r;
+}
+
+} // namespace
+
+void register_codec(Codec codec) {
+    if (codec.name.empty() || codec.name == "none" || codec.name == "extents") {
+        throw GbfError(ErrorKind::Unsupported, "invalid codec name: '" + codec.name + "'");
+    }
+    if (!codec.bound || !codec.compress || !codec.decompress) {
+        throw GbfError(ErrorKind::Unsupported, "codec '" + codec.name + "' is missing functions");
+    }
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    r.add(std::move(codec));
+}
+
+const Codec* find_codec(const std::string& name) {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    auto it = r.codecs.find(name);
+    return it == r.codecs.end() ? nullptr : &it->second;
+}
+
+std::vector<std::string> codec_names() {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    std::vector<std::string> out;
+    out.reserve(r.codecs.size());
+    for (const auto& kv : r.codecs) out.push_back(kv.first);
+    return out;
+}
+
+} // namespace gbin
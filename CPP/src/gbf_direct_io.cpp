@@ -0,0 +1,246 @@
+
+#include "gbf_direct_io.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define GBIN_HAVE_O_DIRECT 1
+#endif
+
+namespace gbin {
+namespace detail {
+
+#if defined(GBIN_HAVE_O_DIRECT)
+
+namespace {
+
+// Offsets, lengths and buffers must be multiples of the logical block size; 4 KiB covers
+// both 512e and 4Kn devices.
+constexpr std::size_t kBlockAlign = 4096;
+
+// Thrown from inside a transfer when the kernel rejects O_DIRECT, to trigger the fallback.
+struct DirectUnsupported {};
+
+struct FreeDeleter {
+    void operator()(std::uint8_t* p) const { std::free(p); }
+};
+using AlignedBuffer = std::unique_ptr<std::uint8_t, FreeDeleter>;
+
+AlignedBuffer alloc_aligned(std::size_t n) {
+    void* p = nullptr;
+    if (::posix_memalign(&p, kBlockAlign, n) != 0) throw std::bad_alloc();
+    return AlignedBuffer(static_cast<std::uint8_t*>(p));
+}
+
+class FileDescriptor {
+public:
+    explicit FileDescriptor(int fd) : fd_(fd) {}
+    ~FileDescriptor() { if (fd_ >= 0) ::close(fd_); }
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+    int get() const { return fd_; }
+
+private:
+    int fd_;
+};
+
+bool is_unsupported(int e) {
+    return e == EINVAL || e == EOPNOTSUPP || e == ENOTSUP;
+}
+
+std::uint64_t align_up_block(std::uint64_t v) {
+    return (v + kBlockAlign - 1) & ~static_cast<std::uint64_t>(kBlockAlign - 1);
+}
+
+std::size_t io_block_size(const DirectIoOptions& opts) {
+    std::size_t b = std::max(opts.block_bytes, kBlockAlign);
+    return b & ~(kBlockAlign - 1);
+}
+
+// Returns bytes read; fewer than `len` only at end of file.
+std::size_t pread_full(int fd, std::uint8_t* buf, std::size_t len, std::uint64_t off) {
+    std::size_t done = 0;
+    while (done < len) {
+        ssize_t r = ::pread(fd, buf + done, len - done, static_cast<off_t>(off + done));
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            if (is_unsupported(errno)) throw DirectUnsupported{};
+            throw GbfError(ErrorKind::Io, std::string("direct read failed: ") + std::strerror(errno));
+        }
+        if (r == 0) break;
+        done += static_cast<std::size_t>(r);
+    }
+    return done;
+}
+
+void pwrite_full(int fd, const std::uint8_t* buf, std::size_t len, std::uint64_t off) {
+    std::size_t done = 0;
+    while (done < len) {
+        ssize_t r = ::pwrite(fd, buf + done, len - done, static_cast<off_t>(off + done));
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            if (is_unsupported(errno)) throw DirectUnsupported{};
+            throw GbfError(ErrorKind::Io, std::string("direct write failed: ") + std::strerror(errno));
+        }
+        if (r == 0) throw GbfError(ErrorKind::Io, "direct write made no progress");
+        done += static_cast<std::size_t>(r);
+    }
+}
+
+// Run job(block_index, bounce_buffer) for every block on up to `queue_depth` threads; each
+// thread owns one aligned bounce buffer. The first exception stops the rest and is rethrown.
+template <class Job>
+void run_blocks(std::size_t nblocks, std::size_t block, unsigned queue_depth, Job job) {
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool> stop{false};
+    std::exception_ptr error;
+    std::mutex error_mu;
+
+    auto worker = [&]() {
+        try {
+            AlignedBuffer buf = alloc_aligned(block);
+            while (!stop.load(std::memory_order_relaxed)) {
+                const std::size_t i = next.fetch_add(1);
+                if (i >= nblocks) return;
+                job(i, buf.get());
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mu);
+            if (!error) error = std::current_exception();
+            stop = true;
+        }
+    };
+
+    const std::size_t nthreads = std::min<std::size_t>(std::max(queue_depth, 1u), nblocks);
+    std::vector<std::thread> pool;
+    pool.reserve(nthreads > 0 ? nthreads - 1 : 0);
+    for (std::size_t t = 1; t < nthreads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+    if (error) std::rethrow_exception(error);
+}
+
+// Copy logical bytes [off, off + n) of the concatenated parts into dst.
+void gather(const std::vector<ConstBytes>& parts, std::uint64_t off, std::uint8_t* dst, std::size_t n) {
+    std::uint64_t base = 0;
+    for (const auto& p : parts) {
+        const std::uint64_t lo = std::max(off, base);
+        const std::uint64_t hi = std::min(off + n, base + p.size);
+        if (hi > lo) {
+            std::memcpy(dst + (lo - off), p.data + (lo - base), static_cast<std::size_t>(hi - lo));
+        }
+        base += p.size;
+        if (base >= off + n) break;
+    }
+}
+
+} // namespace
+
+bool direct_read(
+    const std::filesystem::path& file,
+    std::uint64_t pos,
+    std::uint8_t* out,
+    std::size_t n,
+    const DirectIoOptions& opts
+) {
+    if (n == 0) return true;
+
+    int fd = ::open(file.c_str(), O_RDONLY | O_DIRECT | O_CLOEXEC);
+    if (fd < 0) {
+        if (is_unsupported(errno)) return false;
+        throw GbfError(ErrorKind::Io, "failed to open file: " + file.string());
+    }
+    FileDescriptor guard(fd);
+
+    const std::uint64_t want_end = pos + n;
+    const std::uint64_t start = pos & ~static_cast<std::uint64_t>(kBlockAlign - 1);
+    const std::uint64_t end = align_up_block(want_end);
+    const std::size_t block = io_block_size(opts);
+    const std::size_t nblocks = static_cast<std::size_t>((end - start + block - 1) / block);
+
+    try {
+        run_blocks(nblocks, block, opts.queue_depth, [&](std::size_t i, std::uint8_t* buf) {
+            const std::uint64_t off = start + static_cast<std::uint64_t>(i) * block;
+            const std::size_t len = static_cast<std::size_t>(std::min<std::uint64_t>(block, end - off));
+            const std::size_t got = pread_full(fd, buf, len, off);
+
+            const std::uint64_t lo = std::max(off, pos);
+            const std::uint64_t hi = std::min(off + got, want_end);
+            if (std::min(off + len, want_end) > hi) {
+                throw GbfError(ErrorKind::Truncated, "unexpected EOF reading field payload");
+            }
+            if (hi > lo) {
+                std::memcpy(out + (lo - pos), buf + (lo - off), static_cast<std::size_t>(hi - lo));
+            }
+        });
+    } catch (const DirectUnsupported&) {
+        return false;
+    }
+    return true;
+}
+
+bool direct_write(
+    const std::filesystem::path& file,
+    const std::vector<ConstBytes>& parts,
+    const DirectIoOptions& opts
+) {
+    std::uint64_t total = 0;
+    for (const auto& p : parts) total += p.size;
+
+    int fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        if (is_unsupported(errno)) return false;
+        throw GbfError(ErrorKind::Io, "failed to open for write: " + file.string());
+    }
+    FileDescriptor guard(fd);
+
+    // The last block is zero-padded to the block size and the file trimmed afterwards.
+    const std::uint64_t end = align_up_block(total);
+    const std::size_t block = io_block_size(opts);
+    const std::size_t nblocks = static_cast<std::size_t>((end + block - 1) / block);
+
+    try {
+        run_blocks(nblocks, block, opts.queue_depth, [&](std::size_t i, std::uint8_t* buf) {
+            const std::uint64_t off = static_cast<std::uint64_t>(i) * block;
+            const std::size_t len = static_cast<std::size_t>(std::min<std::uint64_t>(block, end - off));
+            const std::size_t data = static_cast<std::size_t>(std::min<std::uint64_t>(len, total - off));
+            gather(parts, off, buf, data);
+            std::memset(buf + data, 0, len - data);
+            pwrite_full(fd, buf, len, off);
+        });
+    } catch (const DirectUnsupported&) {
+        return false;
+    }
+
+    if (::ftruncate(fd, static_cast<off_t>(total)) != 0) {
+        throw GbfError(ErrorKind::Io, std::string("ftruncate failed: ") + std::strerror(errno));
+    }
+    return true;
+}
+
+#else // !GBIN_HAVE_O_DIRECT
+
+bool direct_read(const std::filesystem::path&, std::uint64_t, std::uint8_t*, std::size_t, const DirectIoOptions&) {
+    return false;
+}
+
+bool direct_write(const std::filesystem::path&, const std::vector<ConstBytes>&, const DirectIoOptions&) {
+    return false;
+}
+
+#endif
+
+} // namespace detail
+} // namespace gbin
@@ -0,0 +1,42 @@
+
+#pragma once
+
+// Internal: page-cache-bypassing file I/O used by read_file/write_file when
+// ReadOptions/WriteOptions::direct_io is enabled. Not part of the public API.
+
+#include "gbin/gbf.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace gbin {
+namespace detail {
+
+struct ConstBytes {
+    const std::uint8_t* data{nullptr};
+    std::size_t size{0};
+};
+
+/// Read `n` bytes at `pos` into `out` with O_DIRECT. Returns false (nothing read) when direct
+/// I/O is unavailable for this file/filesystem so the caller can fall back to buffered reads.
+/// Throws GbfError on real I/O errors or when the file is shorter than requested.
+bool direct_read(
+    const std::filesystem::path& file,
+    std::uint64_t pos,
+    std::uint8_t* out,
+    std::size_t n,
+    const DirectIoOptions& opts
+);
+
+/// Create/truncate `file` and write the concatenation of `parts` with O_DIRECT.
+/// Returns false when direct I/O is unavailable (the file may have been truncated).
+bool direct_write(
+    const std::filesystem::path& file,
+    const std::vector<ConstBytes>& parts,
+    const DirectIoOptions& opts
+);
+
+} // namespace detail
+} // namespace gbin
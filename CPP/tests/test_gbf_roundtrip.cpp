@@ -1,6 +1,8 @@
 
 #include "gbin/gbf.hpp"
+#include "gbin/gbf_easy.hpp"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <filesystem>
@@ -11,6 +13,8 @@
 #include <string>
 #include <vector>
 
+#include <zlib.h>
+
 
 
 #define CHECK(cond) do { \
@@ -193,6 +197,101 @@ int main() {
         CHECK(m.find("s") != m.end());
     }
 
+    // Field kinds are parsed to enums and metadata strings are interned; unknown kinds and
+    // classes survive a round trip as opaque values.
+    {
+        gbin::OpaqueValue o;
+        o.kind = "mystery";
+        o.class_name = "Mystery";
+        o.shape = {1, 3};
+        o.encoding = "raw";
+        o.bytes = {1, 2, 3};
+        gbin::GbfValue::Struct m = root.as_struct();
+        m["odd"] = gbin::GbfValue::make_opaque(o);
+        m["A2"] = m.at("A");
+        for (bool index : {false, true}) {
+            gbin::WriteOptions wo;
+            wo.field_index = index;
+            gbin::write_file(tmp, gbin::GbfValue::make_struct(m), wo);
+
+            auto [hdr, hlen, raw] = gbin::read_header_only(tmp, gbin::ReadOptions{true});
+            std::map<std::string, const gbin::FieldMeta*> by_name;
+            for (const auto& f : hdr.fields) by_name[f.name] = &f;
+            CHECK(by_name.at("A")->kind == gbin::FieldKind::Numeric && by_name.at("A")->class_id == gbin::NumericClass::Double);
+            CHECK(by_name.at("cat")->kind == gbin::FieldKind::Categorical && by_name.at("cat")->kind_str() == "categorical");
+            CHECK(by_name.at("odd")->kind == gbin::FieldKind::Unknown && by_name.at("odd")->kind_str() == "mystery");
+            CHECK(by_name.at("A")->class_name == by_name.at("A2")->class_name);
+            CHECK(by_name.at("A")->class_name.c_str() == by_name.at("A2")->class_name.c_str());
+            CHECK(raw.find("\"kind\":\"mystery\"") != std::string::npos);
+
+            const gbin::GbfValue back = gbin::read_var(tmp, "odd", gbin::ReadOptions{true});
+            const auto& ob = std::get<gbin::OpaqueValue>(back.v);
+            CHECK(ob.kind == "mystery" && ob.class_name == "Mystery" && ob.encoding == "raw" && ob.bytes == o.bytes);
+        }
+        CHECK(gbin::field_kind_from_string("calendarduration") == gbin::FieldKind::CalendarDuration);
+        CHECK(gbin::to_string(gbin::FieldKind::DateTime) == "datetime");
+
+        // Only the format's vocabulary and registered codec names are shared; other strings
+        // are owned per value, so untrusted headers cannot grow a process-wide pool.
+        const gbin::InternedString zlib1("zlib"), zlib2(std::string("zlib"));
+        CHECK(zlib1.c_str() == zlib2.c_str() && zlib1.c_str() == gbin::find_codec("zlib")->name.c_str());
+        CHECK(gbin::InternedString("utf-8").c_str() == gbin::InternedString("utf-8").c_str());
+        const gbin::InternedString raw1("raw"), raw2("raw");
+        CHECK(raw1 == raw2 && raw1.c_str() != raw2.c_str());
+        gbin::InternedString raw3 = raw1;
+        CHECK(raw3 == raw1 && raw3 != zlib1);
+        gbin::InternedString moved = std::move(raw3);
+        CHECK(moved == "raw" && raw3.empty() && gbin::InternedString() == gbin::InternedString(""));
+    }
+
+    // Columnar field table: same fields as Header::fields, with or without the field index.
+    {
+        auto same = [](const gbin::FieldMeta& a, const gbin::FieldMeta& b) {
+            bool ext = a.extents.size() == b.extents.size();
+            for (std::size_t k = 0; ext && k < a.extents.size(); ++k) {
+                ext = a.extents[k].offset == b.extents[k].offset && a.extents[k].compression == b.extents[k].compression;
+            }
+            return ext && a.name == b.name && a.kind == b.kind && a.kind_str() == b.kind_str() &&
+                   a.class_name == b.class_name && a.class_id == b.class_id && a.shape == b.shape &&
+                   a.complex == b.complex && a.encoding == b.encoding && a.compression == b.compression &&
+                   a.offset == b.offset && a.csize == b.csize && a.usize == b.usize && a.crc32 == b.crc32 &&
+                   a.level == b.level;
+        };
+        for (bool index : {false, true}) {
+            gbin::WriteOptions wo;
+            wo.field_index = index;
+            gbin::write_file(tmp, root, wo);
+
+            auto [hdr, hlen, raw] = gbin::read_header_only(tmp, gbin::ReadOptions{true});
+            auto [thdr, table] = gbin::read_header_table(tmp, gbin::ReadOptions{true});
+            CHECK(thdr.fields.empty() && thdr.payload_start == hdr.payload_start);
+            CHECK(table.size() == hdr.fields.size());
+            std::uint64_t csum = 0;
+            for (std::size_t i = 0; i < table.size(); ++i) {
+                CHECK(same(table.meta(i), hdr.fields[i]));
+                CHECK(table.name(i) == hdr.fields[i].name && table.shape(i).size() == hdr.fields[i].shape.size());
+                csum += hdr.fields[i].csize;
+            }
+            std::uint64_t tsum = 0;
+            for (auto c : table.csizes()) tsum += c;
+            CHECK(tsum == csum);
+        }
+
+        gbin::FieldMeta odd;
+        odd.name = "x.odd";
+        odd.kind_name = "mystery";
+        odd.shape = {2, 2};
+        odd.extents.resize(2);
+        odd.extents[1].offset = 7;
+        gbin::FieldMeta plain;
+        plain.name = "x.A";
+        plain.kind = gbin::FieldKind::Numeric;
+        const gbin::FieldTable t(std::vector<gbin::FieldMeta>{plain, odd, plain});
+        CHECK(same(t.meta(1), odd) && same(t.meta(2), plain) && t.kind_str(1) == "mystery");
+        CHECK(t.extents(0).empty() && t.extents(1).size() == 2 && t.extents(2).empty());
+        CHECK(t.to_fields().size() == 3);
+    }
+
     // Random-access read leaf
     {
         gbin::GbfValue vA = gbin::read_var(tmp, "A", gbin::ReadOptions{true});
@@ -229,6 +328,917 @@ int main() {
         CHECK(threw);
     }
 
+    // Every registered codec round-trips; unknown codecs are rejected cleanly.
+    {
+        for (const auto& name : gbin::codec_names()) {
+            gbin::WriteOptions wo;
+            wo.compression = gbin::CompressionMode::Always;
+            wo.codec = name;
+            gbin::write_file(tmp, root, wo);
+
+            auto [hdr, hlen, raw] = gbin::read_header_only(tmp, gbin::ReadOptions{true});
+            for (const auto& f : hdr.fields) {
+                CHECK(f.usize == 0 || f.compression == name);
+            }
+            gbin::GbfValue back = gbin::read_var(tmp, "A", gbin::ReadOptions{true});
+            CHECK(std::get<gbin::NumericArray>(back.v).real_le == std::get<gbin::NumericArray>(root.as_struct().at("A").v).real_le);
+        }
+
+        gbin::WriteOptions wo;
+        wo.codec = "no-such-codec";
+        bool threw = false;
+        try {
+            gbin::write_file(tmp, root, wo);
+        } catch (const gbin::GbfError& e) {
+            threw = (e.kind() == gbin::ErrorKind::Unsupported);
+        }
+        CHECK(threw);
+
+        // Registered codecs are never replaced, so find_codec() pointers stay valid.
+        const gbin::Codec* zlib = gbin::find_codec("zlib");
+        gbin::Codec dup = *zlib;
+        threw = false;
+        try {
+            gbin::register_codec(dup);
+        } catch (const gbin::GbfError& e) {
+            threw = (e.kind() == gbin::ErrorKind::Unsupported);
+        }
+        CHECK(threw && gbin::find_codec("zlib") == zlib);
+    }
+
+    // Adaptive compression: streamed layout is readable, levels stay in range and are recorded.
+    {
+        gbin::GbfValue::Struct big = root.as_struct();
+        for (int i = 0; i < 6; ++i) {
+            gbin::NumericArray a;
+            a.class_id = gbin::NumericClass::Double;
+            a.shape = {1, 65536};
+            std::vector<double> vals(65536);
+            for (std::size_t k = 0; k < vals.size(); ++k) vals[k] = static_cast<double>((k * (i + 1)) % 97);
+            a.real_le = as_bytes(vals);
+            big["chunk" + std::to_string(i)] = gbin::GbfValue::make_numeric(a);
+        }
+        gbin::GbfValue big_root = gbin::GbfValue::make_struct(big);
+
+        gbin::WriteOptions wo;
+        wo.zlib_level = 6;
+        wo.adaptive.enabled = true;
+        wo.adaptive.deadline_s = 1e-9; // unreachable: forces the controller to react
+        wo.adaptive.min_level = 2;
+        wo.adaptive.max_level = 7;
+        gbin::write_file(tmp, big_root, wo);
+
+        auto [hdr, hlen, raw] = gbin::read_header_only(tmp, gbin::ReadOptions{true});
+        CHECK(hdr.payload_start == 12u + hlen);
+        CHECK(hdr.file_size == std::filesystem::file_size(tmp));
+        bool any_level = false;
+        for (const auto& f : hdr.fields) {
+            if (f.compression == "zlib") {
+                CHECK(f.level >= 2 && f.level <= 7);
+                any_level = true;
+            } else {
+                CHECK(f.level == -1);
+            }
+        }
+        CHECK(any_level);
+
+        gbin::GbfValue back = gbin::read_file(tmp, gbin::ReadOptions{true});
+        CHECK(std::get<gbin::NumericArray>(back.as_struct().at("chunk5").v).real_le
+              == std::get<gbin::NumericArray>(big.at("chunk5").v).real_le);
+        CHECK(std::get<gbin::NumericArray>(back.as_struct().at("A").v).real_le
+              == std::get<gbin::NumericArray>(root.as_struct().at("A").v).real_le);
+    }
+
+    // Aligned layout: payload_start and every field start land on the boundary.
+    {
+        for (std::size_t align : {std::size_t{64}, std::size_t{4096}}) {
+            for (bool adaptive : {false, true}) {
+                gbin::WriteOptions wo;
+                wo.alignment = align;
+                wo.adaptive.enabled = adaptive;
+                gbin::write_file(tmp, root, wo);
+
+                auto [hdr, hlen, raw] = gbin::read_header_only(tmp, gbin::ReadOptions{true});
+                CHECK(hdr.payload_start == 12u + hlen);
+                CHECK(hdr.payload_start % align == 0);
+                for (const auto& f : hdr.fields) {
+                    if (f.csize > 0) CHECK((hdr.payload_start + f.offset) % align == 0);
+                }
+                gbin::GbfValue back = gbin::read_file(tmp, gbin::ReadOptions{true});
+                CHECK(std::get<gbin::NumericArray>(back.as_struct().at("A").v).real_le
+                      == std::get<gbin::NumericArray>(root.as_struct().at("A").v).real_le);
+            }
+        }
+
+        gbin::WriteOptions wo;
+        wo.alignment = 48;
+        bool threw = false;
+        try {
+            gbin::write_file(tmp, root, wo);
+        } catch (const gbin::GbfError& e) {
+            threw = (e.kind() == gbin::ErrorKind::InvalidData);
+        }
+        CHECK(threw);
+    }
+
+    // Direct I/O (or its buffered fallback) produces the same bytes and reads them back.
+    {
+        auto slurp = [](const std::filesystem::path& p) {
+            std::ifstream f(p, std::ios::binary);
+            return std::vector<char>((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+        };
+
+        gbin::write_file(tmp, root, gbin::WriteOptions{});
+        const std::vector<char> buffered = slurp(tmp);
+
+        gbin::DirectIoOptions dio;
+        dio.enabled = true;
+        dio.min_bytes = 0;
+        dio.block_bytes = 4096; // many small requests across the queue
+        dio.queue_depth = 3;
+
+        gbin::WriteOptions wo;
+        wo.direct_io = dio;
+        gbin::write_file(tmp, root, wo);
+        CHECK(slurp(tmp) == buffered);
+
+        gbin::ReadOptions ro{true};
+        ro.direct_io = dio;
+        gbin::GbfValue back = gbin::read_file(tmp, ro);
+        CHECK(std::get<gbin::StringArray>(back.as_struct().at("s").v).data
+              == std::get<gbin::StringArray>(root.as_struct().at("s").v).data);
+        gbin::GbfValue vA = gbin::read_var(tmp, "A", ro);
+        CHECK(std::get<gbin::NumericArray>(vA.v).real_le
+              == std::get<gbin::NumericArray>(root.as_struct().at("A").v).real_le);
+    }
+
+    // Header emission: names needing JSON escapes survive, and layout numbers are exact.
+    {
+        gbin::LogicalArray l;
+        l.shape = {1, 1};
+        l.data = {1};
+        const std::string odd = "q\"b\\s\t\x01\xc3\xa9";
+        gbin::WriteOptions wo;
+        wo.alignment = 64;
+        wo.header_reserve = 37;
+        gbin::write_file(tmp, gbin::GbfValue::make_struct({{odd, gbin::GbfValue::make_logical(l)}}), wo);
+
+        auto [hdr, hlen, raw] = gbin::read_header_only(tmp, gbin::ReadOptions{true});
+        CHECK(hdr.fields.size() == 1 && hdr.fields[0].name == odd);
+        CHECK(hdr.payload_start == 12 + hlen && hdr.payload_start % 64 == 0);
+        CHECK(hdr.file_size == std::filesystem::file_size(tmp));
+        CHECK(raw.find("\\u0001") != std::string::npos);
+    }
+
+    // Binary field index: same metadata as the JSON, binary-searched by read_var, and
+    // ignored (JSON fallback) when damaged or stale.
+    {
+        gbin::WriteOptions wo;
+        wo.field_index = true;
+        wo.alignment = 64;
+        gbin::write_file(tmp, root, wo);
+
+        gbin::ReadOptions json_only{true};
+        json_only.use_field_index = false;
+        auto [hdr, hlen, raw] = gbin::read_header_only(tmp, gbin::ReadOptions{true});
+        auto [jhdr, jhlen, jraw] = gbin::read_header_only(tmp, json_only);
+        CHECK(hdr.field_index.has_value() && hdr.fields.size() == jhdr.fields.size());
+        for (std::size_t i = 0; i < hdr.fields.size(); ++i) {
+            const auto& a = hdr.fields[i];
+            const auto& b = jhdr.fields[i];
+            CHECK(a.name == b.name && a.kind == b.kind && a.class_name == b.class_name && a.shape == b.shape);
+            CHECK(a.encoding == b.encoding && a.compression == b.compression && a.complex == b.complex);
+            CHECK(a.offset == b.offset && a.csize == b.csize && a.usize == b.usize && a.crc32 == b.crc32);
+        }
+        CHECK(hdr.file_size == std::filesystem::file_size(tmp));
+
+        gbin::GbfValue vA = gbin::read_var(tmp, "A", gbin::ReadOptions{true});
+        CHECK(std::get<gbin::NumericArray>(vA.v).real_le == std::get<gbin::NumericArray>(root.as_struct().at("A").v).real_le);
+        CHECK(gbin::read_file(tmp, gbin::ReadOptions{true}).as_struct().size() == root.as_struct().size());
+        bool missing = false;
+        try {
+            (void)gbin::read_var(tmp, "nope", gbin::ReadOptions{true});
+        } catch (const gbin::GbfError& e) {
+            missing = (e.kind() == gbin::ErrorKind::NotFound);
+        }
+        CHECK(missing);
+
+        // Damage the index: readers fall back to the JSON field list.
+        {
+            std::fstream f(tmp, std::ios::in | std::ios::out | std::ios::binary);
+            f.seekp(static_cast<std::streamoff>(hdr.payload_start + hdr.field_index->offset + 100));
+            f.put('\x7f');
+        }
+        CHECK(gbin::read_file(tmp, gbin::ReadOptions{true}).as_struct().size() == root.as_struct().size());
+
+        // A hostile name offset whose offset+length wraps around is rejected even under a
+        // matching index CRC.
+        {
+            gbin::write_file(tmp, root, wo);
+            std::string file;
+            {
+                std::ifstream in(tmp, std::ios::binary);
+                file.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            }
+            const std::size_t at = static_cast<std::size_t>(hdr.payload_start + hdr.field_index->offset);
+            const std::size_t size = static_cast<std::size_t>(hdr.field_index->size);
+            const std::string key = "\"index\":{\"crc32\":";
+            const std::size_t digits = file.find(key) + key.size();
+            const std::size_t ndigits = file.find(',', digits) - digits;
+            std::string crc;
+            for (std::uint32_t k = 1u << 20; crc.empty() || crc.size() > ndigits; ++k) {
+                const std::uint64_t off = ~std::uint64_t{0} - (k - 1); // off + k wraps to 0, off points before the index
+                for (int b = 0; b < 8; ++b) file[at + 56 + b] = static_cast<char>((off >> (8 * b)) & 0xFF);
+                for (int b = 0; b < 4; ++b) file[at + 64 + b] = static_cast<char>((k >> (8 * b)) & 0xFF);
+                crc = std::to_string(crc32(0L, reinterpret_cast<const Bytef*>(file.data() + at), static_cast<uInt>(size)));
+            }
+            file.replace(digits, ndigits, crc + std::string(ndigits - crc.size(), ' '));
+            // Re-seal the header CRC, which covers the JSON with its own value zeroed.
+            std::uint32_t hlen = 0;
+            std::memcpy(&hlen, file.data() + 8, 4);
+            const std::string hkey = "\"header_crc32_hex\":\"";
+            const std::size_t hex = file.find(hkey) + hkey.size();
+            file.replace(hex, 8, "00000000");
+            char sealed[9];
+            std::snprintf(sealed, sizeof(sealed), "%08lX",
+                          crc32(0L, reinterpret_cast<const Bytef*>(file.data() + 12), static_cast<uInt>(hlen)));
+            file.replace(hex, 8, sealed);
+            {
+                std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+                out.write(file.data(), static_cast<std::streamsize>(file.size()));
+            }
+            gbin::GbfValue hostile = gbin::read_var(tmp, "A", gbin::ReadOptions{true});
+            CHECK(std::get<gbin::NumericArray>(hostile.v).real_le == std::get<gbin::NumericArray>(vA.v).real_le);
+            CHECK(gbin::read_file(tmp, gbin::ReadOptions{true}).as_struct().size() == root.as_struct().size());
+        }
+
+        // Updates drop the index; compaction can rebuild it.
+        gbin::update_var(tmp, "A", root.as_struct().at("A"), gbin::WriteOptions{});
+        CHECK(!std::get<0>(gbin::read_header_only(tmp, gbin::ReadOptions{true})).field_index.has_value());
+        gbin::compact_file(tmp, wo);
+        CHECK(std::get<0>(gbin::read_header_only(tmp, gbin::ReadOptions{true})).field_index.has_value());
+        CHECK(gbin::read_var(tmp, "s", gbin::ReadOptions{true}).v.index() == root.as_struct().at("s").v.index());
+
+        // Prefix lookups take the contiguous run under "g." only.
+        wo.write_threads = 3;
+        const gbin::GbfValue leaf = root.as_struct().at("mask");
+        gbin::write_file(tmp, gbin::GbfValue::make_struct({
+            {"g", gbin::GbfValue::make_struct({{"x", leaf}, {"y", gbin::GbfValue::make_struct({{"z", leaf}})}})},
+            {"g2", leaf},
+            {"f", leaf},
+        }), wo);
+        gbin::GbfValue g = gbin::read_var(tmp, "g", gbin::ReadOptions{true});
+        CHECK(g.as_struct().size() == 2 && g.as_struct().at("y").as_struct().count("z") == 1);
+    }
+
+    // Compressed header: own magic, same JSON and CRC; updates keep the framing.
+    {
+        auto magic_of = [](const std::filesystem::path& p) {
+            std::ifstream f(p, std::ios::binary);
+            std::string m(8, '\0');
+            f.read(&m[0], 8);
+            return m;
+        };
+        for (const auto& name : gbin::codec_names()) {
+            gbin::WriteOptions wo;
+            wo.header_codec = name;
+            wo.alignment = 4096;
+            wo.field_index = true;
+            gbin::write_file(tmp, root, wo);
+            CHECK(magic_of(tmp) == std::string("GREDBIZ\0", 8));
+
+            auto [hdr, hlen, raw] = gbin::read_header_only(tmp, gbin::ReadOptions{true});
+            CHECK(hdr.header_codec == name && raw.front() == '{');
+            CHECK(hdr.payload_start == 12u + hlen && hdr.payload_start % 4096 == 0);
+            CHECK(hdr.file_size == std::filesystem::file_size(tmp));
+            CHECK(gbin::read_file(tmp, gbin::ReadOptions{true}).as_struct().size() == root.as_struct().size());
+        }
+
+        gbin::WriteOptions wo;
+        wo.header_codec = "zlib";
+        wo.write_threads = 2;
+        gbin::write_file(tmp, root, wo);
+        gbin::append_vars(tmp, gbin::GbfValue::make_struct({{"extra", root.as_struct().at("A")}}), gbin::WriteOptions{});
+        CHECK(std::get<0>(gbin::read_header_only(tmp, gbin::ReadOptions{true})).header_codec == "zlib");
+        CHECK(gbin::read_file(tmp, gbin::ReadOptions{true}).as_struct().count("extra") == 1);
+        gbin::compact_file(tmp);
+        CHECK(magic_of(tmp) == std::string("GREDBIN\0", 8));
+        CHECK(gbin::read_file(tmp, gbin::ReadOptions{true}).as_struct().count("extra") == 1);
+
+        // A damaged frame is an error, not a misread.
+        gbin::write_file(tmp, root, wo);
+        {
+            std::fstream f(tmp, std::ios::in | std::ios::out | std::ios::binary);
+            f.seekp(12 + 9 + 4 + 20);
+            f.put('\x55');
+        }
+        bool threw = false;
+        try {
+            (void)gbin::read_header_only(tmp, gbin::ReadOptions{true});
+        } catch (const gbin::GbfError&) {
+            threw = true;
+        }
+        CHECK(threw);
+
+        wo.header_codec = "no-such-codec";
+        threw = false;
+        try {
+            gbin::write_file(tmp, root, wo);
+        } catch (const gbin::GbfError& e) {
+            threw = (e.kind() == gbin::ErrorKind::Unsupported);
+        }
+        CHECK(threw);
+    }
+
+    // Parallel positional writer: same bytes as the single-stream writer.
+    {
+        auto slurp = [](const std::filesystem::path& p) {
+            std::ifstream f(p, std::ios::binary);
+            return std::vector<std::uint8_t>((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+        };
+        for (std::size_t alignment : {std::size_t{0}, std::size_t{64}}) {
+            gbin::WriteOptions wo;
+            wo.compression = gbin::CompressionMode::Always;
+            wo.alignment = alignment;
+            gbin::write_file(tmp, root, wo);
+            const std::vector<std::uint8_t> serial = slurp(tmp);
+
+            wo.write_threads = 4;
+            gbin::write_file(tmp, root, wo);
+            CHECK(slurp(tmp) == serial);
+            (void)gbin::read_file(tmp, gbin::ReadOptions{true});
+        }
+    }
+
+    // update_var: in place when it fits, appended otherwise, header relocation, compaction.
+    {
+        auto make_doubles = [](std::size_t rows, std::size_t cols, double base) {
+            gbin::NumericArray a;
+            a.class_id = gbin::NumericClass::Double;
+            a.shape = {rows, cols};
+            std::vector<double> v(rows * cols);
+            for (std::size_t i = 0; i < v.size(); ++i) v[i] = base + static_cast<double>(i);
+            a.real_le = as_bytes(v);
+            return a;
+        };
+        auto read_A = [&]() {
+            return std::get<gbin::NumericArray>(gbin::read_var(tmp, "A", gbin::ReadOptions{true}).v).real_le;
+        };
+        const auto journal = std::filesystem::path(tmp.string() + ".gbfj");
+
+        gbin::WriteOptions wo;
+        wo.compression = gbin::CompressionMode::Never;
+        wo.header_reserve = 256;
+        gbin::write_file(tmp, root, wo);
+        const auto size0 = std::filesystem::file_size(tmp);
+
+        // Same size => in place.
+        gbin::update_var(tmp, "A", gbin::GbfValue::make_numeric(make_doubles(2, 3, 100.0)), wo);
+        CHECK(std::filesystem::file_size(tmp) == size0);
+        CHECK(read_A() == make_doubles(2, 3, 100.0).real_le);
+        CHECK(!std::filesystem::exists(journal));
+
+        // Larger => appended; other fields untouched.
+        gbin::update_var(tmp, "A", gbin::GbfValue::make_numeric(make_doubles(8, 8, 7.0)), wo);
+        CHECK(std::filesystem::file_size(tmp) > size0);
+        CHECK(read_A() == make_doubles(8, 8, 7.0).real_le);
+
+        // A subtree with many leaves outgrows the reserve => header relocation.
+        gbin::GbfValue::Struct sub;
+        for (int i = 0; i < 40; ++i) sub["leaf_with_a_long_name_" + std::to_string(i)] = gbin::GbfValue::make_numeric(make_doubles(1, 4, i));
+        gbin::update_var(tmp, "mask", gbin::GbfValue::make_struct(sub), wo);
+        auto [hdr, hlen, raw] = gbin::read_header_only(tmp, gbin::ReadOptions{true});
+        CHECK(hdr.payload_start == 12u + hlen);
+        CHECK(hdr.file_size == std::filesystem::file_size(tmp));
+
+        gbin::GbfValue full = gbin::read_file(tmp, gbin::ReadOptions{true});
+        const auto& fm = full.as_struct();
+        CHECK(std::get<gbin::NumericArray>(fm.at("A").v).real_le == make_doubles(8, 8, 7.0).real_le);
+        CHECK(std::get<gbin::NumericArray>(fm.at("mask").as_struct().at("leaf_with_a_long_name_39").v).real_le
+              == make_doubles(1, 4, 39).real_le);
+        CHECK(std::get<gbin::StringArray>(fm.at("s").v).data == std::get<gbin::StringArray>(root.as_struct().at("s").v).data);
+
+        bool threw = false;
+        try {
+            gbin::update_var(tmp, "no.such.var", root, wo);
+        } catch (const gbin::GbfError& e) {
+            threw = (e.kind() == gbin::ErrorKind::NotFound);
+        }
+        CHECK(threw);
+
+        // Compaction reclaims the dead slots and keeps every value.
+        const auto before = std::filesystem::file_size(tmp);
+        gbin::compact_file(tmp);
+        CHECK(std::filesystem::file_size(tmp) < before);
+        gbin::GbfValue compacted = gbin::read_file(tmp, gbin::ReadOptions{true});
+        CHECK(std::get<gbin::NumericArray>(compacted.as_struct().at("A").v).real_le == make_doubles(8, 8, 7.0).real_le);
+        CHECK(std::get<gbin::CharArray>(compacted.as_struct().at("txt").v).utf16
+              == std::get<gbin::CharArray>(root.as_struct().at("txt").v).utf16);
+    }
+
+    // append_vars: cost is the appended payload while the header fits its reserve.
+    {
+        gbin::WriteOptions wo;
+        wo.compression = gbin::CompressionMode::Never;
+        wo.header_reserve = 1024;
+        gbin::write_file(tmp, root, wo);
+
+        for (int i = 0; i < 12; ++i) {
+            const auto before = std::filesystem::file_size(tmp);
+            gbin::LogicalArray l;
+            l.shape = {1, 100};
+            l.data.assign(100, static_cast<std::uint8_t>(i & 1));
+            gbin::GbfValue::Struct batch;
+            batch["session"] = gbin::GbfValue::make_struct({{"b" + std::to_string(i), gbin::GbfValue::make_logical(l)}});
+            gbin::append_vars(tmp, gbin::GbfValue::make_struct(batch), wo);
+            if (i == 0) CHECK(std::filesystem::file_size(tmp) == before + 100);
+        }
+
+        gbin::GbfValue back = gbin::read_file(tmp, gbin::ReadOptions{true});
+        const auto& session = back.as_struct().at("session").as_struct();
+        CHECK(session.size() == 12);
+        CHECK(std::get<gbin::LogicalArray>(session.at("b11").v).data == std::vector<std::uint8_t>(100, 1));
+        CHECK(std::get<gbin::StringArray>(back.as_struct().at("s").v).data
+              == std::get<gbin::StringArray>(root.as_struct().at("s").v).data);
+
+        bool threw = false;
+        try {
+            gbin::append_vars(tmp, gbin::GbfValue::make_struct({{"A", root.as_struct().at("A")}}), wo);
+        } catch (const gbin::GbfError& e) {
+            threw = (e.kind() == gbin::ErrorKind::InvalidData);
+        }
+        CHECK(threw);
+    }
+
+    // extend_var: slices are appended as extents, read back concatenated and merged by compaction.
+    {
+        gbin::WriteOptions wo;
+        wo.include_crc32 = true;
+        wo.header_reserve = 512;
+        gbin::write_file(tmp, root, wo);
+
+        auto cols = [](double first, std::size_t ncols) {
+            gbin::NumericArray a;
+            a.class_id = gbin::NumericClass::Double;
+            a.shape = {2, ncols};
+            std::vector<double> vals(2 * ncols);
+            for (std::size_t i = 0; i < vals.size(); ++i) vals[i] = first + static_cast<double>(i);
+            a.real_le = as_bytes(vals);
+            return gbin::GbfValue::make_numeric(a);
+        };
+        const auto before = std::filesystem::file_size(tmp);
+        wo.compression = gbin::CompressionMode::Never;
+        gbin::extend_var(tmp, "A", cols(7, 2), wo);
+        CHECK(std::filesystem::file_size(tmp) == before + 4 * sizeof(double));
+        wo.compression = gbin::CompressionMode::Always;
+        gbin::extend_var(tmp, "A", cols(11, 1), wo);
+
+        gbin::DurationArray d;
+        d.shape = {1, 2};
+        d.nan_mask = {0, 1};
+        d.ms = {4000, 0};
+        gbin::extend_var(tmp, "du", gbin::GbfValue::make_duration(d), wo);
+
+        auto check_values = [&]() {
+            auto [hdr, hlen, raw] = gbin::read_header_only(tmp, gbin::ReadOptions{true});
+            gbin::GbfValue a = gbin::read_var(tmp, "A", gbin::ReadOptions{true});
+            const auto& na = std::get<gbin::NumericArray>(a.v);
+            CHECK((na.shape == std::vector<std::size_t>{2, 6}));
+            std::vector<double> want(12);
+            for (std::size_t i = 0; i < want.size(); ++i) want[i] = static_cast<double>(i + 1);
+            CHECK(na.real_le == as_bytes(want));
+
+            gbin::GbfValue dv = gbin::read_var(tmp, "du", gbin::ReadOptions{true});
+            const auto& du = std::get<gbin::DurationArray>(dv.v);
+            CHECK((du.shape == std::vector<std::size_t>{1, 5}));
+            CHECK(du.nan_mask.back() == 1 && du.ms[3] == 4000);
+            return hdr;
+        };
+        gbin::Header hdr = check_values();
+        for (const auto& f : hdr.fields) {
+            if (f.name == "A") CHECK(f.compression == "extents" && f.extents.size() == 3);
+        }
+
+        bool bad_shape = false;
+        try {
+            gbin::NumericArray a;
+            a.class_id = gbin::NumericClass::Double;
+            a.shape = {3, 1};
+            a.real_le = as_bytes({0, 0, 0});
+            gbin::extend_var(tmp, "A", gbin::GbfValue::make_numeric(a), wo);
+        } catch (const gbin::GbfError& e) {
+            bad_shape = (e.kind() == gbin::ErrorKind::InvalidData);
+        }
+        CHECK(bad_shape);
+        bool bad_kind = false;
+        try {
+            gbin::extend_var(tmp, "s", root.as_struct().at("s"), wo);
+        } catch (const gbin::GbfError& e) {
+            bad_kind = (e.kind() == gbin::ErrorKind::Unsupported);
+        }
+        CHECK(bad_kind);
+
+        // Datetime slices must keep the field's timezone, locale and format.
+        gbin::DateTimeArray dt = std::get<gbin::DateTimeArray>(root.as_struct().at("dt").v);
+        dt.shape = {1, 1};
+        dt.nat_mask = {0};
+        dt.unix_ms = {1000};
+        gbin::extend_var(tmp, "dt", gbin::GbfValue::make_datetime(dt), wo);
+        auto rejects_dt = [&](gbin::DateTimeArray bad) {
+            try {
+                gbin::extend_var(tmp, "dt", gbin::GbfValue::make_datetime(bad), wo);
+            } catch (const gbin::GbfError& e) {
+                return e.kind() == gbin::ErrorKind::InvalidData;
+            }
+            return false;
+        };
+        gbin::DateTimeArray bad = dt;
+        bad.timezone = "Europe/Rome";
+        CHECK(rejects_dt(bad));
+        bad = dt;
+        bad.locale = "it_IT";
+        CHECK(rejects_dt(bad));
+        bad = dt;
+        bad.format = "yyyy";
+        CHECK(rejects_dt(bad));
+
+        gbin::compact_file(tmp, gbin::WriteOptions{});
+        hdr = check_values();
+        for (const auto& f : hdr.fields) CHECK(f.extents.empty());
+        const gbin::GbfValue dv = gbin::read_var(tmp, "dt", gbin::ReadOptions{true});
+        const auto& dtb = std::get<gbin::DateTimeArray>(dv.v);
+        CHECK((dtb.shape == std::vector<std::size_t>{1, 3}) && dtb.unix_ms[2] == 1000 && dtb.format == dt.format);
+    }
+
+    // Writer: reserved fields are filled through the returned span; the header grows if needed.
+    {
+        {
+            gbin::WriteOptions wo;
+            wo.include_crc32 = true;
+            gbin::Writer w(tmp, wo);
+            gbin::Span<double> a = w.reserve_numeric<double>("A", gbin::NumericClass::Double, {2, 3});
+            CHECK(a.size() == 6);
+            CHECK(reinterpret_cast<std::uintptr_t>(a.data()) % 64 == 0);
+            for (std::size_t i = 0; i < a.size(); ++i) a[i] = static_cast<double>(i + 1);
+            w.put("txt", root.as_struct().at("txt"));
+            // Enough fields that the header outgrows its initial region.
+            for (int i = 0; i < 60; ++i) {
+                auto col = w.reserve_numeric<std::int32_t>("runs.r" + std::to_string(i), gbin::NumericClass::Int32, {1, 3});
+                for (std::size_t k = 0; k < col.size(); ++k) col[k] = i * 10 + static_cast<std::int32_t>(k);
+            }
+
+            bool threw = false;
+            try {
+                (void)w.reserve_numeric<float>("bad", gbin::NumericClass::Double, {1, 1});
+            } catch (const gbin::GbfError& e) {
+                threw = (e.kind() == gbin::ErrorKind::InvalidData);
+            }
+            CHECK(threw);
+            threw = false;
+            try {
+                (void)w.reserve_numeric<float>("same_size", gbin::NumericClass::Int32, {1, 1});
+            } catch (const gbin::GbfError& e) {
+                threw = (e.kind() == gbin::ErrorKind::InvalidData);
+            }
+            CHECK(threw);
+            w.commit();
+        }
+
+        gbin::GbfValue back = gbin::read_file(tmp, gbin::ReadOptions{true});
+        const auto& m = back.as_struct();
+        CHECK(std::get<gbin::NumericArray>(m.at("A").v).real_le
+              == std::get<gbin::NumericArray>(root.as_struct().at("A").v).real_le);
+        CHECK(std::get<gbin::CharArray>(m.at("txt").v).utf16
+              == std::get<gbin::CharArray>(root.as_struct().at("txt").v).utf16);
+        const auto& r59 = std::get<gbin::NumericArray>(m.at("runs").as_struct().at("r59").v);
+        std::int32_t last = 0;
+        std::memcpy(&last, r59.real_le.data() + 8, 4);
+        CHECK(last == 592);
+
+        const auto partial = std::filesystem::temp_directory_path() / "gbin_cpp_test_partial.gbf";
+        {
+            gbin::Writer w(partial);
+            (void)w.reserve_numeric<double>("A", gbin::NumericClass::Double, {4, 4});
+        }
+        CHECK(!std::filesystem::exists(partial));
+    }
+
+    // Move-aware construction: rvalue factories adopt the buffers; complex payloads still split
+    // into real/imaginary halves on read.
+    {
+        gbin::NumericArray a;
+        a.class_id = gbin::NumericClass::Double;
+        a.shape = {3, 1};
+        a.complex = true;
+        a.real_le = as_bytes({1.0, 2.0, 3.0});
+        a.imag_le = as_bytes({-1.0, -2.0, -3.0});
+        const std::uint8_t* real_ptr = a.real_le.data();
+        const std::uint8_t* imag_ptr = a.imag_le->data();
+        gbin::GbfValue v = gbin::GbfValue::make_numeric(std::move(a));
+        const auto& moved = std::get<gbin::NumericArray>(v.v);
+        CHECK(moved.real_le.data() == real_ptr);
+        CHECK(moved.imag_le->data() == imag_ptr);
+
+        gbin::GbfValue::Struct m;
+        m["z"] = v;
+        gbin::write_file(tmp, gbin::GbfValue::make_struct(std::move(m)), gbin::WriteOptions{});
+        const gbin::GbfValue z = gbin::read_var(tmp, "z", gbin::ReadOptions{true});
+        const auto& back = std::get<gbin::NumericArray>(z.v);
+        CHECK(back.complex && back.shape == moved.shape);
+        CHECK(back.real_le == moved.real_le);
+        CHECK(back.imag_le == moved.imag_le);
+        CHECK(back.real_le.capacity() == back.real_le.size());
+
+        // A mapped payload gives back the pages its imaginary half occupied.
+        const std::size_t n = gbin::ByteBuffer::huge_bytes / sizeof(double);
+        gbin::NumericArray big;
+        big.class_id = gbin::NumericClass::Double;
+        big.shape = {n, 1};
+        big.complex = true;
+        big.real_le.resize(n * sizeof(double), 0x11);
+        big.imag_le = gbin::ByteBuffer(n * sizeof(double), 0x22);
+        gbin::WriteOptions wo;
+        wo.compression = gbin::CompressionMode::Never;
+        gbin::write_file(tmp, gbin::GbfValue::make_struct({{"big", gbin::GbfValue::make_numeric(std::move(big))}}), wo);
+        const gbin::GbfValue bv = gbin::read_var(tmp, "big", gbin::ReadOptions{true});
+        const auto& rb = std::get<gbin::NumericArray>(bv.v);
+        CHECK(rb.real_le.size() == n * sizeof(double) && rb.real_le.capacity() < 2 * rb.real_le.size());
+        CHECK(rb.real_le[rb.real_le.size() - 1] == 0x11 && (*rb.imag_le)[0] == 0x22);
+    }
+
+    // Typed spans: class-checked views over 64-byte-aligned storage; easy::make_numeric adopts
+    // the caller's vector.
+    {
+        std::vector<std::int16_t> vals = {1, -2, 3, -4, 5, -6};
+        const auto* vals_ptr = reinterpret_cast<const std::uint8_t*>(vals.data());
+        gbin::NumericArray a = gbin::easy::make_numeric({2, 3}, std::move(vals));
+        CHECK(a.class_id == gbin::NumericClass::Int16);
+        CHECK(a.real_le.data() == vals_ptr);
+        gbin::Span<std::int16_t> s = a.span<std::int16_t>();
+        CHECK(s.size() == 6 && s[1] == -2 && s[5] == -6);
+        s[0] = 7;
+
+        bool threw = false;
+        try { (void)a.span<double>(); } catch (const gbin::GbfError& e) { threw = e.kind() == gbin::ErrorKind::InvalidData; }
+        CHECK(threw);
+        threw = false;
+        try { (void)a.imag_span<std::int16_t>(); } catch (const gbin::GbfError& e) { threw = e.kind() == gbin::ErrorKind::InvalidData; }
+        CHECK(threw);
+
+        gbin::GbfValue::Struct m;
+        m["s"] = gbin::GbfValue::make_numeric(std::move(a));
+        m["c"] = gbin::GbfValue::make_numeric(gbin::easy::make_numeric_doubles({2, 1}, {0.5, 1.5}));
+        std::get<gbin::NumericArray>(m["c"].v).complex = true;
+        std::get<gbin::NumericArray>(m["c"].v).imag_le = gbin::easy::pack_le(std::vector<double>{-0.5, -1.5});
+        gbin::write_file(tmp, gbin::GbfValue::make_struct(std::move(m)), gbin::WriteOptions{});
+        const gbin::GbfValue back = gbin::read_file(tmp, gbin::ReadOptions{true});
+        const auto& bs = std::get<gbin::NumericArray>(back.as_struct().at("s").v);
+        CHECK(reinterpret_cast<std::uintptr_t>(bs.real_le.data()) % gbin::ByteBuffer::alignment == 0);
+        const gbin::Span<const std::int16_t> rs = bs.span<std::int16_t>();
+        CHECK(rs.size() == 6 && rs[0] == 7 && rs[3] == -4);
+        const auto& bc = std::get<gbin::NumericArray>(back.as_struct().at("c").v);
+        CHECK(reinterpret_cast<std::uintptr_t>(bc.imag_le->data()) % gbin::ByteBuffer::alignment == 0);
+        CHECK(bc.span<double>()[1] == 1.5 && bc.imag_span<double>()[0] == -0.5);
+    }
+
+    // ByteBuffer: uninitialized sizing, and growth past huge_bytes (mapped storage) keeps the
+    // contents and the alignment.
+    {
+        gbin::ByteBuffer b = gbin::ByteBuffer::uninitialized(100);
+        CHECK(b.size() == 100);
+        for (std::size_t i = 0; i < b.size(); ++i) b[i] = static_cast<std::uint8_t>(i);
+        b.resize_uninitialized(gbin::ByteBuffer::huge_bytes + 1);
+        CHECK(b.size() == gbin::ByteBuffer::huge_bytes + 1 && b[99] == 99);
+        CHECK(reinterpret_cast<std::uintptr_t>(b.data()) % gbin::ByteBuffer::alignment == 0);
+        b.resize(b.size() + 3);
+        CHECK(b[b.size() - 1] == 0);
+        gbin::ByteBuffer c = b;
+        CHECK(c == b);
+        b.resize(50);
+        CHECK(b.size() == 50 && b[49] == 49 && c != b);
+    }
+
+    // Dataset: flat leaves written and read without a tree, convertible to and from GbfValue.
+    {
+        gbin::Dataset ds(make_sample_root());
+        ds.add("meta.x", gbin::GbfValue::make_numeric(gbin::easy::make_numeric_doubles({1, 1}, {42.0})));
+        ds.add("meta.deep.flag", gbin::GbfValue::make_logical(gbin::LogicalArray{{1, 1}, {1}}));
+        ds.add("metadata", gbin::GbfValue::make_struct());
+        CHECK(ds.contains("A") && ds.contains("meta.x") && !ds.contains("meta"));
+        const std::size_t meta_leaves = ds.with_prefix("meta").size();
+        CHECK(meta_leaves == 2 && ds.with_prefix("").size() == ds.size());
+
+        bool threw = false;
+        try { ds.add("A", gbin::GbfValue::make_struct()); } catch (const gbin::GbfError& e) { threw = e.kind() == gbin::ErrorKind::InvalidData; }
+        CHECK(threw);
+
+        gbin::write_file(tmp, ds, gbin::WriteOptions{});
+        const gbin::Dataset back = gbin::read_file_flat(tmp, gbin::ReadOptions{true});
+        CHECK(back.size() == ds.size());
+        for (std::size_t i = 0; i < ds.size(); ++i) CHECK(back.leaves()[i].first == ds.leaves()[i].first);
+        CHECK(std::get<gbin::NumericArray>(back.at("meta.x").v).span<double>()[0] == 42.0);
+        CHECK(std::get<gbin::NumericArray>(back.at("A").v).real_le
+              == std::get<gbin::NumericArray>(ds.at("A").v).real_le);
+
+        const gbin::GbfValue tree = gbin::read_file(tmp, gbin::ReadOptions{true});
+        const gbin::GbfValue rebuilt = back.to_value();
+        CHECK(rebuilt.as_struct().size() == tree.as_struct().size());
+        CHECK(gbin::Dataset(rebuilt).with_prefix("meta").size() == meta_leaves);
+
+        threw = false;
+        try { back.at("nope"); } catch (const gbin::GbfError& e) { threw = e.kind() == gbin::ErrorKind::NotFound; }
+        CHECK(threw);
+
+        gbin::Dataset bad;
+        bad.add("p.q", gbin::GbfValue::make_struct());
+        bad.add("p", gbin::GbfValue::make_struct());
+        threw = false;
+        try { gbin::write_file(tmp, bad, gbin::WriteOptions{}); } catch (const gbin::GbfError& e) { threw = e.kind() == gbin::ErrorKind::InvalidData; }
+        CHECK(threw);
+
+        // Leaves cannot be non-empty structs (they would be written empty) or have empty segments.
+        auto rejects = [](auto&& f) {
+            try { f(); } catch (const gbin::GbfError& e) { return e.kind() == gbin::ErrorKind::InvalidData; }
+            return false;
+        };
+        const gbin::GbfValue nested = gbin::GbfValue::make_struct({{"x", ds.at("meta.x")}});
+        gbin::Dataset d2;
+        CHECK(rejects([&] { d2.add("meta", nested); }));
+        CHECK(rejects([&] { d2.set("meta", nested); }));
+        d2.add("meta", gbin::GbfValue::make_struct());
+        CHECK(rejects([&] { d2.set("meta", nested); }));
+        d2.at("meta") = nested;
+        CHECK(rejects([&] { gbin::write_file(tmp, d2, gbin::WriteOptions{}); }));
+        for (const char* path : {"a..b", ".a", "a.", ""}) {
+            CHECK(rejects([&] { d2.add(path, gbin::GbfValue::make_struct()); }));
+        }
+    }
+
+    // Columnar strings: same bytes on disk as StringArray, read back either way.
+    {
+        const gbin::GbfValue root = make_sample_root();
+        const auto& sa = std::get<gbin::StringArray>(root.as_struct().at("s").v);
+        const gbin::StringColumn col = gbin::StringColumn::from_array(sa);
+        CHECK(col.size() == 6 && col.is_missing(2) && col.view(3) == "€" && col.view(0).empty() && !col.is_missing(0));
+        CHECK(col.to_array().data == sa.data);
+
+        auto slurp = [](const std::filesystem::path& p) {
+            std::ifstream f(p, std::ios::binary);
+            return std::vector<char>(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        };
+        gbin::write_file(tmp, root, gbin::WriteOptions{});
+        const std::vector<char> from_array = slurp(tmp);
+        gbin::GbfValue::Struct m = root.as_struct();
+        m["s"] = gbin::GbfValue::make_string_column(col);
+        gbin::write_file(tmp, gbin::GbfValue::make_struct(std::move(m)), gbin::WriteOptions{});
+        CHECK(slurp(tmp) == from_array);
+
+        gbin::ReadOptions ro{true};
+        ro.columnar_strings = true;
+        const gbin::GbfValue back = gbin::read_var(tmp, "s", ro);
+        const auto& bc = std::get<gbin::StringColumn>(back.v);
+        CHECK(bc.shape == sa.shape && bc.offsets == col.offsets && bc.valid == col.valid && bc.blob == col.blob);
+        CHECK(std::get<gbin::StringArray>(gbin::read_var(tmp, "s", gbin::ReadOptions{true}).v).data == sa.data);
+    }
+
+    // Crash recovery: a complete journal rolls the file back; a torn one is discarded.
+    {
+        auto slurp = [](const std::filesystem::path& p) {
+            std::ifstream f(p, std::ios::binary);
+            return std::vector<std::uint8_t>((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+        };
+        const auto journal = std::filesystem::path(tmp.string() + ".gbfj");
+
+        gbin::write_file(tmp, root, gbin::WriteOptions{});
+        const std::vector<std::uint8_t> original = slurp(tmp);
+
+        gbin::update_var(tmp, "A", gbin::GbfValue::make_struct(), gbin::WriteOptions{});
+        CHECK(slurp(tmp) != original);
+
+        // Journal as update_var would have left it mid-way: undo = whole original content.
+        std::vector<std::uint8_t> j = {'G', 'B', 'F', 'J', 'R', 'N', 'L', 0};
+        auto put_u64 = [&](std::uint64_t v) { for (int i = 0; i < 8; ++i) j.push_back(static_cast<std::uint8_t>(v >> (8 * i))); };
+        auto put_u32 = [&](std::uint32_t v) { for (int i = 0; i < 4; ++i) j.push_back(static_cast<std::uint8_t>(v >> (8 * i))); };
+        put_u64(original.size());
+        put_u32(1);
+        put_u64(0);
+        put_u64(original.size());
+        j.insert(j.end(), original.begin(), original.end());
+        put_u32(static_cast<std::uint32_t>(::crc32(0L, j.data(), static_cast<uInt>(j.size()))));
+        {
+            std::ofstream jf(journal, std::ios::binary | std::ios::trunc);
+            jf.write(reinterpret_cast<const char*>(j.data()), static_cast<std::streamsize>(j.size() - 3)); // torn
+        }
+        const std::vector<std::uint8_t> updated = slurp(tmp);
+        CHECK(!gbin::recover_file(tmp));
+        CHECK(!std::filesystem::exists(journal));
+        CHECK(slurp(tmp) == updated);
+
+        {
+            std::ofstream jf(journal, std::ios::binary | std::ios::trunc);
+            jf.write(reinterpret_cast<const char*>(j.data()), static_cast<std::streamsize>(j.size()));
+        }
+        CHECK(gbin::recover_file(tmp));
+        CHECK(!std::filesystem::exists(journal));
+        CHECK(slurp(tmp) == original);
+        (void)gbin::read_file(tmp, gbin::ReadOptions{true});
+    }
+
+    // Sized encoders: payload sizes follow the on-disk layout exactly, including empty strings
+    // and missing elements.
+    {
+        gbin::GbfValue::Struct m;
+        m["du"] = root.as_struct().at("du");
+        m["cd"] = root.as_struct().at("cd");
+        m["cat"] = root.as_struct().at("cat");
+        m["dt"] = root.as_struct().at("dt");
+        gbin::StringArray s;
+        s.shape = {1, 3};
+        s.data = {std::string("ab"), std::nullopt, std::string()};
+        m["s"] = gbin::GbfValue::make_string(s);
+        gbin::WriteOptions wo;
+        wo.compression = gbin::CompressionMode::Never;
+        gbin::write_file(tmp, gbin::GbfValue::make_struct(m), wo);
+
+        const auto& dt = std::get<gbin::DateTimeArray>(m["dt"].v);
+        std::map<std::string, std::uint64_t> expected{
+            {"du", 3 * 9}, {"cd", 3 * 17}, {"cat", 4 + 3 * 5 + 4 * 4}, {"s", 3 * 5 + 2},
+            {"dt", 1 + 12 + dt.timezone.size() + dt.locale.size() + dt.format.size() + 2 * 9},
+        };
+        auto [hdr, hlen, raw] = gbin::read_header_only(tmp, gbin::ReadOptions{true});
+        for (const auto& f : hdr.fields) CHECK(f.usize == expected.at(f.name));
+
+        gbin::GbfValue back = gbin::read_file(tmp, gbin::ReadOptions{true});
+        CHECK(std::get<gbin::StringArray>(back.as_struct().at("s").v).data == s.data);
+        CHECK(std::get<gbin::CalendarDurationArray>(back.as_struct().at("cd").v).time_ms ==
+              std::get<gbin::CalendarDurationArray>(m["cd"].v).time_ms);
+        CHECK(std::get<gbin::CategoricalArray>(back.as_struct().at("cat").v).codes ==
+              std::get<gbin::CategoricalArray>(m["cat"].v).codes);
+        CHECK(std::get<gbin::DateTimeArray>(back.as_struct().at("dt").v).format == dt.format);
+    }
+
+    // Byte-swap kernels against a byte-reversal reference, for every element size the kernels
+    // dispatch on, at unaligned offsets and with lengths that leave SIMD tails.
+    {
+        std::mt19937 rng(49);
+        for (std::size_t elem : {1u, 2u, 3u, 4u, 8u, 16u}) {
+            for (std::size_t n : {0u, 1u, 7u, 8u, 9u, 31u, 64u, 1000u}) {
+                for (std::size_t offset = 0; offset < 4; ++offset) {
+                    std::vector<std::uint8_t> buf(offset + elem * n);
+                    for (auto& b : buf) b = static_cast<std::uint8_t>(rng());
+                    std::vector<std::uint8_t> want = buf;
+                    for (std::size_t i = 0; i < n; ++i) {
+                        auto first = want.begin() + static_cast<std::ptrdiff_t>(offset + i * elem);
+                        std::reverse(first, first + static_cast<std::ptrdiff_t>(elem));
+                    }
+                    gbin::byteswap_inplace(buf.data() + offset, elem, n);
+                    CHECK(buf == want);
+                }
+            }
+        }
+
+        const std::vector<std::uint32_t> v{0x01020304u, 0xA0B0C0D0u};
+        const gbin::ByteBuffer le = gbin::easy::pack_le(v);
+        const std::vector<std::uint8_t> expect{4, 3, 2, 1, 0xD0, 0xC0, 0xB0, 0xA0};
+        CHECK(le == gbin::ByteBuffer(expect));
+    }
+
+    // UTF-8 <-> UTF-16: ASCII runs longer than a SIMD block, 2/3/4-byte sequences (surrogate
+    // pairs), malformed input, and unpaired surrogates on the way back.
+    {
+        const std::string text = "label_0123456789_abcdefghijklmnop \xC3\xA9t\xC3\xA9 \xE2\x82\xAC "
+                                 "\xF0\x9F\x98\x80 end_of_the_ascii_tail_xyz";
+        gbin::CharArray c = gbin::CharArray::from_utf8(text);
+        CHECK(c.to_utf8() == text);
+        CHECK(c.shape == std::vector<std::size_t>({1, c.utf16.size()}));
+        const std::size_t at = text.find("\xF0");
+        const std::size_t units_before = at - 4; // two 2-byte and one 3-byte sequence before it
+        CHECK(c.utf16[units_before] == 0xD83D && c.utf16[units_before + 1] == 0xDE00);
+        CHECK(c.utf16[text.find("\xE2") - 2] == 0x20AC);
+
+        gbin::write_file(tmp, gbin::GbfValue::make_struct({{"c", gbin::GbfValue::make_char(c)}}));
+        CHECK(std::get<gbin::CharArray>(gbin::read_var(tmp, "c").v).to_utf8() == text);
+
+        CHECK(gbin::CharArray::from_utf8("").utf16.empty());
+        CHECK(gbin::easy::make_char_utf8("caf\xC3\xA9").utf16 == std::vector<std::uint16_t>({'c', 'a', 'f', 0xE9}));
+
+        for (const char* bad : {"\xC0\x80", "\x80", "ab\xE2\x82", "\xED\xA0\x80", "\xF4\x90\x80\x80",
+                                "\xE2\x28\xA1", "\xFF"}) {
+            bool threw = false;
+            try {
+                (void)gbin::CharArray::from_utf8(bad);
+            } catch (const gbin::GbfError& e) {
+                threw = e.kind() == gbin::ErrorKind::InvalidData;
+            }
+            CHECK(threw);
+        }
+
+        gbin::CharArray lone;
+        lone.shape = {1, 4};
+        lone.utf16 = {'a', 0xD800, 'b', 0xDC00};
+        CHECK(lone.to_utf8() == "a\xEF\xBF\xBD" "b\xEF\xBF\xBD");
+    }
+
     std::filesystem::remove(tmp);
     std::cout << "All tests passed.\n";
     return 0;
@@ -48,10 +48,7 @@ int main() {
         root["C"] = GbfValue::make_numeric(C);
 
         // char array "hello"
-        CharArray msg;
-        msg.shape = {1,5};
-        msg.utf16 = {(std::uint16_t)'h',(std::uint16_t)'e',(std::uint16_t)'l',(std::uint16_t)'l',(std::uint16_t)'o'};
-        root["msg"] = GbfValue::make_char(msg);
+        root["msg"] = GbfValue::make_char(CharArray::from_utf8("hello"));
 
         // Write
         WriteOptions wo;
@@ -80,7 +77,7 @@ int main() {
         GbfValue readMsg = read_var(file, "msg", ReadOptions{.validate=true});
         if (std::holds_alternative<CharArray>(readMsg.v)) {
             const auto& s = std::get<CharArray>(readMsg.v);
-            std::cout << "Read msg utf16 length=" << s.utf16.size() << "\n";
+            std::cout << "Read msg: \"" << s.to_utf8() << "\" (" << s.utf16.size() << " UTF-16 units)\n";
         }
 
         std::cout << "OK\n";
@@ -82,37 +82,6 @@ static std::string hex8(std::uint32_t v) {
     return oss.str();
 }
 
-static std::string utf16_to_utf8_lossy(const std::vector<std::uint16_t>& cu) {
-    std::string out;
-    out.reserve(cu.size());
-    std::size_t i = 0;
-    while (i < cu.size()) {
-        std::uint32_t cp = cu[i++];
-        if (cp >= 0xD800 && cp <= 0xDBFF && i < cu.size()) {
-            std::uint32_t lo = cu[i];
-            if (lo >= 0xDC00 && lo <= 0xDFFF) {
-                ++i;
-                cp = 0x10000 + (((cp - 0xD800) << 10) | (lo - 0xDC00));
-            }
-        }
-        if (cp <= 0x7F) out.push_back(static_cast<char>(cp));
-        else if (cp <= 0x7FF) {
-            out.push_back(static_cast<char>(0xC0 | ((cp >> 6) & 0x1F)));
-            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
-        } else if (cp <= 0xFFFF) {
-            out.push_back(static_cast<char>(0xE0 | ((cp >> 12) & 0x0F)));
-            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
-            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
-        } else {
-            out.push_back(static_cast<char>(0xF0 | ((cp >> 18) & 0x07)));
-            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
-            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
-            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
-        }
-    }
-    return out;
-}
-
 static void usage() {
     std::cerr <<
         "gbin (C++) - GBF/GREDBIN inspector\n"
@@ -120,7 +89,8 @@ static void usage() {
         "Usage:\n"
         "  gbin header <FILE> [--raw] [--validate] [--no-color]\n"
         "  gbin tree  <FILE> [--prefix <P>] [--max-depth N] [--details] [--validate] [--no-color]\n"
-        "  gbin show  <FILE> [<VAR>] [--max-elems N] [--rows N] [--cols N] [--stats] [--validate] [--no-color]\n";
+        "  gbin show  <FILE> [<VAR>] [--max-elems N] [--rows N] [--cols N] [--stats] [--validate] [--no-color]\n"
+        "  gbin compact <FILE> [--align N] [--reserve N]\n";
 }
 
 struct Args {
@@ -137,6 +107,8 @@ struct Args {
     std::size_t max_elems{20};
     std::size_t rows{6};
     std::size_t cols{6};
+    std::size_t align{0};
+    std::size_t reserve{0};
 };
 
 static bool parse_args(int argc, char** argv, Args& a) {
@@ -162,13 +134,15 @@ static bool parse_args(int argc, char** argv, Args& a) {
         else if (opt == "--max-elems" && i < argc) a.max_elems = static_cast<std::size_t>(std::stoull(argv[i++]));
         else if (opt == "--rows" && i < argc) a.rows = static_cast<std::size_t>(std::stoull(argv[i++]));
         else if (opt == "--cols" && i < argc) a.cols = static_cast<std::size_t>(std::stoull(argv[i++]));
+        else if (opt == "--align" && i < argc) a.align = static_cast<std::size_t>(std::stoull(argv[i++]));
+        else if (opt == "--reserve" && i < argc) a.reserve = static_cast<std::size_t>(std::stoull(argv[i++]));
         else {
             std::cerr << "Unknown option: " << opt << "\n";
             return false;
         }
     }
 
-    if (a.cmd != "header" && a.cmd != "tree" && a.cmd != "show") {
+    if (a.cmd != "header" && a.cmd != "tree" && a.cmd != "show" && a.cmd != "compact") {
         std::cerr << "Unknown command: " << a.cmd << "\n";
         return false;
     }
@@ -179,10 +153,10 @@ static bool parse_args(int argc, char** argv, Args& a) {
 
 struct TreeNode {
     std::map<std::string, TreeNode> children;
-    const gbin::FieldMeta* leaf{nullptr};
+    std::optional<std::size_t> leaf; // index into the FieldTable
 };
 
-static void tree_insert(TreeNode& root, const std::string& path, const gbin::FieldMeta* leaf) {
+static void tree_insert(TreeNode& root, const std::string& path, std::size_t leaf) {
     TreeNode* cur = &root;
     std::size_t start = 0;
     while (start <= path.size()) {
@@ -218,6 +192,7 @@ static const TreeNode* tree_find(const TreeNode& root, const std::string& prefix
 
 static void print_tree(
     const TreeNode& node,
+    const gbin::FieldTable& fields,
     const Ansi& ansi,
     std::size_t indent,
     std::size_t depth,
@@ -231,10 +206,10 @@ static void print_tree(
 
         std::string pad(indent, ' ');
         bool is_dir = !child.children.empty();
-        bool is_leaf = (child.leaf != nullptr);
+        bool is_leaf = child.leaf.has_value();
 
         if (is_leaf) {
-            const auto& f = *child.leaf;
+            const gbin::FieldMeta f = fields.meta(*child.leaf);
             std::string shape = fmt_shape_u64(f.shape);
 
             // Leaf label: show dimension + class.
@@ -245,7 +220,7 @@ static void print_tree(
 
             if (details) {
                 std::cout << " " << ansi.dim()
-                          << "kind=" << f.kind
+                          << "kind=" << f.kind_str()
                           << " complex=" << (f.complex ? "true" : "false")
                           << " comp=" << f.compression
                           << " off=" << f.offset
@@ -264,7 +239,7 @@ static void print_tree(
             std::cout << pad
                       << ansi.magenta() << name << "/" << ansi.reset()
                       << "\n";
-            print_tree(child, ansi, indent + 2, depth + 1, max_depth, details);
+            print_tree(child, fields, ansi, indent + 2, depth + 1, max_depth, details);
         }
     }
 }
@@ -614,7 +589,7 @@ static void print_value_preview(const gbin::GbfValue& v, std::size_t max_elems,
         std::cout << "char:\n";
         std::cout << "  shape=" << fmt_shape(a.shape) << "\n";
         std::cout << "  numel=" << gbin::numel(a.shape) << "\n";
-        std::string s = utf16_to_utf8_lossy(a.utf16);
+        std::string s = a.to_utf8();
         std::cout << "preview:\n";
         std::cout << "  \"" << s << "\"\n";
         return;
@@ -723,12 +698,26 @@ int main(int argc, char** argv) {
             return 0;
         }
 
+        if (a.cmd == "compact") {
+            const auto before = std::filesystem::file_size(a.file);
+            gbin::WriteOptions wo;
+            wo.alignment = a.align;
+            wo.header_reserve = a.reserve;
+            gbin::compact_file(a.file, wo);
+            const auto after = std::filesystem::file_size(a.file);
+
+            std::cout << ansi.bold() << "Compacted" << ansi.reset() << ": " << a.file << "\n";
+            std::cout << "  " << before << " -> " << after << " bytes (reclaimed "
+                      << (before > after ? before - after : 0) << ")\n";
+            return 0;
+        }
+
         if (a.cmd == "tree") {
-            auto [hdr, header_len, raw_json] = gbin::read_header_only(a.file, gbin::ReadOptions{a.validate});
+            const gbin::FieldTable fields = gbin::read_header_table(a.file, gbin::ReadOptions{a.validate}).second;
 
             TreeNode root;
-            for (const auto& f : hdr.fields) {
-                tree_insert(root, f.name, &f);
+            for (std::size_t i = 0; i < fields.size(); ++i) {
+                tree_insert(root, std::string(fields.name(i)), i);
             }
 
             const TreeNode* node = &root;
@@ -742,7 +731,29 @@ int main(int argc, char** argv) {
             }
 
             std::cout << ansi.bold() << "GBF variable tree" << ansi.reset() << ": " << a.file << "\n";
-            print_tree(*node, ansi, 0, 0, a.max_depth, a.details);
+            print_tree(*node, fields, ansi, 0, 0, a.max_depth, a.details);
+
+            if (a.details) {
+                // Totals straight from the size columns.
+                const auto& csizes = fields.csizes();
+                const auto& usizes = fields.usizes();
+                std::uint64_t stored = 0;
+                std::uint64_t raw = 0;
+                std::size_t count = 0;
+                for (std::size_t i = 0; i < fields.size(); ++i) {
+                    const std::string_view name = fields.name(i);
+                    if (!a.prefix.empty() && name != a.prefix &&
+                        !(name.size() > a.prefix.size() && name.compare(0, a.prefix.size(), a.prefix) == 0 &&
+                          name[a.prefix.size()] == '.')) {
+                        continue;
+                    }
+                    stored += csizes[i];
+                    raw += usizes[i];
+                    ++count;
+                }
+                std::cout << ansi.dim() << count << " fields, " << stored << " bytes stored, " << raw
+                          << " bytes uncompressed" << ansi.reset() << "\n";
+            }
             return 0;
         }
 
@@ -826,17 +837,17 @@ int main(int argc, char** argv) {
                     status_kv.clear();
                     if (r.node->leaf) {
                         const auto& f = *r.node->leaf;
-                        status_kv.push_back({"kind", f.kind});
-                        status_kv.push_back({"class", f.class_name});
+                        status_kv.push_back({"kind", f.kind_str()});
+                        status_kv.push_back({"class", f.class_name.str()});
                         status_kv.push_back({"shape", fmt_shape_u64(f.shape)});
                         status_kv.push_back({"complex", (f.complex ? "true" : "false")});
-                        status_kv.push_back({"comp", f.compression});
+                        status_kv.push_back({"comp", f.compression.str()});
                         status_kv.push_back({"off", std::to_string(f.offset)});
                         status_kv.push_back({"csize", std::to_string(f.csize)});
                         status_kv.push_back({"usize", std::to_string(f.usize)});
                         status_kv.push_back({"crc32", hex8(f.crc32)});
                         if (!f.encoding.empty()) {
-                            status_kv.push_back({"encoding", f.encoding});
+                            status_kv.push_back({"encoding", f.encoding.str()});
                         }
                     }
                 } catch (const std::exception& e) {
@@ -896,7 +907,7 @@ int main(int argc, char** argv) {
 
                     std::string meta;
                     if (r.is_leaf && n && n->leaf) {
-                        meta = fmt_shape_u64(n->leaf->shape) + "  " + n->leaf->class_name;
+                        meta = fmt_shape_u64(n->leaf->shape) + "  " + n->leaf->class_name.str();
                     }
 
                     Element left_txt = text(indent + glyph + name) | color(Color::Cyan) | flex;